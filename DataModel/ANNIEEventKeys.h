@@ -0,0 +1,115 @@
+// Catalogue of the keys written to ANNIEEvent BoostStores, together with the
+// C++ type stored under each one
+//
+// BoostStore (which lives in ToolDAQFramework) does not record the types of
+// the objects that it holds, so code that needs to handle every key in an
+// ANNIEEvent generically (measuring it, encoding it for another process,
+// etc.) uses the lists in this file. Whole stores are copied without them
+// (see StoreCopy.h). A visitor is any object with a member function template
+// of the form
+//
+//   template <typename T> bool visit(const std::string& key);
+//
+// that returns true if the key was present and handled. When different tools
+// write the same key with different types, the candidates are tried from the
+// widest to the narrowest, and only the first one that succeeds is used.
+//
+// Please add new keys here when a tool starts writing them to the ANNIEEvent.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+// ToolAnalysis includes
+#include "ADCPulse.h"
+#include "BeamStatus.h"
+#include "BeamStatusClass.h"
+#include "CalibratedADCWaveform.h"
+#include "ChannelKey.h"
+#include "Geometry.h"
+#include "HeftyInfo.h"
+#include "Hit.h"
+#include "LAPPDHit.h"
+#include "LAPPDPulse.h"
+#include "MinibufferLabel.h"
+#include "PackedADCPulse.h"
+#include "Particle.h"
+#include "TimeClass.h"
+#include "TriggerClass.h"
+#include "Waveform.h"
+
+/// @brief Visit every known key that may appear in an ANNIEEvent entry
+template <typename Visitor> void visit_annie_event_keys(Visitor& v) {
+
+  typedef std::map<ChannelKey, std::vector<Hit> > HitMap;
+  typedef std::map<int, std::vector< Waveform<double> > > LAPPDWaveformMap;
+
+  // Event identification. LoadWCSim writes a 64-bit EventNumber, while
+  // RawLoader writes a 32-bit one.
+  v.template visit<uint64_t>("EventNumber")
+    || v.template visit<uint32_t>("EventNumber");
+  v.template visit<uint32_t>("RunNumber");
+  v.template visit<uint32_t>("SubRunNumber");
+  v.template visit<uint32_t>("SubrunNumber");
+
+  // Raw and reconstructed PMT data
+  v.template visit< std::map<ChannelKey,
+    std::vector< Waveform<unsigned short> > > >("RawADCData");
+  v.template visit< std::map<ChannelKey,
+    std::vector< CalibratedADCWaveform<double> > > >("CalibratedADCData");
+  v.template visit<PackedADCHits::PulseMap>("RecoADCHits");
+  v.template visit<PackedADCHits>("RecoADCHitsPacked");
+  v.template visit< std::vector<MinibufferLabel> >("MinibufferLabels");
+  v.template visit< std::vector<TimeClass> >("MinibufferTimestamps");
+  v.template visit<HeftyInfo>("HeftyInfo");
+  v.template visit< std::vector<BeamStatus> >("BeamStatuses");
+
+  // Simulation
+  v.template visit< std::vector<Particle> >("MCParticles");
+  v.template visit<HitMap>("MCHits");
+  v.template visit<HitMap>("TDCData");
+  v.template visit< std::vector<TriggerClass> >("TriggerData");
+  v.template visit<TimeClass>("EventTime");
+  v.template visit<uint64_t>("MCEventNum");
+  v.template visit<uint16_t>("MCTriggernum");
+  v.template visit<std::string>("MCFile");
+  v.template visit<bool>("MCFlag");
+  v.template visit<BeamStatusClass>("BeamStatus");
+
+  // LAPPD data
+  v.template visit<LAPPDWaveformMap>("RawLAPPDData");
+  v.template visit<LAPPDWaveformMap>("rawPedData");
+  v.template visit<LAPPDWaveformMap>("FiltLAPPDData");
+  v.template visit<LAPPDWaveformMap>("BLsubtractedLAPPDData");
+  v.template visit< std::map<int, std::vector<LAPPDPulse> > >(
+    "SimpleRecoLAPPDPulses");
+  v.template visit< std::map<int, std::vector<LAPPDPulse> > >(
+    "CFDRecoLAPPDPulses");
+  v.template visit< std::map<int, std::vector<double> > >("theCharges");
+  v.template visit<double>("peakmax");
+  v.template visit<int>("maxbin");
+  v.template visit<double>("peakmin");
+  v.template visit<int>("minbin");
+  v.template visit< std::map<int, std::vector<LAPPDHit> > >("MCLAPPDHit");
+}
+
+/// @brief Visit every known key that may appear in the header of an
+/// ANNIEEvent store
+/// @details TotalEntries is managed by BoostStore itself and is not listed.
+template <typename Visitor> void visit_annie_event_header_keys(Visitor& v) {
+  v.template visit<Geometry>("AnnieGeometry");
+  v.template visit<bool>("isSim");
+  v.template visit<bool>("isFiltered");
+  v.template visit<bool>("isBLsubtracted");
+  v.template visit<bool>("isIntegrated");
+  v.template visit< std::map<int, std::map<std::string, double> > >(
+    "metaData");
+}
@@ -0,0 +1,160 @@
+// Concatenates multi-event ANNIEEvent BoostStore files into a single file
+//
+// The merger opens each input file directly and copies its entries into the
+// output store one at a time, without running any of the tools that
+// normally sit between LoadANNIEEvent and SaveANNIEEvent. Before the entries
+// of an input are copied, its header is checked against the first input:
+// the detector geometries must have the same hash. Unless disabled, the
+// RunNumber of each entry is also checked while it is copied.
+//
+// Every key of each entry (and of the header of the first input) is copied
+// byte for byte with copy_store() (see StoreCopy.h), so the values are never
+// decoded and keys that are missing from ANNIEEventKeys.h are kept. The
+// entries still pass through the gzip compression of the output file.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <exception>
+#include <string>
+
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "BoostStore.h"
+#include "Geometry.h"
+#include "StoreCopy.h"
+
+class ANNIEEventMerger {
+
+  public:
+
+    /// @param output_filename Name of the merged ANNIEEvent file
+    /// @param require_same_run Whether to reject inputs containing entries
+    /// from a different run than the first entry of the first input
+    inline ANNIEEventMerger(const std::string& output_filename,
+      bool require_same_run = true) : output_filename_(output_filename),
+      require_same_run_(require_same_run),
+      output_(false, BOOST_STORE_MULTIEVENT_FORMAT), have_header_(false),
+      geometry_hash_(0u), have_run_number_(false), run_number_(0u),
+      num_files_(0u), num_entries_(0u), incomplete_(false) {}
+
+    /// @brief Append all of the entries in an ANNIEEvent file to the output
+    /// @details An input whose header is rejected leaves the output
+    /// unchanged. An entry from another run is only found once the entries
+    /// before it have been written, so in that case incomplete() becomes
+    /// true and the merged file should not be used.
+    /// @return true if the file was merged, or false (with a description of
+    /// the problem in error) if it was rejected
+    bool AddFile(const std::string& input_filename, std::string& error) {
+
+      BoostStore input(false, BOOST_STORE_MULTIEVENT_FORMAT);
+      if ( !input.Initialise(input_filename) ) {
+        error = "could not open " + input_filename;
+        return false;
+      }
+
+      long total_entries = 0;
+      input.Header->Get("TotalEntries", total_entries);
+
+      // Check that the detector geometry matches the one already merged
+      uint64_t geometry_hash = 0u;
+      Geometry geometry;
+      if ( input.Header->Get("AnnieGeometry", geometry) ) {
+        geometry_hash = GeometryHash(geometry);
+      }
+      if ( have_header_ && geometry_hash != geometry_hash_ ) {
+        error = input_filename + " has a different detector geometry than"
+          " the files already merged";
+        input.Close();
+        return false;
+      }
+
+      // Undoes the changes made for this input if none of its entries were
+      // written
+      bool had_header = have_header_;
+      bool had_run_number = have_run_number_;
+      auto reject = [&](long entry) {
+        if ( entry > 0 ) incomplete_ = true;
+        else {
+          if (!had_header) {
+            output_.Header->Delete();
+            have_header_ = false;
+          }
+          have_run_number_ = had_run_number;
+        }
+        input.Close();
+        return false;
+      };
+
+      if (!have_header_) {
+        if ( !copy_store(*input.Header, *output_.Header) ) {
+          error = "could not copy the header of " + input_filename;
+          input.Close();
+          return false;
+        }
+        // The output store counts its own entries
+        output_.Header->Remove("TotalEntries");
+        geometry_hash_ = geometry_hash;
+        have_header_ = true;
+      }
+
+      for (long entry = 0; entry < total_entries; ++entry) {
+        input.GetEntry(entry);
+
+        uint32_t entry_run = 0u;
+        if ( require_same_run_ && input.Get("RunNumber", entry_run) ) {
+          if (!have_run_number_) {
+            run_number_ = entry_run;
+            have_run_number_ = true;
+          }
+          else if (entry_run != run_number_) {
+            error = "entry " + std::to_string(entry) + " of " + input_filename
+              + " belongs to run " + std::to_string(entry_run)
+              + " rather than run " + std::to_string(run_number_);
+            return reject(entry);
+          }
+        }
+
+        if ( !copy_store(input, output_) ) {
+          error = "could not copy entry " + std::to_string(entry) + " of "
+            + input_filename;
+          return reject(entry);
+        }
+        output_.Save(output_filename_);
+        output_.Delete();
+        ++num_entries_;
+      }
+
+      input.Close();
+      ++num_files_;
+      return true;
+    }
+
+    /// @brief Finish writing the merged file
+    inline bool Close() { return output_.Close(); }
+
+    inline uint64_t geometry_hash() const { return geometry_hash_; }
+    inline bool has_run_number() const { return have_run_number_; }
+    inline uint32_t run_number() const { return run_number_; }
+    inline size_t num_files() const { return num_files_; }
+    inline uint64_t num_entries() const { return num_entries_; }
+
+    /// @brief Whether an input was rejected after some of its entries had
+    /// been written
+    inline bool incomplete() const { return incomplete_; }
+
+  protected:
+
+    std::string output_filename_;
+    bool require_same_run_;
+    BoostStore output_;
+
+    bool have_header_;
+    uint64_t geometry_hash_;
+    bool have_run_number_;
+    uint32_t run_number_;
+
+    size_t num_files_;
+    uint64_t num_entries_;
+    bool incomplete_;
+};
@@ -1,6 +1,9 @@
 #ifndef ANNIECONSTANTS_H
 #define ANNIECONSTANTS_H
 
+// standard library includes
+#include <cmath>
+
 /// @brief The impedance (in Ohms) to assume when computing charge values for
 /// calibrated ADC hits
 constexpr double ADC_IMPEDANCE = 50.; // Ohm
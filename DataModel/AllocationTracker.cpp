@@ -0,0 +1,99 @@
+// standard library includes
+#include <map>
+#include <mutex>
+
+// ToolAnalysis includes
+#include "AllocationTracker.h"
+
+namespace {
+
+  // Slot 0 counts allocations made outside of any tool
+  const int MAX_SLOTS = 256;
+
+  struct SlotCounters {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> execute_allocations;
+    std::atomic<uint64_t> execute_bytes;
+    std::atomic<uint64_t> frees;
+    std::atomic<int64_t> live_bytes;
+    std::atomic<int64_t> peak_live_bytes;
+  };
+
+  // Zero-initialized static storage, so that the hooks can use it before
+  // any constructor has run
+  SlotCounters tool_counters[MAX_SLOTS];
+
+  std::mutex registry_mutex;
+  std::map<std::string, int>* slot_indices = nullptr;
+}
+
+std::atomic<bool> AllocationTracker::hooks_installed_(false);
+thread_local int AllocationTracker::current_slot_ = 0;
+thread_local int AllocationTracker::current_phase_ = 0;
+
+void AllocationTracker::InstallHooks() {
+  hooks_installed_ = true;
+}
+
+int AllocationTracker::RegisterTool(const std::string& key) {
+  if ( !enabled() ) return 0;
+
+  // The map's own allocations are counted outside of any tool
+  int previous = Enter(0, OTHER_PHASE);
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  if ( !slot_indices ) slot_indices = new std::map<std::string, int>;
+
+  int slot = 0;
+  auto found = slot_indices->find(key);
+  if ( found != slot_indices->end() ) slot = found->second;
+  else if ( slot_indices->size() + 1u < MAX_SLOTS ) {
+    slot = slot_indices->size() + 1u;
+    (*slot_indices)[key] = slot;
+  }
+  Leave(previous);
+  return slot;
+}
+
+bool AllocationTracker::Get(const std::string& key, AllocationStats& stats) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  if ( !slot_indices ) return false;
+  auto found = slot_indices->find(key);
+  if ( found == slot_indices->end() ) return false;
+
+  const SlotCounters& counters = tool_counters[found->second];
+  stats.allocations = counters.allocations;
+  stats.bytes = counters.bytes;
+  stats.execute_allocations = counters.execute_allocations;
+  stats.execute_bytes = counters.execute_bytes;
+  stats.frees = counters.frees;
+  stats.live_bytes = counters.live_bytes;
+  stats.peak_live_bytes = counters.peak_live_bytes;
+  return true;
+}
+
+uint32_t AllocationTracker::Allocated(size_t size) {
+  int slot = current_slot_;
+  SlotCounters& counters = tool_counters[slot];
+  counters.allocations.fetch_add(1u, std::memory_order_relaxed);
+  counters.bytes.fetch_add(size, std::memory_order_relaxed);
+  if ( current_phase_ == EXECUTE_PHASE ) {
+    counters.execute_allocations.fetch_add(1u, std::memory_order_relaxed);
+    counters.execute_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  int64_t live = counters.live_bytes.fetch_add(size,
+    std::memory_order_relaxed) + size;
+  int64_t peak = counters.peak_live_bytes.load(std::memory_order_relaxed);
+  while ( live > peak && !counters.peak_live_bytes.compare_exchange_weak(
+    peak, live, std::memory_order_relaxed) ) {}
+
+  return slot;
+}
+
+void AllocationTracker::Freed(uint32_t slot, size_t size) {
+  if ( slot >= MAX_SLOTS ) return;
+  SlotCounters& counters = tool_counters[slot];
+  counters.frees.fetch_add(1u, std::memory_order_relaxed);
+  counters.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
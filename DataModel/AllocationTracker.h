@@ -0,0 +1,113 @@
+// Heap allocations made by each tool
+//
+// The tracker is enabled at link time: building with
+//
+//   make ALLOCATION_TRACKING=1
+//
+// links src/AllocationHooks.cpp into Analyse, which replaces the global
+// operator new and operator delete with versions that call Allocated() and
+// Freed(). (Remove Analyse first if it was already built without them.) The
+// Factory then wraps each tool (see UserTools/Factory/MonitoredTool.h) so
+// that allocations made by the thread running a tool's Initialise, Execute
+// or Finalise are counted for that tool, and the ToolProfiler reports the
+// number of allocations, bytes allocated and peak live bytes of each tool.
+// Memory freed by another tool is still subtracted from the live bytes of
+// the tool that allocated it.
+//
+// Allocations made by other threads on behalf of a tool (e.g. ThreadPool
+// tasks) and over-aligned allocations are not attributed to the tool.
+#pragma once
+
+// standard library includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// @brief Allocation counts for one tool
+struct AllocationStats {
+  uint64_t allocations = 0u;
+  uint64_t bytes = 0u;
+  /// @brief The part of the above made during Execute calls
+  uint64_t execute_allocations = 0u;
+  uint64_t execute_bytes = 0u;
+  uint64_t frees = 0u;
+  /// @brief Bytes allocated by the tool and not yet freed
+  int64_t live_bytes = 0;
+  int64_t peak_live_bytes = 0;
+};
+
+class AllocationTracker {
+
+  public:
+
+    /// @brief Phase of the tool that is running on this thread
+    enum Phase { OTHER_PHASE = 0, EXECUTE_PHASE = 1 };
+
+    /// @brief Whether the operator new/delete hooks are linked in
+    static inline bool enabled() {
+      return hooks_installed_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Called by the hooks when the program starts
+    static void InstallHooks();
+
+    /// @brief Get the slot used to count the allocations of a tool,
+    /// identified by its class and configuration file. Instances with the
+    /// same key share a slot.
+    static int RegisterTool(const std::string& key);
+
+    /// @brief Get the counts of a registered tool. Returns false if the key
+    /// is unknown.
+    static bool Get(const std::string& key, AllocationStats& stats);
+
+    /// @brief Make the calling thread count its allocations for a tool.
+    /// Returns the previous slot and phase so that they can be restored.
+    static inline int Enter(int slot, Phase phase) {
+      int previous = current_slot_ | (current_phase_ << 16);
+      current_slot_ = slot;
+      current_phase_ = phase;
+      return previous;
+    }
+
+    static inline void Leave(int previous) {
+      current_slot_ = previous & 0xFFFF;
+      current_phase_ = previous >> 16;
+    }
+
+    /// @brief Record an allocation by the calling thread. Returns the slot
+    /// to store with the block.
+    static uint32_t Allocated(size_t size);
+
+    /// @brief Record that a block allocated for a slot has been freed
+    static void Freed(uint32_t slot, size_t size);
+
+  protected:
+
+    static std::atomic<bool> hooks_installed_;
+    static thread_local int current_slot_;
+    static thread_local int current_phase_;
+};
+
+/// @brief Counts the calling thread's allocations for a tool until the end
+/// of the scope
+class AllocationScope {
+
+  public:
+
+    AllocationScope(int slot, AllocationTracker::Phase phase)
+      : active_( slot > 0 ), previous_(0)
+    {
+      if (active_) previous_ = AllocationTracker::Enter(slot, phase);
+    }
+
+    ~AllocationScope() { if (active_) AllocationTracker::Leave(previous_); }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+  protected:
+
+    bool active_;
+    int previous_;
+};
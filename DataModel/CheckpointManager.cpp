@@ -0,0 +1,121 @@
+// standard library includes
+#include <cstdio>
+#include <fstream>
+
+// ToolAnalysis includes
+#include "CheckpointManager.h"
+
+namespace {
+  // First line of every checkpoint file
+  const std::string CHECKPOINT_FILE_SIGNATURE = "# ToolAnalysis checkpoint v1";
+}
+
+CheckpointManager::CheckpointManager() : enabled_(false), resumed_(false) {}
+
+bool CheckpointManager::Open(const std::string& filename, bool resume) {
+
+  filename_ = filename;
+  enabled_ = true;
+  resumed_ = false;
+  loaded_states_.clear();
+
+  if ( !resume ) return true;
+
+  std::ifstream test_file(filename_);
+  if ( !test_file.good() ) return true;
+  test_file.close();
+
+  if ( !Load() ) return false;
+  resumed_ = true;
+
+  // Restore any objects that registered before the checkpoint was opened
+  bool ok = true;
+  for (const auto& pair : objects_) {
+    auto iter = loaded_states_.find(pair.first);
+    if ( iter == loaded_states_.end() ) continue;
+    if ( !pair.second->RestoreCheckpoint(iter->second) ) ok = false;
+  }
+  return ok;
+}
+
+bool CheckpointManager::Register(const std::string& name,
+  Checkpointable* object)
+{
+  Unregister(name);
+  objects_.emplace_back(name, object);
+
+  auto iter = loaded_states_.find(name);
+  if ( iter == loaded_states_.end() ) return true;
+  return object->RestoreCheckpoint(iter->second);
+}
+
+void CheckpointManager::Unregister(const std::string& name) {
+  for (auto iter = objects_.begin(); iter != objects_.end(); ++iter) {
+    if (iter->first == name) {
+      objects_.erase(iter);
+      return;
+    }
+  }
+}
+
+bool CheckpointManager::Write() {
+
+  if ( !enabled_ ) return false;
+
+  std::vector< std::pair<std::string, CheckpointState> > states;
+  for (const auto& pair : objects_) {
+    states.emplace_back(pair.first, CheckpointState());
+    if ( !pair.second->SaveCheckpoint(states.back().second) ) return false;
+  }
+
+  // Write to a temporary file, then rename it over the old checkpoint
+  std::string temp_filename = filename_ + ".tmp";
+  {
+    std::ofstream out(temp_filename);
+    if ( !out.good() ) return false;
+
+    out << CHECKPOINT_FILE_SIGNATURE << '\n';
+    for (const auto& pair : states) {
+      out << '[' << pair.first << "]\n";
+      for (const auto& kv : pair.second.values()) {
+        out << kv.first << ' ' << kv.second << '\n';
+      }
+    }
+    out.flush();
+    if ( !out.good() ) return false;
+  }
+
+  return std::rename(temp_filename.c_str(), filename_.c_str()) == 0;
+}
+
+bool CheckpointManager::Remove() {
+  if ( !enabled_ ) return false;
+  return std::remove(filename_.c_str()) == 0;
+}
+
+bool CheckpointManager::Load() {
+
+  std::ifstream in(filename_);
+  std::string line;
+  if ( !std::getline(in, line) || line != CHECKPOINT_FILE_SIGNATURE ) {
+    return false;
+  }
+
+  CheckpointState* current_state = nullptr;
+  while ( std::getline(in, line) ) {
+    if ( line.empty() ) continue;
+    if ( line.front() == '[' && line.back() == ']' ) {
+      current_state = &loaded_states_[ line.substr(1, line.size() - 2) ];
+      continue;
+    }
+    if ( !current_state ) return false;
+
+    size_t space = line.find(' ');
+    std::string key = line.substr(0, space);
+    std::string value = (space == std::string::npos) ? ""
+      : line.substr(space + 1);
+    current_state->Set(key, value);
+  }
+
+  return true;
+}
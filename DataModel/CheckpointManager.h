@@ -0,0 +1,139 @@
+// Checkpoint and resume support for long ToolChain jobs
+//
+// Tools that can resume part-way through a job (e.g., readers that know
+// their position in the input files, or writers that know how much output
+// they have produced) inherit from Checkpointable as well as Tool, and
+// register themselves with DataModel::Checkpoints in their Initialise()
+// methods. The Checkpoint tool periodically asks every registered tool to
+// describe its state, and writes the result to a small text file. If a job
+// is restarted with the same configuration and a checkpoint file is present,
+// each tool is given back its saved state when it registers.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// @brief Key/value description of the state of a single tool
+/// @details Keys may not contain whitespace, and values may not contain
+/// newlines.
+class CheckpointState {
+
+  public:
+
+    template <typename T> void Set(const std::string& key, const T& value) {
+      std::ostringstream out;
+      out.precision( std::numeric_limits<double>::max_digits10 );
+      out << value;
+      values_[key] = out.str();
+    }
+
+    template <typename T> bool Get(const std::string& key, T& value) const {
+      auto iter = values_.find(key);
+      if ( iter == values_.end() ) return false;
+      std::istringstream in(iter->second);
+      in >> value;
+      return !in.fail();
+    }
+
+    inline bool Has(const std::string& key) const
+      { return values_.count(key); }
+
+    inline void Clear() { values_.clear(); }
+
+    inline const std::map<std::string, std::string>& values() const
+      { return values_; }
+
+  protected:
+
+    std::map<std::string, std::string> values_;
+};
+
+template <> inline void CheckpointState::Set<std::string>(
+  const std::string& key, const std::string& value)
+{
+  values_[key] = value;
+}
+
+template <> inline bool CheckpointState::Get<std::string>(
+  const std::string& key, std::string& value) const
+{
+  auto iter = values_.find(key);
+  if ( iter == values_.end() ) return false;
+  value = iter->second;
+  return true;
+}
+
+/// @brief Interface for objects (usually tools) whose state can be saved to
+/// and restored from a checkpoint
+class Checkpointable {
+
+  public:
+
+    virtual ~Checkpointable() {}
+
+    /// @brief Describe the state needed to resume after the last completed
+    /// event. Tools should also flush any output that must survive a crash
+    /// here.
+    virtual bool SaveCheckpoint(CheckpointState& state) = 0;
+
+    /// @brief Restore the state saved by SaveCheckpoint()
+    virtual bool RestoreCheckpoint(const CheckpointState& state) = 0;
+};
+
+/// @brief Collects the state of all registered Checkpointable objects and
+/// reads and writes checkpoint files
+class CheckpointManager {
+
+  public:
+
+    CheckpointManager();
+
+    /// @brief Start checkpointing to the given file. If resume is true and
+    /// the file exists, its contents are loaded and handed to the objects
+    /// that are (or will be) registered under the same names.
+    /// @return false if an existing checkpoint file could not be read
+    bool Open(const std::string& filename, bool resume);
+
+    /// @brief Register an object whose state should be checkpointed
+    /// @return false if saved state was found for the object but could not
+    /// be restored
+    bool Register(const std::string& name, Checkpointable* object);
+
+    /// @brief Remove a previously registered object
+    void Unregister(const std::string& name);
+
+    /// @brief Save the state of every registered object to the checkpoint
+    /// file. The file is replaced atomically, so an interrupted write leaves
+    /// the previous checkpoint intact.
+    bool Write();
+
+    /// @brief Delete the checkpoint file, e.g., once a job has finished
+    bool Remove();
+
+    /// @brief Whether Open() has been called
+    inline bool enabled() const { return enabled_; }
+
+    /// @brief Whether a checkpoint file was loaded by Open()
+    inline bool resumed() const { return resumed_; }
+
+    inline const std::string& filename() const { return filename_; }
+
+  protected:
+
+    bool Load();
+
+    bool enabled_;
+    bool resumed_;
+    std::string filename_;
+
+    /// @brief Registered objects, in registration order
+    std::vector< std::pair<std::string, Checkpointable*> > objects_;
+
+    /// @brief State loaded from the checkpoint file (indexed by name)
+    std::map<std::string, CheckpointState> loaded_states_;
+};
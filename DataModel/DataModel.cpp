@@ -1,6 +1,38 @@
+#include <stdexcept>
+
 #include "DataModel.h"
 
-DataModel::DataModel(){}
+DataModel::DataModel() : m_geometry_hash(0) {}
+
+bool DataModel::UpdateGeometry(const Geometry& geom){
+
+  uint64_t hash = GeometryHash(geom);
+  if (m_geometry && hash == m_geometry_hash) return false;
+
+  // The counts are filled in before the copy is shared, since it is const
+  // from then on
+  std::shared_ptr<Geometry> copy = std::make_shared<Geometry>(geom);
+  copy->CountDetectors();
+  m_geometry = copy;
+  m_geometry_hash = hash;
+
+  return true;
+}
+
+void DataModel::CheckHandleType(const std::string& label,
+  const std::type_info& type){
+
+#ifndef NDEBUG
+  auto iter = m_handle_types.find(label);
+  if (iter == m_handle_types.end()) m_handle_types.emplace(label, type);
+  else if (iter->second != std::type_index(type)) {
+    throw std::runtime_error("StoreHandle type mismatch for " + label
+      + ": requested " + type.name() + " but an existing handle uses "
+      + iter->second.name());
+  }
+#endif
+
+}
 
 /*
 TTree* DataModel::GetTTree(std::string name){
@@ -2,7 +2,10 @@
 #define DATAMODEL_H
 
 #include <map>
+#include <memory>
 #include <string>
+#include <typeindex>
+#include <typeinfo>
 #include <vector>
 #include <stdlib.h>
 
@@ -17,6 +20,7 @@
 #include "BeamStatusClass.h"
 #include "BeamStatus.h"
 #include "ChannelKey.h"
+#include "CheckpointManager.h"
 #include "Detector.h"
 #include "Direction.h"
 #include "Geometry.h"
@@ -25,6 +29,9 @@
 #include "Particle.h"
 #include "LAPPDHit.h"
 #include "Position.h"
+#include "RandomStreams.h"
+#include "StoreHandle.h"
+#include "ThreadPool.h"
 #include "TimeClass.h"
 #include "TriggerClass.h"
 #include "Waveform.h"
@@ -49,9 +56,60 @@ class DataModel {
   Logging *Log;
   zmq::context_t* context;
 
+  // Tools that can resume a job part-way through register here (see
+  // CheckpointManager.h and the Checkpoint tool)
+  CheckpointManager Checkpoints;
+
+  // Thread pool for splitting up the work within an event (see
+  // ThreadPool.h). A single pool is shared by every DataModel in the
+  // process, sized by ThreadPoolSize in the ToolChainConfig file.
+  ThreadPool& Pool() {return ThreadPool::Shared();}
+
+  // Reproducible random numbers for a given event, tool and purpose (see
+  // RandomStreams.h). The numbers do not depend on the number of threads
+  // or shards, or on the order in which events are processed.
+  CounterRNG RandomStream(uint64_t run, uint64_t event,
+    const std::string& tool, const std::string& purpose) const
+  {
+    return RandomStreams::Stream(run, event, tool, purpose);
+  }
+
+  // Detector geometry shared by all tools. Loader tools call UpdateGeometry
+  // once per input file; the stored copy is only replaced (and the hash
+  // changed) when the new geometry differs. Tools keep the const pointer and
+  // only refresh it when GetGeometryHash() changes.
+  bool UpdateGeometry(const Geometry& geom);
+  const Geometry* GetGeometry() const {return m_geometry.get();}
+  std::shared_ptr<const Geometry> GetSharedGeometry() const {return m_geometry;}
+  uint64_t GetGeometryHash() const {return m_geometry_hash;}
+
+  // Returns a typed handle to a key in one of the Stores. Create handles once
+  // in Initialise() and use them on every Execute().
+  template <typename T> StoreHandle<T> Handle(const std::string& store_name,
+    const std::string& key)
+  {
+    CheckHandleType(store_name + '/' + key, typeid(T));
+    return StoreHandle<T>(Stores, store_name, key);
+  }
+
+  // Returns a typed handle to a key in the CStore
+  template <typename T> StoreHandle<T> CStoreHandle(const std::string& key)
+  {
+    CheckHandleType("CStore/" + key, typeid(T));
+    return StoreHandle<T>(CStore, key);
+  }
+
 
  private:
 
+  // Debug builds (NDEBUG not defined) throw if two handles to the same key
+  // are created with different types
+  void CheckHandleType(const std::string& label, const std::type_info& type);
+  std::map<std::string, std::type_index> m_handle_types;
+
+  std::shared_ptr<const Geometry> m_geometry;
+  uint64_t m_geometry_hash;
+
 
 
   //std::map<std::string,TTree*> m_trees;
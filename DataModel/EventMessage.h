@@ -0,0 +1,208 @@
+// Serialized events sent between ToolChain processes over ZeroMQ
+//
+// Each event store is archived whole (see StoreCopy.h), so every key is sent
+// byte for byte without being decoded, whatever its type. A store's header
+// is only sent when it differs from the one last sent to the same process.
+// The archives are written into a single byte string, and the receiving
+// process restores them into its own stores. Boost binary archives are
+// used, so both ends must be built for the same architecture.
+//
+// Messages are sent as multipart ZeroMQ messages. An event is made of the
+// frames
+//
+//   "EVENT" | "<sequence number> <1 if last event, else 0>" | <stores>
+//
+// and the helpers below send and receive lists of frames.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+// ZeroMQ includes
+#include <zmq.hpp>
+
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "BoostStore.h"
+#include "StoreCopy.h"
+
+/// @brief Serialize the named stores and, when they have changed, their
+/// headers
+/// @param header_hashes Hash of the header last sent for each store, which
+/// is updated when a header is sent
+/// @param[out] bytes The serialized stores
+/// @return false if a store could not be archived
+inline bool encode_event_stores(std::map<std::string, BoostStore*>& stores,
+  const std::vector<std::string>& store_names,
+  std::map<std::string, uint64_t>& header_hashes, std::string& bytes,
+  std::string& error)
+{
+  try {
+    std::ostringstream out;
+    boost::archive::binary_oarchive oa(out, boost::archive::no_header);
+
+    uint32_t num_stores = 0u;
+    for (const auto& name : store_names) {
+      auto iter = stores.find(name);
+      if ( iter != stores.end() && iter->second ) ++num_stores;
+    }
+    oa & num_stores;
+
+    std::string archive, header_archive;
+    for (const auto& name : store_names) {
+      auto iter = stores.find(name);
+      if ( iter == stores.end() || !iter->second ) continue;
+      BoostStore& store = *iter->second;
+
+      if ( !archive_store(store, archive) ) {
+        error = "the store " + name + " could not be archived";
+        return false;
+      }
+
+      bool has_header = false;
+      header_archive.clear();
+      if ( store.Header ) {
+        if ( !archive_store(*store.Header, header_archive) ) {
+          error = "the header of store " + name + " could not be archived";
+          return false;
+        }
+        uint64_t hash = archive_hash(header_archive);
+        auto sent = header_hashes.find(name);
+        has_header = ( sent == header_hashes.end() || sent->second != hash );
+        if (has_header) header_hashes[name] = hash;
+        else header_archive.clear();
+      }
+
+      std::string store_name = name;
+      oa & store_name & archive & has_header & header_archive;
+    }
+    out.flush();
+    bytes = out.str();
+  }
+  catch (const std::exception& e) {
+    error = e.what();
+    return false;
+  }
+  return true;
+}
+
+/// @brief Replace the contents of the stores with a serialized event. Stores
+/// that do not exist yet are created. Headers are only replaced when the
+/// event contains them.
+/// @param[out] has_geometry Whether a header with an AnnieGeometry key was
+/// received
+inline bool decode_event_stores(const std::string& bytes,
+  std::map<std::string, BoostStore*>& stores, bool& has_geometry,
+  std::string& error)
+{
+  has_geometry = false;
+  try {
+    std::istringstream in(bytes);
+    boost::archive::binary_iarchive ia(in, boost::archive::no_header);
+
+    uint32_t num_stores = 0u;
+    ia & num_stores;
+    std::string archive, header_archive;
+    for (uint32_t s = 0; s < num_stores; ++s) {
+      std::string name;
+      bool has_header = false;
+      ia & name & archive & has_header & header_archive;
+
+      BoostStore*& store = stores[name];
+      if ( !store ) store = new BoostStore(false,
+        BOOST_STORE_MULTIEVENT_FORMAT);
+
+      if ( !restore_store(archive, *store) ) {
+        error = "the store " + name + " could not be read";
+        return false;
+      }
+
+      if ( !has_header || !store->Header ) continue;
+      if ( !restore_store(header_archive, *store->Header) ) {
+        error = "the header of store " + name + " could not be read";
+        return false;
+      }
+      if ( store->Header->Has("AnnieGeometry") ) has_geometry = true;
+    }
+  }
+  catch (const std::exception& e) {
+    error = e.what();
+    return false;
+  }
+  return true;
+}
+
+/// @brief Split a comma-separated list of store names
+inline std::vector<std::string> split_store_names(const std::string& list) {
+  std::vector<std::string> names;
+  std::istringstream in(list);
+  std::string name;
+  while ( std::getline(in, name, ',') ) {
+    if ( !name.empty() ) names.push_back(name);
+  }
+  return names;
+}
+
+/// @brief Format the sequence frame of an event message
+inline std::string event_sequence_frame(uint64_t sequence_number, bool last) {
+  return std::to_string(sequence_number) + (last ? " 1" : " 0");
+}
+
+/// @brief Parse the sequence frame of an event message
+inline bool parse_event_sequence_frame(const std::string& frame,
+  uint64_t& sequence_number, bool& last)
+{
+  std::istringstream in(frame);
+  int last_flag = 0;
+  if ( !(in >> sequence_number >> last_flag) ) return false;
+  last = (last_flag != 0);
+  return true;
+}
+
+/// @brief Send a multipart message
+inline bool send_frames(zmq::socket_t& socket,
+  const std::vector<std::string>& frames)
+{
+  for (size_t f = 0; f < frames.size(); ++f) {
+    zmq::message_t message( frames.at(f).size() );
+    if ( !frames.at(f).empty() ) {
+      frames.at(f).copy(static_cast<char*>( message.data() ),
+        frames.at(f).size());
+    }
+    int flags = (f + 1 < frames.size()) ? ZMQ_SNDMORE : 0;
+    if ( !socket.send(message, flags) ) return false;
+  }
+  return true;
+}
+
+/// @brief Wait for a multipart message
+/// @param timeout_ms How long to wait, or -1 to wait forever
+/// @return false if no message arrived in time
+inline bool receive_frames(zmq::socket_t& socket,
+  std::vector<std::string>& frames, long timeout_ms)
+{
+  zmq::pollitem_t item = { static_cast<void*>(socket), 0, ZMQ_POLLIN, 0 };
+  zmq::poll(&item, 1, timeout_ms);
+  if ( !(item.revents & ZMQ_POLLIN) ) return false;
+
+  frames.clear();
+  int more = 1;
+  while (more) {
+    zmq::message_t message;
+    if ( !socket.recv(&message) ) return false;
+    frames.emplace_back( static_cast<const char*>( message.data() ),
+      message.size() );
+    size_t more_size = sizeof(more);
+    socket.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+  }
+  return true;
+}
@@ -0,0 +1,82 @@
+// Archived contents of the event stores, used to hand an event from one
+// thread to another
+//
+// Each store is written with archive_store() (see StoreCopy.h), which copies
+// every key byte for byte without decoding it, whatever its type. The
+// payload owns the archives, so it can be moved between threads (e.g.,
+// through a queue) without any further copies, and applied later to the
+// stores of a different DataModel.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+// ToolAnalysis includes
+#include "BoostStore.h"
+#include "Geometry.h"
+#include "StoreCopy.h"
+
+/// @brief The archived contents of one event
+struct EventPayload {
+
+  /// @brief Archives of a single store
+  struct StoreContents {
+    std::string archive;
+    /// @brief Whether the header is included. It is left out while it is
+    /// the same as in the previous event.
+    bool has_header = false;
+    std::string header_archive;
+  };
+
+  /// @brief Position of the event in the input
+  uint64_t sequence_number = 0u;
+
+  /// @brief Contents of each store, indexed by store name
+  std::map<std::string, StoreContents> stores;
+
+  /// @brief Shared detector geometry that was current for this event
+  std::shared_ptr<const Geometry> geometry;
+  uint64_t geometry_hash = 0u;
+
+  /// @brief Archive a store and its header
+  /// @param last_header Header archive of the previous event, which is
+  /// replaced when the header has changed
+  /// @return false if the store could not be archived
+  inline bool capture_store(const std::string& name, const BoostStore& store,
+    std::string& last_header)
+  {
+    StoreContents& contents = stores[name];
+    if ( !archive_store(store, contents.archive) ) return false;
+
+    if ( !store.Header ) return true;
+    if ( !archive_store(*store.Header, contents.header_archive) ) return false;
+    if ( contents.header_archive == last_header ) {
+      contents.header_archive.clear();
+    }
+    else {
+      last_header = contents.header_archive;
+      contents.has_header = true;
+    }
+    return true;
+  }
+
+  /// @brief Replace the contents of a store (and of its header, if it has
+  /// changed) with the archived ones. A store missing from the payload is
+  /// emptied.
+  /// @return false if the archives could not be read
+  inline bool apply_store(const std::string& name, BoostStore& store) const {
+    auto iter = stores.find(name);
+    if ( iter == stores.end() ) {
+      store.Delete();
+      return true;
+    }
+    if ( !restore_store(iter->second.archive, store) ) return false;
+    if ( store.Header && iter->second.has_header ) {
+      return restore_store(iter->second.header_archive, *store.Header);
+    }
+    return true;
+  }
+};
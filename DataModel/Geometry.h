@@ -2,7 +2,12 @@
 #ifndef GEOMETRYCLASS_H
 #define GEOMETRYCLASS_H
 
+#include <cstdint>
+#include <sstream>
+#include <string>
+
 #include<SerialisableObject.h>
+#include <boost/archive/binary_oarchive.hpp>
 #include "ChannelKey.h"
 #include "Detector.h"
 #include "Particle.h"
@@ -16,23 +21,23 @@ class Geometry : public SerialisableObject{
 	friend class boost::serialization::access;
 	
 	public:
-  Geometry() : Detectors(std::map<ChannelKey,Detector>{}), Version(0.), tank_radius(0.), tank_halfheight(0.), mrd_width(0.), mrd_height(0.), mrd_depth(0.), mrd_start(0.), numtankpmts(0), nummrdpmts(0), numvetopmts(0), numlappds(0), Status(detectorstatus::OFF) {serialise=true;}
+  Geometry() : Detectors(std::map<ChannelKey,Detector>{}), Version(0.), tank_radius(0.), tank_halfheight(0.), mrd_width(0.), mrd_height(0.), mrd_depth(0.), mrd_start(0.), numtankpmts(0), nummrdpmts(0), numvetopmts(0), numlappds(0), Status(detectorstatus::OFF) {serialise=true; CountDetectors();}
 	
 	Geometry(std::map<ChannelKey,Detector> dets, double ver, double tankr, double tankhh, double mrdw, double mrdh, double mrdd, double mrds, int ntankpmts, int nmrdpmts, int nvetopmts, int nlappds, detectorstatus statin)
-	  : Detectors(dets), Version(ver), tank_radius(tankr), tank_halfheight(tankhh), mrd_width(mrdw), mrd_height(mrdh), mrd_depth(mrdd), mrd_start(mrds), numtankpmts(ntankpmts), nummrdpmts(nmrdpmts), numvetopmts(nvetopmts), numlappds(nlappds), Status(statin) {serialise=true;}
+	  : Detectors(dets), Version(ver), tank_radius(tankr), tank_halfheight(tankhh), mrd_width(mrdw), mrd_height(mrdh), mrd_depth(mrdd), mrd_start(mrds), numtankpmts(ntankpmts), nummrdpmts(nmrdpmts), numvetopmts(nvetopmts), numlappds(nlappds), Status(statin) {serialise=true; CountDetectors();}
 	
 	inline std::map<ChannelKey,Detector>* GetDetectors(){return &Detectors;}
-	inline double GetVersion(){return Version;}
-	inline detectorstatus GetStatus(){return Status;}
-	inline double GetTankRadius(){return tank_radius;}
-	inline double GetTankHalfheight(){return tank_halfheight;}
-	inline double GetMrdWidth(){return mrd_width;}
-	inline double GetMrdHeight(){return mrd_height;}
-	inline double GetMrdDepth(){return mrd_depth;}
-	inline double GetMrdStart(){return mrd_start;}
-	inline double GetMrdEnd(){return mrd_start+mrd_depth;}
-	
-	inline void SetDetectors(std::map<ChannelKey,Detector> DetectorsIn){Detectors = DetectorsIn;}
+	inline double GetVersion() const {return Version;}
+	inline detectorstatus GetStatus() const {return Status;}
+	inline double GetTankRadius() const {return tank_radius;}
+	inline double GetTankHalfheight() const {return tank_halfheight;}
+	inline double GetMrdWidth() const {return mrd_width;}
+	inline double GetMrdHeight() const {return mrd_height;}
+	inline double GetMrdDepth() const {return mrd_depth;}
+	inline double GetMrdStart() const {return mrd_start;}
+	inline double GetMrdEnd() const {return mrd_start+mrd_depth;}
+	
+	inline void SetDetectors(std::map<ChannelKey,Detector> DetectorsIn){Detectors = DetectorsIn; ResetCounts();}
 	inline void SetVersion(double VersionIn){Version = VersionIn;}
 	inline void SetStatus(detectorstatus StatusIn){Status = StatusIn;}
 	inline void SetTankRadius(double tank_radiusIn){tank_radius = tank_radiusIn;}
@@ -44,9 +49,10 @@ class Geometry : public SerialisableObject{
 	
 	inline void AddDetector(ChannelKey key, Detector det){
 		Detectors.emplace(key,det);
+		ResetCounts();
 	}
 	
-	/*const */Detector GetDetector(ChannelKey key){
+	/*const */Detector GetDetector(ChannelKey key) const {
 		if(Detectors.count(key)==0) return Detector{};
 		return Detectors.at(key);
 	}
@@ -58,49 +64,49 @@ class Geometry : public SerialisableObject{
 		return (*el);
 	}
 	
-	inline int GetNumDetectors(){return Detectors.size();}
+	inline int GetNumDetectors() const {return Detectors.size();}
 	
-	int GetNumTankPMTs(){
-		if(numtankpmts!=0) return numtankpmts;
-		for(auto adet : Detectors){
-			ChannelKey chankey = adet.first; // subdetector 1 is ADC
-			if(chankey.GetSubDetectorType()==subdetector::ADC) numtankpmts++;
-		}
-		return numtankpmts;
-	}
+	inline int GetNumTankPMTs() const {return numtankpmts;}
+	inline int GetNumMrdPMTs() const {return nummrdpmts;}
+	inline int GetNumVetoPMTs() const {return numvetopmts;}
+	inline int GetNumLAPPDs() const {return numlappds;}
 	
-	int GetNumMrdPMTs(){
-		if(nummrdpmts!=0) return nummrdpmts;
-		for(auto&& adet : Detectors){
-			ChannelKey chankey = adet.first; // subdetector 0 is TDC...
-			if(chankey.GetSubDetectorType()==subdetector::TDC){
-				if( true /*FIXME*/ ) nummrdpmts++;
+	// Counts the detectors of each kind, for the counts that were not given
+	// to the constructor. The counts are kept up to date by the constructors,
+	// AddDetector, SetDetectors and loading, so that the const getters never
+	// write to a Geometry that may be shared between threads.
+	void CountDetectors(){
+		if(numtankpmts==0){
+			for(auto&& adet : Detectors){
+				ChannelKey chankey = adet.first; // subdetector 1 is ADC
+				if(chankey.GetSubDetectorType()==subdetector::ADC) numtankpmts++;
 			}
 		}
-		nummrdpmts -= 26; // FIXME
-		return nummrdpmts;
-	}
-	
-	// XXX how do we distinguish MRD vs Veto channels?
-	int GetNumVetoPMTs(){
-		if(numvetopmts!=0) return numvetopmts;
-//		for(auto&& adet : Detectors){
-//			ChannelKey chankey = adet.first; // subdetector 0 is TDC...
-//			if(chankey.GetSubDetectorType()==subdetector::TDC){
-//				if( false /*FIXME*/ ) numvetopmts++;
+		if(nummrdpmts==0){
+			for(auto&& adet : Detectors){
+				ChannelKey chankey = adet.first; // subdetector 0 is TDC...
+				if(chankey.GetSubDetectorType()==subdetector::TDC){
+					if( true /*FIXME*/ ) nummrdpmts++;
+				}
+			}
+			nummrdpmts -= 26; // FIXME
+		}
+		// XXX how do we distinguish MRD vs Veto channels?
+		if(numvetopmts==0){
+//			for(auto&& adet : Detectors){
+//				ChannelKey chankey = adet.first; // subdetector 0 is TDC...
+//				if(chankey.GetSubDetectorType()==subdetector::TDC){
+//					if( false /*FIXME*/ ) numvetopmts++;
+//				}
 //			}
-//		}
-		numvetopmts=26;  // FIXME
-		return numvetopmts;
-	}
-	int GetNumLAPPDs(){
-		// FIXME this will be inefficient if num lappds are actually 0!
-		if(numlappds!=0) return numlappds;
-		for(auto&& adet : Detectors){
-			ChannelKey chankey = adet.first; // subdetector 2 is LAPPDs...
-			if(chankey.GetSubDetectorType()==subdetector::LAPPD) numlappds++;
+			numvetopmts=26;  // FIXME
+		}
+		if(numlappds==0){
+			for(auto&& adet : Detectors){
+				ChannelKey chankey = adet.first; // subdetector 2 is LAPPDs...
+				if(chankey.GetSubDetectorType()==subdetector::LAPPD) numlappds++;
+			}
 		}
-		return numlappds;
 	}
 	
 	bool GetTankContained(Particle part){
@@ -157,6 +163,15 @@ class Geometry : public SerialisableObject{
 	int numvetopmts;
 	int numlappds;
 	
+	// Recount every kind of detector after the detectors have changed
+	void ResetCounts(){
+		numtankpmts=0;
+		nummrdpmts=0;
+		numvetopmts=0;
+		numlappds=0;
+		CountDetectors();
+	}
+	
 	template<class Archive> void serialize(Archive & ar, const unsigned int version){
 		if(serialise){
 			ar & Detectors;
@@ -168,8 +183,27 @@ class Geometry : public SerialisableObject{
 			ar & mrd_height;
 			ar & mrd_depth;
 			ar & mrd_start;
+			// the counts are not archived, so count the loaded detectors
+			if(Archive::is_loading::value) ResetCounts();
 		}
 	}
 };
 
+// 64-bit FNV-1a hash of the serialized Geometry. Used to tell whether the
+// geometry in a newly opened file differs from the one already in use.
+inline uint64_t GeometryHash(const Geometry& geom){
+	std::ostringstream stream;
+	{
+		boost::archive::binary_oarchive oa(stream, boost::archive::no_header);
+		oa << geom;
+	}
+	const std::string bytes = stream.str();
+	uint64_t hash = 14695981039346656037ull;
+	for(unsigned char c : bytes){
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
 #endif
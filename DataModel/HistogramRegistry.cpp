@@ -0,0 +1,69 @@
+// standard library includes
+#include <atomic>
+#include <utility>
+
+// ToolAnalysis includes
+#include "HistogramRegistry.h"
+#include "ROOTTreeOutput.h"
+
+namespace {
+
+  std::atomic<uint64_t> next_registry_serial_number(0u);
+
+  // The clones used by the current thread in each registry that it has
+  // filled, keyed by the registry's serial number. Serial numbers are never
+  // reused, so entries left behind by deleted registries are never matched.
+  thread_local std::vector< std::pair<uint64_t, void*> > thread_clones;
+
+  // Creating histograms touches ROOT's global state
+  std::mutex clone_mutex;
+}
+
+HistogramRegistry::HistogramRegistry()
+  : serial_number_(next_registry_serial_number++),
+  owner_( std::this_thread::get_id() )
+{}
+
+HistogramRegistry::~HistogramRegistry() {}
+
+TH1* HistogramRegistry::LocalClone(size_t index) {
+
+  ThreadClones* local = nullptr;
+  for (const auto& entry : thread_clones) {
+    if ( entry.first == serial_number_ ) {
+      local = static_cast<ThreadClones*>(entry.second);
+      break;
+    }
+  }
+
+  if ( !local ) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.emplace_back( new ThreadClones );
+    local = threads_.back().get();
+    thread_clones.emplace_back(serial_number_, local);
+  }
+
+  if ( index >= local->clones.size() ) local->clones.resize(index + 1u);
+  std::unique_ptr<TH1>& clone = local->clones[index];
+  if ( !clone ) {
+    enable_root_thread_safety();
+    std::lock_guard<std::mutex> lock(clone_mutex);
+    TH1* registered = histograms_.at(index);
+    clone.reset( static_cast<TH1*>( registered->Clone() ) );
+    clone->SetDirectory(nullptr);
+    clone->Reset();
+  }
+  return clone.get();
+}
+
+void HistogramRegistry::Merge() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& thread : threads_) {
+    for (size_t h = 0; h < thread->clones.size(); ++h) {
+      TH1* clone = thread->clones[h].get();
+      if ( !clone || clone->GetEntries() == 0. ) continue;
+      histograms_.at(h)->Add(clone);
+      clone->Reset();
+    }
+  }
+}
@@ -0,0 +1,126 @@
+// Per-thread copies of a tool's histograms, merged on request
+//
+// A tool registers each of its histograms once (usually in Initialise) and
+// keeps the returned HistogramHandle. Filling through the handle on the
+// thread that registered the histogram fills the histogram itself, so a
+// tool that runs serially behaves exactly as before. Any other thread (e.g.
+// a ThreadPool task) fills its own clone of the histogram, which is created
+// the first time that thread uses the handle. After the first use, finding
+// a thread's clone takes no locks.
+//
+// Merge() adds the contents of every clone into the registered histograms
+// (with TH1::Add) and resets the clones. It must not be called while other
+// threads are filling, e.g. call it from Finalise, or after a parallel_for
+// has returned. Read or write the registered histograms only after merging.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ROOT includes
+#include "TH1.h"
+
+class HistogramRegistry;
+
+/// @brief Refers to one registered histogram. Dereferencing the handle
+/// gives the calling thread's copy of the histogram.
+template <typename H> class HistogramHandle {
+
+  public:
+
+    HistogramHandle() : registry_(nullptr), index_(0u) {}
+
+    inline H* operator->() const;
+    inline H& operator*() const { return *operator->(); }
+
+    /// @brief The registered histogram, which holds the merged contents
+    /// after HistogramRegistry::Merge()
+    inline H* merged() const;
+
+    inline bool valid() const { return registry_ != nullptr; }
+
+  protected:
+
+    friend class HistogramRegistry;
+
+    HistogramHandle(HistogramRegistry* registry, size_t index)
+      : registry_(registry), index_(index) {}
+
+    HistogramRegistry* registry_;
+    size_t index_;
+};
+
+class HistogramRegistry {
+
+  public:
+
+    HistogramRegistry();
+
+    /// @brief Deletes the clones. The registered histograms are not
+    /// deleted.
+    ~HistogramRegistry();
+
+    HistogramRegistry(const HistogramRegistry&) = delete;
+    HistogramRegistry& operator=(const HistogramRegistry&) = delete;
+
+    /// @brief Add a histogram to the registry. The caller keeps ownership
+    /// of it. Histograms should be registered before any other thread fills
+    /// through the registry.
+    template <typename H> HistogramHandle<H> Register(H* hist) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      histograms_.push_back(hist);
+      return HistogramHandle<H>(this, histograms_.size() - 1u);
+    }
+
+    /// @brief The calling thread's copy of a registered histogram
+    inline TH1* Local(size_t index) {
+      if ( std::this_thread::get_id() == owner_ ) {
+        return histograms_[index];
+      }
+      return LocalClone(index);
+    }
+
+    /// @brief A registered histogram
+    inline TH1* Registered(size_t index) const {
+      return histograms_.at(index);
+    }
+
+    /// @brief Add the contents of every clone into the registered
+    /// histograms and reset the clones
+    void Merge();
+
+    inline size_t size() const { return histograms_.size(); }
+
+  protected:
+
+    /// @brief Clones used by one thread, indexed like histograms_
+    struct ThreadClones {
+      std::vector< std::unique_ptr<TH1> > clones;
+    };
+
+    /// @brief Find (or create) the calling thread's clone
+    TH1* LocalClone(size_t index);
+
+    /// @brief Identifies this registry in the per-thread lookup tables
+    uint64_t serial_number_;
+
+    /// @brief Thread that created the registry, which fills the registered
+    /// histograms directly
+    std::thread::id owner_;
+
+    std::vector<TH1*> histograms_;
+    std::vector< std::unique_ptr<ThreadClones> > threads_;
+    std::mutex mutex_;
+};
+
+template <typename H> inline H* HistogramHandle<H>::operator->() const {
+  return static_cast<H*>( registry_->Local(index_) );
+}
+
+template <typename H> inline H* HistogramHandle<H>::merged() const {
+  return static_cast<H*>( registry_->Registered(index_) );
+}
@@ -0,0 +1,266 @@
+// standard library includes
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// POSIX includes
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// ToolAnalysis includes
+#include "MemoryMonitor.h"
+
+namespace {
+
+  double to_mb(double bytes) { return bytes / (1024. * 1024.); }
+
+  struct ToolMemory {
+    std::string tool_class;
+    std::string config_file;
+    uint64_t calls = 0u;
+    uint64_t growing_calls = 0u;
+    int64_t total_delta = 0;
+    int64_t max_delta = 0;
+    /// @brief RSS delta during the current leak window
+    int64_t window_delta = 0;
+  };
+
+  struct State {
+    std::mutex mutex;
+    int leak_window = 100;
+    uint64_t leak_threshold = 1u << 20;
+    int active_tools = 0;
+
+    std::vector<ToolMemory> tools;
+    std::map<std::string, int> tool_indices;
+
+    /// @brief RSS at the end of each event in the current window, starting
+    /// with the end of the event before it
+    std::vector<uint64_t> window;
+    uint64_t events = 0u;
+    uint64_t first_rss = 0u;
+    uint64_t last_rss = 0u;
+    uint64_t max_rss = 0u;
+    int warnings = 0;
+  };
+
+  State& state() {
+    static State s;
+    return s;
+  }
+
+  std::atomic<bool> monitor_enabled(false);
+
+  // /proc/self/statm is kept open and reread from the start, which is
+  // cheaper than opening it for every sample
+  int statm_fd = -1;
+  long page_size = 0;
+
+  std::string label(const State& s, const ToolMemory& tool) {
+    size_t configurations = 0u;
+    for (const auto& t : s.tools) {
+      if ( t.tool_class == tool.tool_class ) ++configurations;
+    }
+    if ( configurations < 2u ) return tool.tool_class;
+    return tool.tool_class + " (" + tool.config_file + ')';
+  }
+
+  // Called with the mutex held, with the RSS at the end of an event
+  void add_event(State& s, uint64_t rss) {
+    if ( s.events == 0u ) {
+      // The first window starts after the first event
+      s.first_rss = rss;
+      for (auto& tool : s.tools) tool.window_delta = 0;
+    }
+    ++s.events;
+    s.window.push_back(rss);
+    if ( s.window.size() <= static_cast<size_t>(s.leak_window) ) return;
+
+    bool monotonic = true;
+    for (size_t e = 1; e < s.window.size(); ++e) {
+      if ( s.window[e] < s.window[e - 1] ) { monotonic = false; break; }
+    }
+    uint64_t growth = s.window.back() - s.window.front();
+    if ( monotonic && s.window.back() > s.window.front()
+      && growth >= s.leak_threshold )
+    {
+      const ToolMemory* suspect = nullptr;
+      for (const auto& tool : s.tools) {
+        if ( !suspect || tool.window_delta > suspect->window_delta ) {
+          suspect = &tool;
+        }
+      }
+      ++s.warnings;
+      char buffer[128];
+      std::snprintf(buffer, sizeof(buffer), "%.1f MB over the last %d events"
+        " (%.1f MB to %.1f MB)", to_mb(growth), s.leak_window,
+        to_mb( s.window.front() ), to_mb( s.window.back() ));
+      std::cerr << "Warning: The resident memory grew on every event by "
+        << buffer << ", which may be a memory leak.";
+      if ( suspect && suspect->window_delta > 0 ) {
+        std::snprintf(buffer, sizeof(buffer), "%.1f MB", to_mb(
+          suspect->window_delta ));
+        std::cerr << " Most of it (" << buffer << ") was during the Execute"
+          " calls of " << label(s, *suspect) << '.';
+      }
+      std::cerr << std::endl;
+    }
+
+    // Start the next window from the end of this one
+    s.window.assign(1u, s.window.back());
+    for (auto& tool : s.tools) tool.window_delta = 0;
+  }
+}
+
+void MemoryMonitor::Configure(bool enabled, int leak_window,
+  double leak_threshold_mb)
+{
+  State& s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if ( leak_window > 0 ) s.leak_window = leak_window;
+  if ( leak_threshold_mb >= 0. ) {
+    s.leak_threshold = static_cast<uint64_t>(leak_threshold_mb * 1024.
+      * 1024.);
+  }
+
+  if ( enabled && statm_fd < 0 ) {
+    statm_fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    page_size = sysconf(_SC_PAGESIZE);
+    if ( statm_fd < 0 || page_size <= 0 ) {
+      std::cerr << "Warning: /proc/self/statm could not be read. The job"
+        " will run without memory monitoring.\n";
+      enabled = false;
+    }
+  }
+  monitor_enabled = enabled;
+}
+
+bool MemoryMonitor::enabled() {
+  return monitor_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryMonitor::ReadRSS() {
+  if ( statm_fd < 0 ) return 0u;
+  // The file holds the total program size and the resident size in pages,
+  // followed by other fields
+  char buffer[128];
+  ssize_t length = pread(statm_fd, buffer, sizeof(buffer) - 1u, 0);
+  if ( length <= 0 ) return 0u;
+  buffer[length] = '\0';
+  char* end = nullptr;
+  std::strtoull(buffer, &end, 10);
+  unsigned long long pages = std::strtoull(end, nullptr, 10);
+  return pages * static_cast<uint64_t>(page_size);
+}
+
+int MemoryMonitor::RegisterTool(const std::string& tool_class,
+  const std::string& config_file)
+{
+  State& s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  std::string key = tool_class + '|' + config_file;
+  auto found = s.tool_indices.find(key);
+  if ( found != s.tool_indices.end() ) return found->second;
+
+  int index = s.tools.size();
+  s.tool_indices[key] = index;
+  s.tools.emplace_back();
+  s.tools.back().tool_class = tool_class;
+  s.tools.back().config_file = config_file;
+  return index;
+}
+
+void MemoryMonitor::Executed(int tool, uint64_t rss_before,
+  uint64_t rss_after)
+{
+  if ( rss_before == 0u || rss_after == 0u ) return;
+  State& s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+
+  // The first tool starting again means that the previous event is done
+  if ( tool == 0 && s.last_rss != 0u ) add_event(s, rss_before);
+
+  int64_t delta = static_cast<int64_t>(rss_after)
+    - static_cast<int64_t>(rss_before);
+  ToolMemory& memory = s.tools.at(tool);
+  ++memory.calls;
+  memory.total_delta += delta;
+  memory.window_delta += delta;
+  if ( delta > 0 ) ++memory.growing_calls;
+  if ( delta > memory.max_delta ) memory.max_delta = delta;
+
+  s.last_rss = rss_after;
+  if ( rss_before > s.max_rss ) s.max_rss = rss_before;
+  if ( rss_after > s.max_rss ) s.max_rss = rss_after;
+}
+
+void MemoryMonitor::Started() {
+  State& s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  ++s.active_tools;
+}
+
+void MemoryMonitor::Finished() {
+  State& s = state();
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if ( --s.active_tools > 0 ) return;
+    // The last event ends with the last Execute call
+    if ( s.last_rss != 0u ) {
+      add_event(s, s.last_rss);
+      s.last_rss = 0u;
+    }
+  }
+  Report(std::cout);
+}
+
+void MemoryMonitor::Report(std::ostream& out) {
+  State& s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+
+  // Peak over the whole process lifetime, including Initialise and any
+  // spikes between samples (ru_maxrss is in kB on Linux)
+  rusage usage;
+  uint64_t peak_rss = s.max_rss;
+  if ( getrusage(RUSAGE_SELF, &usage) == 0
+    && static_cast<uint64_t>(usage.ru_maxrss) * 1024u > peak_rss )
+  {
+    peak_rss = static_cast<uint64_t>(usage.ru_maxrss) * 1024u;
+  }
+
+  char line[256];
+  out << "Memory report (resident set size):\n";
+  if ( s.events > 0u ) {
+    uint64_t last = s.window.empty() ? s.first_rss : s.window.back();
+    std::snprintf(line, sizeof(line), "%llu events, %.1f MB after the first"
+      " event, %.1f MB after the last, %.1f MB peak, %+.1f kB per event, %d"
+      " leak warning%s\n", static_cast<unsigned long long>(s.events),
+      to_mb(s.first_rss), to_mb(last), to_mb(peak_rss),
+      s.events > 1u ? ( double(last) - double(s.first_rss) ) / 1024.
+      / (s.events - 1u) : 0., s.warnings, s.warnings == 1 ? "" : "s");
+  }
+  else {
+    std::snprintf(line, sizeof(line), "No events, %.1f MB peak\n",
+      to_mb(peak_rss));
+  }
+  out << line;
+
+  std::snprintf(line, sizeof(line), "%-30s %8s %14s %14s %14s %14s\n",
+    "Tool", "Calls", "Delta (MB)", "Mean (kB)", "Max (MB)", "Growing calls");
+  out << line;
+  for (const auto& tool : s.tools) {
+    if ( tool.calls == 0u ) continue;
+    std::snprintf(line, sizeof(line), "%-30s %8llu %14.3f %14.3f %14.3f"
+      " %14llu\n", label(s, tool).c_str(),
+      static_cast<unsigned long long>(tool.calls), to_mb(tool.total_delta),
+      tool.total_delta / 1024. / tool.calls, to_mb(tool.max_delta),
+      static_cast<unsigned long long>(tool.growing_calls));
+    out << line;
+  }
+  out << std::flush;
+}
@@ -0,0 +1,57 @@
+// Resident memory of the process, sampled around every tool's Execute call
+//
+// When MemoryMonitor is set to 1 in the ToolChainConfig file, the Factory
+// wraps each tool (see UserTools/Factory/MonitoredTool.h) so that the
+// resident set size (RSS, from /proc/self/statm) is read before and after
+// each of its Execute calls. The difference is added to the tool's RSS
+// delta, and the RSS at the start of the first tool's Execute call is taken
+// as the RSS at the end of the previous event.
+//
+// The event samples are checked in consecutive windows of MemoryLeakWindow
+// events. If the RSS never fell during a window and grew by at least
+// MemoryLeakThresholdMB over it, a warning is printed naming the tool whose
+// Execute calls grew the RSS the most during the window. Once the last tool
+// has been finalised, a memory report is printed with the RSS at the start
+// and end of the run, the peak RSS and the RSS delta of each tool.
+//
+// The RSS belongs to the whole process, so when several threads run tools
+// at the same time (e.g. with Pipeline or ParallelSubChain) the deltas of
+// the tools include each other's growth.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+class MemoryMonitor {
+
+  public:
+
+    /// @brief Called by main() before the ToolChain is created
+    static void Configure(bool enabled, int leak_window,
+      double leak_threshold_mb);
+
+    static bool enabled();
+
+    /// @brief Current resident set size in bytes, or 0 if it can't be read
+    static uint64_t ReadRSS();
+
+    /// @brief Get the index used to record the RSS deltas of a tool.
+    /// Instances with the same class and configuration file share an index,
+    /// and the tool registered first marks the start of each event.
+    static int RegisterTool(const std::string& tool_class,
+      const std::string& config_file);
+
+    /// @brief Record the RSS before and after an Execute call of a tool
+    static void Executed(int tool, uint64_t rss_before, uint64_t rss_after);
+
+    /// @brief Called when a monitored tool starts to initialise
+    static void Started();
+
+    /// @brief Called when a monitored tool has been finalised. Prints the
+    /// memory report once every tool that started has finished.
+    static void Finished();
+
+    static void Report(std::ostream& out);
+};
@@ -0,0 +1,268 @@
+// Fixed-layout storage for reconstructed ADC pulses
+//
+// The boost archives used by BoostStore write every ADCPulse as a separate
+// object (with class-version bookkeeping for ADCPulse, Hit, and both of their
+// TimeClass members). For pulse-level analyses over large Hefty datasets, that
+// overhead dominates the cost of loading the RecoADCHits map. The classes in
+// this header provide a trivially-copyable pulse record and a container that
+// serializes each channel's pulses as a single raw array preceded by one
+// schema header.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Boost includes
+#include <boost/serialization/binary_object.hpp>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/split_member.hpp>
+
+// ToolAnalysis includes
+#include "ADCPulse.h"
+#include "ChannelKey.h"
+#include "SerialisableObject.h"
+
+/// @brief Plain-old-data copy of the information stored in an ADCPulse
+/// @details The members are ordered from widest to narrowest so that the
+/// record has no internal padding. Do not reorder or resize them without
+/// also incrementing PACKED_ADC_PULSE_SCHEMA_VERSION.
+struct PackedADCPulse {
+  uint64_t start_time_ns; // ns since beginning of minibuffer
+  uint64_t peak_time_ns; // ns since beginning of minibuffer
+  double baseline; // mean (ADC)
+  double sigma_baseline; // standard deviation (ADC)
+  double calibrated_amplitude; // V
+  double charge; // nC
+  uint64_t raw_area; // (ADC * samples)
+  int32_t tube_id;
+  uint16_t raw_amplitude; // ADC
+  uint16_t reserved; // explicit padding, always zero
+};
+
+static_assert(std::is_trivially_copyable<PackedADCPulse>::value,
+  "PackedADCPulse must be trivially copyable");
+static_assert(sizeof(PackedADCPulse) == 64u,
+  "Unexpected padding in PackedADCPulse");
+
+/// @brief Version number of the PackedADCPulse record layout
+constexpr uint16_t PACKED_ADC_PULSE_SCHEMA_VERSION = 1u;
+
+/// @brief Magic number written at the start of each channel's schema header
+constexpr uint32_t PACKED_ADC_PULSE_MAGIC = 0x41504B50u; // "PKPA"
+
+inline PackedADCPulse pack_adc_pulse(const ADCPulse& pulse) {
+  PackedADCPulse packed;
+  packed.start_time_ns = pulse.start_time().GetNs();
+  packed.peak_time_ns = pulse.peak_time().GetNs();
+  packed.baseline = pulse.baseline();
+  packed.sigma_baseline = pulse.sigma_baseline();
+  packed.calibrated_amplitude = pulse.amplitude();
+  packed.charge = pulse.charge();
+  packed.raw_area = pulse.raw_area();
+  packed.tube_id = pulse.GetTubeId();
+  packed.raw_amplitude = pulse.raw_amplitude();
+  packed.reserved = 0u;
+  return packed;
+}
+
+inline ADCPulse unpack_adc_pulse(const PackedADCPulse& packed) {
+  return ADCPulse(packed.tube_id, TimeClass(packed.start_time_ns),
+    TimeClass(packed.peak_time_ns), packed.baseline, packed.sigma_baseline,
+    packed.raw_area, packed.raw_amplitude, packed.calibrated_amplitude,
+    packed.charge);
+}
+
+/// @brief All of the pulses found on a single channel, stored contiguously
+/// @details minibuffer_offsets has one entry per minibuffer plus a final
+/// entry equal to pulses.size(). The pulses for minibuffer mb are stored in
+/// the half-open range [minibuffer_offsets[mb], minibuffer_offsets[mb + 1]).
+struct PackedADCPulseBlock {
+  std::vector<uint32_t> minibuffer_offsets;
+  std::vector<PackedADCPulse> pulses;
+
+  inline size_t num_minibuffers() const {
+    return minibuffer_offsets.empty() ? 0u : minibuffer_offsets.size() - 1u;
+  }
+
+  inline const PackedADCPulse* begin(size_t mb) const {
+    return pulses.data() + minibuffer_offsets.at(mb);
+  }
+
+  inline const PackedADCPulse* end(size_t mb) const {
+    return pulses.data() + minibuffer_offsets.at(mb + 1u);
+  }
+};
+
+/// @brief Packed replacement for the
+/// std::map<ChannelKey, std::vector<std::vector<ADCPulse> > > stored under
+/// the "RecoADCHits" key
+class PackedADCHits : public SerialisableObject {
+
+  friend class boost::serialization::access;
+
+  public:
+
+    typedef std::map<ChannelKey, std::vector< std::vector<ADCPulse> > >
+      PulseMap;
+
+    inline PackedADCHits() { serialise = true; }
+
+    inline explicit PackedADCHits(const PulseMap& pulse_map) {
+      serialise = true;
+      pack(pulse_map);
+    }
+
+    /// @brief Replace the contents of this object with the pulses from
+    /// an unpacked pulse map
+    void pack(const PulseMap& pulse_map) {
+      blocks_.clear();
+      for (const auto& pair : pulse_map) {
+        PackedADCPulseBlock& block = blocks_[pair.first];
+        block.minibuffer_offsets.reserve(pair.second.size() + 1u);
+        block.minibuffer_offsets.push_back(0u);
+        for (const auto& mb_pulses : pair.second) {
+          for (const auto& pulse : mb_pulses) {
+            block.pulses.push_back( pack_adc_pulse(pulse) );
+          }
+          block.minibuffer_offsets.push_back(block.pulses.size());
+        }
+      }
+    }
+
+    /// @brief Conversion shim for tools that still expect the original
+    /// RecoADCHits map of ADCPulse objects
+    void unpack(PulseMap& pulse_map) const {
+      pulse_map.clear();
+      for (const auto& pair : blocks_) {
+        const PackedADCPulseBlock& block = pair.second;
+        auto& pulse_vec = pulse_map[pair.first];
+        pulse_vec.resize(block.num_minibuffers());
+        for (size_t mb = 0; mb < block.num_minibuffers(); ++mb) {
+          pulse_vec[mb].reserve(block.end(mb) - block.begin(mb));
+          for (const PackedADCPulse* p = block.begin(mb); p != block.end(mb);
+            ++p) pulse_vec[mb].push_back( unpack_adc_pulse(*p) );
+        }
+      }
+    }
+
+    inline const std::map<ChannelKey, PackedADCPulseBlock>& blocks() const
+      { return blocks_; }
+
+    inline bool empty() const { return blocks_.empty(); }
+
+    bool Print() override {
+      size_t num_pulses = 0u;
+      for (const auto& pair : blocks_) num_pulses += pair.second.pulses.size();
+      std::cout << "Number of channels = " << blocks_.size() << '\n';
+      std::cout << "Number of pulses = " << num_pulses << '\n';
+      return true;
+    }
+
+  protected:
+
+    std::map<ChannelKey, PackedADCPulseBlock> blocks_;
+
+    /// @brief Schema header written once for each channel
+    struct BlockHeader {
+      uint32_t magic;
+      uint16_t version;
+      uint16_t record_size;
+      uint32_t num_offsets;
+      uint32_t num_pulses;
+    };
+
+    template<class Archive> void save(Archive& ar,
+      const unsigned int /*version*/) const
+    {
+      uint32_t num_blocks = blocks_.size();
+      ar & num_blocks;
+      for (const auto& pair : blocks_) {
+        ChannelKey key = pair.first;
+        ar & key;
+
+        const PackedADCPulseBlock& block = pair.second;
+        BlockHeader header = { PACKED_ADC_PULSE_MAGIC,
+          PACKED_ADC_PULSE_SCHEMA_VERSION, sizeof(PackedADCPulse),
+          static_cast<uint32_t>(block.minibuffer_offsets.size()),
+          static_cast<uint32_t>(block.pulses.size()) };
+        ar & boost::serialization::make_binary_object(&header,
+          sizeof(header));
+
+        if (header.num_offsets > 0u) {
+          ar & boost::serialization::make_binary_object(
+            const_cast<uint32_t*>( block.minibuffer_offsets.data() ),
+            header.num_offsets * sizeof(uint32_t));
+        }
+        if (header.num_pulses > 0u) {
+          ar & boost::serialization::make_binary_object(
+            const_cast<PackedADCPulse*>( block.pulses.data() ),
+            header.num_pulses * sizeof(PackedADCPulse));
+        }
+      }
+    }
+
+    template<class Archive> void load(Archive& ar,
+      const unsigned int /*version*/)
+    {
+      blocks_.clear();
+      uint32_t num_blocks = 0u;
+      ar & num_blocks;
+      for (uint32_t b = 0; b < num_blocks; ++b) {
+        ChannelKey key;
+        ar & key;
+
+        BlockHeader header;
+        ar & boost::serialization::make_binary_object(&header,
+          sizeof(header));
+
+        if ( header.magic != PACKED_ADC_PULSE_MAGIC
+          || header.version != PACKED_ADC_PULSE_SCHEMA_VERSION
+          || header.record_size != sizeof(PackedADCPulse) )
+        {
+          throw std::runtime_error("Unsupported PackedADCHits schema (version "
+            + std::to_string(header.version) + ", record size "
+            + std::to_string(header.record_size) + " bytes)");
+        }
+
+        PackedADCPulseBlock& block = blocks_[key];
+        block.minibuffer_offsets.resize(header.num_offsets);
+        block.pulses.resize(header.num_pulses);
+
+        if (header.num_offsets > 0u) {
+          ar & boost::serialization::make_binary_object(
+            block.minibuffer_offsets.data(),
+            header.num_offsets * sizeof(uint32_t));
+        }
+        if (header.num_pulses > 0u) {
+          ar & boost::serialization::make_binary_object(block.pulses.data(),
+            header.num_pulses * sizeof(PackedADCPulse));
+        }
+      }
+    }
+
+    template<class Archive> void serialize(Archive& ar,
+      const unsigned int version)
+    {
+      if (serialise) boost::serialization::split_member(ar, *this, version);
+    }
+};
+
+/// @brief Load the reconstructed ADC pulses from a Store, accepting either
+/// the packed ("RecoADCHitsPacked") or the original ("RecoADCHits") layout
+template <typename AStore> bool get_reco_adc_hits(AStore& store,
+  PackedADCHits::PulseMap& pulse_map)
+{
+  if ( store.Has("RecoADCHitsPacked") ) {
+    PackedADCHits packed_hits;
+    if ( !store.Get("RecoADCHitsPacked", packed_hits) ) return false;
+    packed_hits.unpack(pulse_map);
+    return true;
+  }
+  return store.Get("RecoADCHits", pulse_map);
+}
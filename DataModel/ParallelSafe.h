@@ -0,0 +1,24 @@
+// Marker for tools that may be run on several events at once by the
+// ParallelSubChain tool
+//
+// A tool inherits from ParallelSafe (as well as Tool) to declare that
+// separate instances of it can run Execute() at the same time on different
+// threads. Each instance is given its own DataModel, so this is true when the
+// tool
+//
+//   * reads and writes event data only through its own DataModel,
+//   * keeps any other state in its own data members,
+//   * does not write output files or fill shared ROOT objects, and
+//   * does not rely on global or static state (including ROOT globals such as
+//     TVirtualFFT::GetCurrentTransform() or the default fitter).
+//
+// ParallelSubChain refuses to clone tools that do not declare themselves
+// parallel-safe unless it is told otherwise in its configuration file.
+#pragma once
+
+class ParallelSafe {
+
+  public:
+
+    virtual ~ParallelSafe() {}
+};
@@ -0,0 +1,138 @@
+// standard library includes
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+// POSIX includes
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ToolAnalysis includes
+#include "PerfCounters.h"
+
+namespace {
+
+  std::atomic<bool> counters_enabled(false);
+  std::atomic<bool> warned_multiplexing(false);
+
+  const char* const COUNTER_NAMES[PerfCounters::NUM_COUNTERS]
+    = { "cycles", "instructions", "cache misses", "branch misses" };
+
+  const uint64_t COUNTER_CONFIGS[PerfCounters::NUM_COUNTERS]
+    = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+  int open_counter(uint64_t config, int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group_fd == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+      | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // This thread, on any CPU
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+  }
+
+  // The counters of one thread, read together as a group
+  struct ThreadCounters {
+
+    ThreadCounters() : opened(false), leader_fd(-1), num_open(0) {
+      for (int c = 0; c < PerfCounters::NUM_COUNTERS; ++c) {
+        fds[c] = -1;
+        group_index[c] = -1;
+      }
+    }
+
+    ~ThreadCounters() {
+      for (int c = 0; c < PerfCounters::NUM_COUNTERS; ++c) {
+        if ( fds[c] >= 0 ) close(fds[c]);
+      }
+    }
+
+    void Open() {
+      opened = true;
+      int first_error = 0;
+      for (int c = 0; c < PerfCounters::NUM_COUNTERS; ++c) {
+        fds[c] = open_counter(COUNTER_CONFIGS[c], leader_fd);
+        if ( fds[c] < 0 ) {
+          if ( first_error == 0 ) first_error = errno;
+          continue;
+        }
+        if ( leader_fd < 0 ) leader_fd = fds[c];
+        group_index[c] = num_open++;
+      }
+
+      if ( leader_fd < 0 ) {
+        // Warn once, then stop trying on other threads
+        if ( counters_enabled.exchange(false) ) {
+          std::cerr << "Warning: Hardware performance counters are not"
+            " available (" << std::strerror(first_error) << "). Check"
+            " /proc/sys/kernel/perf_event_paranoid. Tools will run without"
+            " counters.\n";
+        }
+        return;
+      }
+
+      ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    bool opened;
+    int leader_fd;
+    int num_open;
+    int fds[PerfCounters::NUM_COUNTERS];
+    /// Position of each counter in the group, or -1 if it is not open
+    int group_index[PerfCounters::NUM_COUNTERS];
+  };
+
+  thread_local ThreadCounters thread_counters;
+}
+
+void PerfCounters::Configure(bool enabled) {
+  counters_enabled = enabled;
+}
+
+bool PerfCounters::enabled() {
+  return counters_enabled.load(std::memory_order_relaxed);
+}
+
+bool PerfCounters::Read(PerfCounts& counts) {
+  ThreadCounters& local = thread_counters;
+  if ( !local.opened ) local.Open();
+  if ( local.leader_fd < 0 ) return false;
+
+  // Layout for PERF_FORMAT_GROUP with both times
+  uint64_t buffer[3 + NUM_COUNTERS];
+  ssize_t size = read(local.leader_fd, buffer, sizeof(buffer));
+  if ( size < static_cast<ssize_t>( (3 + local.num_open) * sizeof(uint64_t) ) )
+  {
+    return false;
+  }
+
+  // With more counters than the PMU has registers, the kernel time-shares
+  // them and the counts only cover part of the time
+  uint64_t time_enabled = buffer[1];
+  uint64_t time_running = buffer[2];
+  if ( time_running < time_enabled && !warned_multiplexing.exchange(true) ) {
+    std::cerr << "Warning: The hardware performance counters are being"
+      " multiplexed, so the counts are underestimates\n";
+  }
+
+  for (int c = 0; c < NUM_COUNTERS; ++c) {
+    counts.valid[c] = ( local.group_index[c] >= 0 );
+    counts.values[c] = counts.valid[c] ? buffer[3 + local.group_index[c]]
+      : 0u;
+  }
+  return true;
+}
+
+const char* PerfCounters::Name(Counter counter) {
+  return COUNTER_NAMES[counter];
+}
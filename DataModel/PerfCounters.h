@@ -0,0 +1,48 @@
+// Hardware performance counters (Linux perf_event_open) for the calling
+// thread
+//
+// When ToolPerfCounters is set to 1 in the ToolChainConfig file, the
+// Factory reads the counters before and after each tool's Execute call (see
+// UserTools/Factory/MonitoredTool.h) and the ToolProfiler reports the
+// cycles, instructions, IPC, cache misses and branch misses per event for
+// each tool. Only work done on the thread that calls Execute is counted, so
+// work that a tool hands to the ThreadPool is not included.
+//
+// The counters count user-space events only. If the kernel does not allow
+// them (e.g. /proc/sys/kernel/perf_event_paranoid is above 2, inside some
+// containers, or on virtual machines without a PMU), a warning is printed
+// once and the tools run without counters. Counters that the CPU does not
+// support are reported as unavailable.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+
+/// @brief Values of the hardware counters at one moment
+struct PerfCounts {
+  static constexpr int NUM_COUNTERS = 4;
+  uint64_t values[NUM_COUNTERS];
+  /// @brief Whether each counter could be opened
+  bool valid[NUM_COUNTERS];
+};
+
+class PerfCounters {
+
+  public:
+
+    enum Counter { CYCLES = 0, INSTRUCTIONS = 1, CACHE_MISSES = 2,
+      BRANCH_MISSES = 3, NUM_COUNTERS = PerfCounts::NUM_COUNTERS };
+
+    /// @brief Called by main() before the ToolChain is created
+    static void Configure(bool enabled);
+
+    /// @brief Whether counters were requested and are still believed to be
+    /// available
+    static bool enabled();
+
+    /// @brief Read the calling thread's counters, opening them on the first
+    /// call from each thread. Returns false if no counter is available.
+    static bool Read(PerfCounts& counts);
+
+    static const char* Name(Counter counter);
+};
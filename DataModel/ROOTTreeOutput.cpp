@@ -0,0 +1,183 @@
+// standard library includes
+#include <cstring>
+#include <stdexcept>
+
+// ROOT includes
+#include "RVersion.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "TObjArray.h"
+#include "TROOT.h"
+#if ROOT_VERSION_CODE < ROOT_VERSION(6,0,0)
+#include "TThread.h"
+#endif
+
+// ToolAnalysis includes
+#include "ROOTTreeOutput.h"
+
+namespace {
+
+  constexpr double BYTES_PER_MB = 1024. * 1024.;
+
+  // Alignment used for each branch in a queued entry
+  constexpr size_t BRANCH_ALIGNMENT = 8u;
+
+  // Returns the number of bytes used by the buffer of a simple leaf branch,
+  // or zero if the branch cannot be copied as a block of memory
+  size_t leaf_branch_size(TBranch* branch) {
+
+    if ( branch->IsA() != TBranch::Class() ) return 0u;
+    if ( branch->GetListOfBranches()->GetEntriesFast() > 0 ) return 0u;
+    if ( !branch->GetAddress() ) return 0u;
+
+    size_t size = 0u;
+    TObjArray* leaves = branch->GetListOfLeaves();
+    for (int l = 0; l < leaves->GetEntriesFast(); ++l) {
+      TLeaf* leaf = static_cast<TLeaf*>( leaves->UncheckedAt(l) );
+      if ( leaf->GetLeafCount() ) return 0u; // variable-length array
+      size_t end = leaf->GetOffset() + leaf->GetLenType() * leaf->GetLen();
+      if ( end > size ) size = end;
+    }
+    return size;
+  }
+}
+
+void TreeOutputSettings::Load(Store& config) {
+
+  double auto_flush_mb = auto_flush_bytes / BYTES_PER_MB;
+  config.Get("AutoFlushMB", auto_flush_mb);
+  auto_flush_bytes = auto_flush_mb * BYTES_PER_MB;
+
+  double auto_save_mb = auto_save_bytes / BYTES_PER_MB;
+  config.Get("AutoSaveMB", auto_save_mb);
+  auto_save_bytes = auto_save_mb * BYTES_PER_MB;
+
+  int async = async_fill;
+  config.Get("AsyncFill", async);
+  async_fill = async;
+
+  int max_queued = max_queued_entries;
+  config.Get("AsyncFillQueueSize", max_queued);
+  if ( max_queued > 0 ) max_queued_entries = max_queued;
+}
+
+void configure_output_tree(TTree* tree, const TreeOutputSettings& settings)
+{
+  // Negative values are interpreted by ROOT as numbers of bytes rather than
+  // numbers of entries
+  if ( settings.auto_flush_bytes > 0 ) {
+    tree->SetAutoFlush( -settings.auto_flush_bytes );
+  }
+  if ( settings.auto_save_bytes > 0 ) {
+    tree->SetAutoSave( -settings.auto_save_bytes );
+  }
+}
+
+void enable_root_thread_safety() {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+  ROOT::EnableThreadSafety();
+#else
+  TThread::Initialize();
+#endif
+}
+
+bool AsyncTreeFiller::Supported(TTree* tree) {
+  TObjArray* branches = tree->GetListOfBranches();
+  for (int b = 0; b < branches->GetEntriesFast(); ++b) {
+    TBranch* branch = static_cast<TBranch*>( branches->UncheckedAt(b) );
+    if ( leaf_branch_size(branch) == 0u ) return false;
+  }
+  return true;
+}
+
+AsyncTreeFiller::AsyncTreeFiller(TTree* tree, size_t max_queued_entries)
+  : tree_(tree), entry_size_(0u),
+  max_queued_(max_queued_entries > 0u ? max_queued_entries : 1u),
+  stopping_(false), stopped_(false), num_entries_(0u)
+{
+  if ( !Supported(tree_) ) {
+    throw std::runtime_error(std::string("The TTree ") + tree_->GetName()
+      + " has branches that cannot be filled asynchronously");
+  }
+
+  TObjArray* branches = tree_->GetListOfBranches();
+  for (int b = 0; b < branches->GetEntriesFast(); ++b) {
+    TBranch* branch = static_cast<TBranch*>( branches->UncheckedAt(b) );
+    BranchBuffer buffer;
+    buffer.branch = branch;
+    buffer.tool_address = branch->GetAddress();
+    buffer.offset = entry_size_;
+    buffer.size = leaf_branch_size(branch);
+    branches_.push_back(buffer);
+
+    entry_size_ += buffer.size;
+    entry_size_ += (BRANCH_ALIGNMENT - entry_size_ % BRANCH_ALIGNMENT)
+      % BRANCH_ALIGNMENT;
+  }
+
+  // Point the branches at a buffer owned by the background thread
+  shadow_.resize(entry_size_);
+  for (auto& buffer : branches_) {
+    buffer.branch->SetAddress(shadow_.data() + buffer.offset);
+  }
+
+  enable_root_thread_safety();
+  thread_ = std::thread(&AsyncTreeFiller::Run, this);
+}
+
+AsyncTreeFiller::~AsyncTreeFiller() {
+  Stop();
+}
+
+void AsyncTreeFiller::Fill() {
+
+  std::vector<char> entry(entry_size_);
+  for (const auto& buffer : branches_) {
+    std::memcpy(entry.data() + buffer.offset, buffer.tool_address,
+      buffer.size);
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (stopping_) throw std::runtime_error("AsyncTreeFiller::Fill() called"
+    " after Stop()");
+  cond_.wait(lock, [this]{ return queue_.size() < max_queued_; });
+  queue_.push_back( std::move(entry) );
+  ++num_entries_;
+  lock.unlock();
+  cond_.notify_all();
+}
+
+void AsyncTreeFiller::Stop() {
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) return;
+    stopping_ = true;
+  }
+  cond_.notify_all();
+  if ( thread_.joinable() ) thread_.join();
+
+  // Give the branch buffers back to the tool
+  for (auto& buffer : branches_) {
+    buffer.branch->SetAddress(buffer.tool_address);
+  }
+  stopped_ = true;
+}
+
+void AsyncTreeFiller::Run() {
+
+  while (true) {
+    std::vector<char> entry;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]{ return !queue_.empty() || stopping_; });
+      if ( queue_.empty() ) return; // stopping, and nothing left to fill
+      entry = std::move( queue_.front() );
+      queue_.pop_front();
+    }
+    cond_.notify_all();
+
+    std::memcpy(shadow_.data(), entry.data(), entry_size_);
+    tree_->Fill();
+  }
+}
@@ -0,0 +1,125 @@
+// Helpers for tools that write TTrees to ROOT files event by event
+//
+// TreeOutputSettings holds the basket flushing and autosave policy for an
+// output tree, and can be read from a tool's configuration file. Applying
+// it to a tree with configure_output_tree() means that baskets are written
+// to disk incrementally and the tree header is saved periodically, so the
+// file can be read (up to the last autosave) even if the job crashes. Tools
+// should not call TTree::Write() on every event; one Write() before closing
+// the file is enough.
+//
+// AsyncTreeFiller moves the TTree::Fill() calls (and therefore basket
+// compression and the file writes) for a tree onto a background thread.
+// While an AsyncTreeFiller is running, its tree and file must not be used by
+// any other thread. Call Stop() before writing or closing the file.
+#pragma once
+
+// standard library includes
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ROOT includes
+#include "TTree.h"
+
+// ToolDAQ includes
+#include "Store.h"
+
+/// @brief Flushing and autosave policy for an output TTree
+struct TreeOutputSettings {
+
+  /// @brief Flush baskets after this many bytes of uncompressed data
+  long long auto_flush_bytes = 32ll * 1024 * 1024;
+
+  /// @brief Save the tree header after this many bytes have been written
+  long long auto_save_bytes = 64ll * 1024 * 1024;
+
+  /// @brief Whether to fill the tree on a background thread
+  bool async_fill = false;
+
+  /// @brief Maximum number of entries waiting to be filled by the
+  /// background thread
+  size_t max_queued_entries = 4096u;
+
+  /// @brief Read the settings from a tool's configuration Store. The keys
+  /// are AutoFlushMB, AutoSaveMB, AsyncFill, and AsyncFillQueueSize. Keys
+  /// that are not present keep their default values.
+  void Load(Store& config);
+};
+
+/// @brief Apply the flushing and autosave policy to a tree
+void configure_output_tree(TTree* tree, const TreeOutputSettings& settings);
+
+/// @brief Enable ROOT's internal locking so that ROOT objects may be used
+/// from more than one thread. Safe to call more than once.
+void enable_root_thread_safety();
+
+class AsyncTreeFiller {
+
+  public:
+
+    /// @brief Take over filling a tree whose branches have already been
+    /// created
+    /// @details The branches must all be simple leaf branches (created with
+    /// a leaf list or the address of a fundamental type) without
+    /// variable-length arrays. Supported() can be used to check this
+    /// beforehand. The branch buffers owned by the tool are copied each time
+    /// Fill() is called, so the tool can keep reusing them.
+    AsyncTreeFiller(TTree* tree, size_t max_queued_entries = 4096u);
+
+    /// @brief Stops the background thread after filling any queued entries
+    ~AsyncTreeFiller();
+
+    AsyncTreeFiller(const AsyncTreeFiller&) = delete;
+    AsyncTreeFiller& operator=(const AsyncTreeFiller&) = delete;
+
+    /// @brief Returns true if every branch of the tree can be filled
+    /// asynchronously
+    static bool Supported(TTree* tree);
+
+    /// @brief Copy the current contents of the branch buffers and queue
+    /// them to be filled
+    void Fill();
+
+    /// @brief Fill any queued entries, stop the background thread, and give
+    /// the branch buffers back to the tool. Fill() may not be called after
+    /// this.
+    void Stop();
+
+    /// @brief Number of entries given to Fill() so far
+    inline uint64_t num_entries() const { return num_entries_; }
+
+  protected:
+
+    /// @brief Function run by the background thread
+    void Run();
+
+    /// @brief Information about a single branch
+    struct BranchBuffer {
+      TBranch* branch;
+      char* tool_address; // buffer owned by the tool
+      size_t offset; // position of this branch in each queued entry
+      size_t size;
+    };
+
+    TTree* tree_;
+    std::vector<BranchBuffer> branches_;
+    size_t entry_size_;
+
+    /// @brief Buffer given to the branches while the thread is running
+    std::vector<char> shadow_;
+
+    size_t max_queued_;
+    std::deque< std::vector<char> > queue_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stopping_;
+    bool stopped_;
+    uint64_t num_entries_;
+
+    std::thread thread_;
+};
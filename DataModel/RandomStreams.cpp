@@ -0,0 +1,48 @@
+// standard library includes
+#include <atomic>
+
+// ToolAnalysis includes
+#include "RandomStreams.h"
+
+namespace {
+
+  std::atomic<uint64_t> random_seed(0u);
+
+  // SplitMix64 finalizer, used to mix the stream identifiers into a key
+  uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  // 64-bit FNV-1a hash. std::hash is not used because its values may
+  // differ between compilers.
+  uint64_t hash_string(const std::string& s, uint64_t hash) {
+    hash ^= 0xCBF29CE484222325ull;
+    for (unsigned char c : s) {
+      hash ^= c;
+      hash *= 0x100000001B3ull;
+    }
+    return hash;
+  }
+}
+
+void RandomStreams::SetSeed(uint64_t seed) {
+  random_seed = seed;
+}
+
+uint64_t RandomStreams::Seed() {
+  return random_seed.load();
+}
+
+CounterRNG RandomStreams::Stream(uint64_t run, uint64_t event,
+  const std::string& tool, const std::string& purpose)
+{
+  // The separator keeps ("ab", "c") and ("a", "bc") apart
+  uint64_t key = mix64( Seed() );
+  key = mix64( hash_string(tool + '\0' + purpose, key) );
+
+  return CounterRNG(key, static_cast<uint32_t>(event),
+    static_cast<uint32_t>(event >> 32), static_cast<uint32_t>(run));
+}
@@ -0,0 +1,146 @@
+// Reproducible random numbers for simulation tools
+//
+// Random numbers are drawn from counter-based streams (the Philox4x32-10
+// generator of Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3", SC11). A stream is identified by a run number, an event number, the
+// name of the tool and the purpose of the numbers (e.g. "noise"), together
+// with the job-wide seed. The n-th number of a stream is a pure function of
+// these values and n, so a tool gets the same numbers for an event however
+// many threads or shard processes are used and in whichever order the events
+// are processed. Streams hold no shared state, so creating and using them
+// needs no locks.
+//
+// Tools usually create their streams at the start of each Execute():
+//
+//   CounterRNG rng = m_data->RandomStream(run, event, "MyTool", "noise");
+//   double x = rng.Gaus(0., 2.);
+//
+// The seed is set by RandomSeed in the ToolChainConfig file (default 0).
+#pragma once
+
+// standard library includes
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+/// @brief Counter-based random number stream
+class CounterRNG {
+
+  public:
+
+    /// @brief A stream with an all-zero key and counter. Use
+    /// RandomStreams::Stream() to get a stream for a particular event.
+    CounterRNG() : key_{0u, 0u}, counter_{0u, 0u, 0u, 0u}, next_word_(4u),
+      has_spare_gaus_(false), spare_gaus_(0.) {}
+
+    /// @param key Selects the stream
+    /// @param id Event identifier held in the top 96 bits of the counter.
+    /// The low 32 bits count the blocks of four numbers drawn from the
+    /// stream.
+    CounterRNG(uint64_t key, uint32_t id0, uint32_t id1, uint32_t id2)
+      : key_{ static_cast<uint32_t>(key),
+      static_cast<uint32_t>(key >> 32) }, counter_{0u, id0, id1, id2},
+      next_word_(4u), has_spare_gaus_(false), spare_gaus_(0.) {}
+
+    /// @brief Uniformly distributed 32-bit integer
+    inline uint32_t NextUInt32() {
+      if ( next_word_ == 4u ) {
+        Philox(counter_, key_, block_);
+        ++counter_[0];
+        next_word_ = 0u;
+      }
+      return block_[next_word_++];
+    }
+
+    /// @brief Uniformly distributed number in (0, 1), like TRandom::Rndm()
+    inline double Rndm() {
+      uint64_t high = NextUInt32() >> 5;
+      uint64_t low = NextUInt32() >> 6;
+      // 53 random bits, offset by half a step so that 0 cannot occur
+      return ( (high << 26 | low) + 0.5 ) * (1. / 9007199254740992.);
+    }
+
+    /// @brief Uniformly distributed number in (low, high)
+    inline double Uniform(double low, double high) {
+      return low + (high - low) * Rndm();
+    }
+
+    /// @brief Normally distributed number (Box-Muller method)
+    inline double Gaus(double mean = 0., double sigma = 1.) {
+      if (has_spare_gaus_) {
+        has_spare_gaus_ = false;
+        return mean + sigma * spare_gaus_;
+      }
+      double radius = std::sqrt( -2. * std::log( Rndm() ) );
+      double angle = 2. * M_PI * Rndm();
+      spare_gaus_ = radius * std::sin(angle);
+      has_spare_gaus_ = true;
+      return mean + sigma * radius * std::cos(angle);
+    }
+
+    /// @brief Uniformly distributed integer in [0, n)
+    inline uint32_t Integer(uint32_t n) {
+      return static_cast<uint32_t>( Rndm() * n );
+    }
+
+    /// @brief The Philox4x32-10 block function
+    static inline void Philox(const uint32_t counter[4],
+      const uint32_t key[2], uint32_t out[4])
+    {
+      const uint64_t M0 = 0xD2511F53u;
+      const uint64_t M1 = 0xCD9E8D57u;
+      const uint32_t W0 = 0x9E3779B9u;
+      const uint32_t W1 = 0xBB67AE85u;
+
+      uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2],
+        c3 = counter[3];
+      uint32_t k0 = key[0], k1 = key[1];
+
+      for (int round = 0; round < 10; ++round) {
+        if ( round > 0 ) {
+          k0 += W0;
+          k1 += W1;
+        }
+        uint64_t product0 = M0 * c0;
+        uint64_t product1 = M1 * c2;
+        uint32_t hi0 = static_cast<uint32_t>(product0 >> 32);
+        uint32_t lo0 = static_cast<uint32_t>(product0);
+        uint32_t hi1 = static_cast<uint32_t>(product1 >> 32);
+        uint32_t lo1 = static_cast<uint32_t>(product1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+      }
+
+      out[0] = c0;
+      out[1] = c1;
+      out[2] = c2;
+      out[3] = c3;
+    }
+
+  protected:
+
+    uint32_t key_[2];
+    uint32_t counter_[4];
+    uint32_t block_[4];
+    uint32_t next_word_;
+
+    bool has_spare_gaus_;
+    double spare_gaus_;
+};
+
+/// @brief Creates the random streams for each (run, event, tool, purpose)
+class RandomStreams {
+
+  public:
+
+    /// @brief Set the job-wide seed (done by main() from the RandomSeed
+    /// entry in the ToolChainConfig file)
+    static void SetSeed(uint64_t seed);
+    static uint64_t Seed();
+
+    /// @brief The stream for a given event, tool and purpose
+    static CounterRNG Stream(uint64_t run, uint64_t event,
+      const std::string& tool, const std::string& purpose);
+};
@@ -0,0 +1,156 @@
+// standard library includes
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// ToolAnalysis includes
+#include "Sharding.h"
+
+namespace {
+
+  bool sharding_enabled = false;
+  size_t shard_index = 0u;
+  size_t shard_count = 1u;
+  std::string shard_manifest_directory;
+
+  // Tools may fail on several threads at once (e.g. in a Pipeline)
+  std::atomic<bool> shard_failed(false);
+
+  const char* type_name(Sharding::OutputType type) {
+    if ( type == Sharding::OutputType::ROOTFile ) return "ROOTFile";
+    return "BoostStore";
+  }
+}
+
+void Sharding::Configure(size_t index, size_t count,
+  const std::string& manifest_directory)
+{
+  sharding_enabled = (count > 1u);
+  shard_index = index;
+  shard_count = (count > 0u) ? count : 1u;
+  shard_manifest_directory = manifest_directory;
+
+  // Start with an empty manifest
+  if (sharding_enabled) {
+    std::ofstream manifest( ManifestPath(shard_manifest_directory,
+      shard_index) );
+  }
+}
+
+bool Sharding::enabled() {
+  return sharding_enabled;
+}
+
+size_t Sharding::index() {
+  return shard_index;
+}
+
+size_t Sharding::count() {
+  return shard_count;
+}
+
+void Sharding::Slice(size_t n, size_t& begin, size_t& end) {
+  begin = n * shard_index / shard_count;
+  end = n * (shard_index + 1u) / shard_count;
+}
+
+std::string Sharding::OutputPath(const std::string& path, OutputType type) {
+
+  if ( !sharding_enabled ) return path;
+
+  std::string shard_path = ShardPath(path, type);
+  std::ofstream manifest( ManifestPath(shard_manifest_directory, shard_index),
+    std::ios::app );
+  manifest << type_name(type) << ' ' << path << ' ' << shard_path << '\n';
+
+  return shard_path;
+}
+
+std::string Sharding::ShardPath(const std::string& path, OutputType type) {
+
+  if ( !sharding_enabled ) return path;
+
+  std::string suffix = ".shard" + std::to_string(shard_index);
+  std::string shard_path = path + suffix;
+  const std::string root_extension = ".root";
+  if ( type == OutputType::ROOTFile && path.size() > root_extension.size()
+    && path.compare(path.size() - root_extension.size(),
+    root_extension.size(), root_extension) == 0 )
+  {
+    shard_path = path.substr(0, path.size() - root_extension.size())
+      + suffix + root_extension;
+  }
+  return shard_path;
+}
+
+void Sharding::AddSummaryTree(const std::string& path,
+  const std::string& tree_name, const std::string& key_branch)
+{
+  if ( !sharding_enabled ) return;
+
+  std::ofstream manifest( ManifestPath(shard_manifest_directory, shard_index),
+    std::ios::app );
+  manifest << "SummaryTree " << path << ' ' << tree_name << ' ' << key_branch
+    << '\n';
+}
+
+bool Sharding::Unsupported(const std::string& tool_name) {
+
+  if ( !sharding_enabled ) return false;
+
+  std::cerr << "Error: " << tool_name << " cannot give each shard its own"
+    " part of the events, so it cannot be run with --shards." << std::endl;
+  RecordFailure(tool_name + "::Initialise");
+  return true;
+}
+
+void Sharding::RecordFailure(const std::string& what) {
+
+  if ( !sharding_enabled ) return;
+
+  std::cerr << "Error: " << what << " failed in shard " << shard_index
+    << ". The shard outputs will not be merged." << std::endl;
+  shard_failed = true;
+}
+
+bool Sharding::failed() {
+  return shard_failed;
+}
+
+std::string Sharding::ManifestPath(const std::string& manifest_directory,
+  size_t index)
+{
+  return manifest_directory + "/shard" + std::to_string(index) + ".manifest";
+}
+
+bool Sharding::ReadManifest(const std::string& filename,
+  std::vector<ManifestEntry>& entries,
+  std::vector<SummaryTree>& summary_trees)
+{
+  std::ifstream in(filename);
+  if ( !in.good() ) return false;
+
+  std::string line;
+  while ( std::getline(in, line) ) {
+    std::istringstream words(line);
+    std::string type;
+    words >> type;
+    if ( type == "SummaryTree" ) {
+      SummaryTree tree;
+      if ( !(words >> tree.final_path >> tree.tree_name >> tree.key_branch) ) {
+        return false;
+      }
+      summary_trees.push_back(tree);
+      continue;
+    }
+
+    ManifestEntry entry;
+    if ( !(words >> entry.final_path >> entry.shard_path) ) continue;
+    if ( type == "ROOTFile" ) entry.type = OutputType::ROOTFile;
+    else if ( type == "BoostStore" ) entry.type = OutputType::BoostStore;
+    else return false;
+    entries.push_back(entry);
+  }
+  return true;
+}
@@ -0,0 +1,105 @@
+// Settings for a worker process started by "Analyse --shards N"
+//
+// In sharding mode, the Analyse executable forks N worker processes that
+// each run the whole ToolChain on a deterministic, contiguous slice of the
+// input. Loader tools ask Sharding for their slice, and tools that write
+// output files ask it for a per-shard file name, which is also recorded in
+// the shard's manifest. When every worker has finished, the parent process
+// reads the manifests and merges the shard outputs, in shard order, into the
+// files that a single process would have written.
+//
+// Tools that load or generate events but cannot take a slice of their input
+// call Unsupported() in Initialise and fail, since every shard would
+// produce the same events. The ToolChain does not report whether its tools
+// succeeded, so in sharding mode the Factory wraps every tool and records
+// any failure with RecordFailure(). A worker that recorded a failure exits
+// with an error, and the launcher then merges nothing.
+//
+// Outside of sharding mode, Slice() returns the whole input, OutputPath()
+// returns its argument unchanged and the other functions do nothing, so
+// tools do not need to check enabled().
+#pragma once
+
+// standard library includes
+#include <string>
+#include <vector>
+
+class Sharding {
+
+  public:
+
+    /// @brief How a shard output should be merged
+    enum class OutputType { BoostStore, ROOTFile };
+
+    /// @brief One line of a shard manifest
+    struct ManifestEntry {
+      OutputType type;
+      /// @brief Name of the merged output file
+      std::string final_path;
+      /// @brief Name of the file written by the shard
+      std::string shard_path;
+    };
+
+    /// @brief A tree of totals in a ROOT output file (see AddSummaryTree())
+    struct SummaryTree {
+      /// @brief Name of the merged output file
+      std::string final_path;
+      std::string tree_name;
+      std::string key_branch;
+    };
+
+    /// @brief Called by the launcher in each worker process before the
+    /// ToolChain is created
+    static void Configure(size_t index, size_t count,
+      const std::string& manifest_directory);
+
+    static bool enabled();
+    static size_t index();
+    static size_t count();
+
+    /// @brief Find this shard's part [begin, end) of n items. Shard k gets
+    /// items [n*k/N, n*(k+1)/N), so concatenating the shards in order gives
+    /// back the original order.
+    static void Slice(size_t n, size_t& begin, size_t& end);
+
+    /// @brief Get the name of the file that this shard should write instead
+    /// of path, and record it in the manifest so that the launcher can merge
+    /// it. ".shardK" is inserted before the extension of ROOT files and
+    /// appended to other names.
+    static std::string OutputPath(const std::string& path, OutputType type);
+
+    /// @brief Get the per-shard name of a file without recording it, for
+    /// files that are kept for each shard rather than merged
+    static std::string ShardPath(const std::string& path, OutputType type);
+
+    /// @brief Declare that a tree in the ROOT file path (the name given to
+    /// OutputPath()) holds totals, with one row for each value of the integer
+    /// branch key_branch. When the shards are merged, rows with the same key
+    /// are combined by adding up their other branches instead of being
+    /// concatenated.
+    static void AddSummaryTree(const std::string& path,
+      const std::string& tree_name, const std::string& key_branch);
+
+    /// @brief For tools that load or generate events but cannot read only
+    /// this shard's part of their input. In sharding mode, prints an error,
+    /// records a failure and returns true, and the tool should then fail to
+    /// initialise.
+    static bool Unsupported(const std::string& tool_name);
+
+    /// @brief Record that a tool failed, so that the worker exits with an
+    /// error and the shard outputs are not merged
+    /// @param what The tool and the call that failed
+    static void RecordFailure(const std::string& what);
+
+    /// @brief Whether a failure has been recorded in this shard
+    static bool failed();
+
+    /// @brief Name of the manifest file for a shard
+    static std::string ManifestPath(const std::string& manifest_directory,
+      size_t index);
+
+    /// @brief Read a shard manifest
+    static bool ReadManifest(const std::string& filename,
+      std::vector<ManifestEntry>& entries,
+      std::vector<SummaryTree>& summary_trees);
+};
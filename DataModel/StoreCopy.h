@@ -0,0 +1,126 @@
+// Copies the contents of a BoostStore without decoding its values
+//
+// A BoostStore keeps every key as the binary archive of its value, and
+// serializes itself as the map from keys to those archives (see
+// BoostStore::serialize in ToolDAQFramework). Writing one store to an
+// archive and reading that archive back into another store therefore copies
+// every key byte for byte, whatever its type, without running the
+// serialization code of any value and without needing the catalogue in
+// ANNIEEventKeys.h. The archive can also be kept in a string and moved to
+// another thread before it is read (see archive_store() and
+// restore_store()), or read as a plain map to list the keys of a store.
+//
+// Both stores must have been made with the same typechecking setting (all
+// ANNIEEvent stores are made without it), since that decides whether the
+// type names are archived after the values. Objects given to a store by
+// pointer are only archived when the store is saved, so they are not
+// copied.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/string.hpp>
+
+// ToolAnalysis includes
+#include "BoostStore.h"
+
+/// @brief The part of a BoostStore's archive that holds its values, read
+/// without a BoostStore to list the keys
+struct StoreArchive {
+  std::map<std::string, std::string> variables;
+
+  template<class Archive> void serialize(Archive& ar,
+    const unsigned int /*version*/)
+  {
+    ar & variables;
+  }
+};
+
+/// @brief Write the contents of a store to a string, replacing what was in
+/// it
+/// @return false if the store could not be archived
+inline bool archive_store(const BoostStore& store, std::string& archive) {
+  archive.clear();
+  try {
+    boost::iostreams::stream< boost::iostreams::back_insert_device<
+      std::string> > out(archive);
+    {
+      boost::archive::binary_oarchive oa(out, boost::archive::no_header);
+      oa << store;
+    }
+    out.flush();
+  }
+  catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+/// @brief Replace the contents of a store with an archive written by
+/// archive_store()
+/// @return false if the archive could not be read
+inline bool restore_store(const std::string& archive, BoostStore& store) {
+  try {
+    boost::iostreams::stream<boost::iostreams::array_source> in(
+      archive.data(), archive.size());
+    boost::archive::binary_iarchive ia(in, boost::archive::no_header);
+    ia >> store;
+  }
+  catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+/// @brief Replace the contents of one store with those of another
+/// @return false if the store could not be archived
+inline bool copy_store(const BoostStore& from, BoostStore& to) {
+  std::string archive;
+  return archive_store(from, archive) && restore_store(archive, to);
+}
+
+/// @brief 64-bit FNV-1a hash of an archive, used to tell whether a store
+/// has changed since it was last archived
+inline uint64_t archive_hash(const std::string& archive) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : archive) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/// @brief Names of all of the keys in an archive written by archive_store()
+inline std::vector<std::string> archive_keys(const std::string& archive) {
+  std::vector<std::string> keys;
+  try {
+    boost::iostreams::stream<boost::iostreams::array_source> in(
+      archive.data(), archive.size());
+    StoreArchive contents;
+    boost::archive::binary_iarchive ia(in, boost::archive::no_header);
+    ia >> contents;
+    for (const auto& pair : contents.variables) keys.push_back(pair.first);
+  }
+  catch (const std::exception&) {}
+  return keys;
+}
+
+/// @brief Names of all of the keys in a store. Keys set by pointer are not
+/// included, since they are not archived.
+inline std::vector<std::string> store_keys(const BoostStore& store) {
+  std::string archive;
+  if ( !archive_store(store, archive) ) return std::vector<std::string>();
+  return archive_keys(archive);
+}
@@ -0,0 +1,92 @@
+// Typed, pre-resolved handle to a single key in one of the DataModel's
+// BoostStores
+//
+// Tools typically write m_data->Stores["ANNIEEvent"]->Get("RawADCData", obj)
+// on every event, which performs a std::map lookup on the store name, builds
+// a temporary std::string for the key, and leaves the type of obj unchecked.
+// A StoreHandle is created once (usually in a tool's Initialise() method)
+// using DataModel::Handle<T>(), and then gives typed access on each event
+// without repeating the store name lookup or rebuilding the key string.
+//
+// Only the Stores map slot is cached. Each Get/Set/Has still looks the key
+// up in the BoostStore's own map and (de)serializes the value, since the
+// BoostStore internals belong to ToolDAQFramework.
+//
+// The cached slot points into the Stores map, so an entry of that map must
+// not be erased while handles to it exist. To replace or drop a store,
+// assign a new BoostStore (or nullptr) to its entry instead; the handles
+// then see the new store.
+#pragma once
+
+// standard library includes
+#include <map>
+#include <string>
+
+// ToolAnalysis includes
+#include "BoostStore.h"
+
+template <typename T> class StoreHandle {
+
+  public:
+
+    inline StoreHandle() : stores_(nullptr), store_(nullptr),
+      slot_(nullptr) {}
+
+    /// @brief Create a handle to a key in the named entry of a store map
+    /// @details The store itself does not need to exist yet. Tools such as
+    /// LoadANNIEEvent create (and periodically replace) the ANNIEEvent store
+    /// in their Execute() methods, so the map slot is looked up on first use
+    /// and then cached. std::map nodes are never relocated, so the cached
+    /// slot stays valid when the BoostStore pointer stored in it changes.
+    inline StoreHandle(std::map<std::string, BoostStore*>& stores,
+      const std::string& store_name, const std::string& key)
+      : stores_(&stores), store_(nullptr), slot_(nullptr),
+      store_name_(store_name), key_(key) {}
+
+    /// @brief Create a handle to a key in a store that is owned directly,
+    /// e.g., the DataModel's CStore
+    inline StoreHandle(BoostStore& store, const std::string& key)
+      : stores_(nullptr), store_(&store), slot_(nullptr), key_(key) {}
+
+    /// @brief Returns a pointer to the store that this handle refers to, or
+    /// nullptr if that store does not currently exist (or its entry in the
+    /// Stores map holds nullptr)
+    inline BoostStore* store() const {
+      if (store_) return store_;
+      if (!slot_) {
+        if (!stores_) return nullptr;
+        auto iter = stores_->find(store_name_);
+        if ( iter == stores_->end() ) return nullptr;
+        slot_ = &iter->second;
+      }
+      return *slot_;
+    }
+
+    inline bool Get(T& out) const {
+      BoostStore* s = store();
+      return s && s->Get(key_, out);
+    }
+
+    inline bool Set(const T& in) const {
+      BoostStore* s = store();
+      if (!s) return false;
+      s->Set(key_, in);
+      return true;
+    }
+
+    inline bool Has() const {
+      BoostStore* s = store();
+      return s && s->Has(key_);
+    }
+
+    inline const std::string& key() const { return key_; }
+    inline const std::string& store_name() const { return store_name_; }
+
+  protected:
+
+    std::map<std::string, BoostStore*>* stores_;
+    BoostStore* store_;
+    mutable BoostStore** slot_;
+    std::string store_name_;
+    std::string key_;
+};
@@ -0,0 +1,339 @@
+// Per-key memory and size accounting for BoostStore contents
+//
+// A StoreStats object accumulates, for each key that is measured, the
+// estimated in-memory footprint of the deserialized object and the number of
+// bytes it occupies once serialized with a binary boost archive and once that
+// archive is gzip compressed. The in-memory footprint is estimated using the
+// MemoryEstimate trait, which understands the standard containers and the
+// ToolAnalysis classes that hold dynamically-sized data.
+//
+// The BoostStore class itself lives in ToolDAQFramework and does not expose
+// the types of its keys, so measure_annie_event() measures the known
+// ANNIEEvent keys listed in ANNIEEventKeys.h. The other keys of the store
+// (listed from its archive, see StoreCopy.h), those whose value is not of the
+// catalogued type, and those set by pointer are counted as not measured and
+// listed below the table. Keys that are not in the catalogue can be measured
+// explicitly with StoreStats::Measure().
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Boost includes
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+// ToolAnalysis includes
+#include "ANNIEEventKeys.h"
+#include "BoostStore.h"
+#include "CalibratedADCWaveform.h"
+#include "HeftyInfo.h"
+#include "PackedADCPulse.h"
+#include "StoreCopy.h"
+#include "Waveform.h"
+
+/// @brief Approximate per-node overhead (bytes) of a std::map node beyond
+/// the stored value (color, parent, left, and right pointers)
+constexpr size_t STD_MAP_NODE_OVERHEAD = 32u;
+
+/// @brief Estimates the number of heap bytes owned by an object, excluding
+/// sizeof(T) itself
+/// @details The generic version assumes that the object owns no heap memory.
+/// Specialize this trait for classes that own dynamically-sized data.
+template <typename T, typename Enable = void> struct MemoryEstimate {
+  static inline size_t heap_bytes(const T&) { return 0u; }
+};
+
+/// @brief Estimates the total number of bytes used by an object
+template <typename T> inline size_t estimate_memory(const T& obj) {
+  return sizeof(T) + MemoryEstimate<T>::heap_bytes(obj);
+}
+
+template <> struct MemoryEstimate<std::string> {
+  static inline size_t heap_bytes(const std::string& str) {
+    // Short strings are stored inline
+    return (str.capacity() > 15u) ? str.capacity() + 1u : 0u;
+  }
+};
+
+template <typename T> struct MemoryEstimate< std::vector<T> > {
+  static inline size_t heap_bytes(const std::vector<T>& vec) {
+    size_t bytes = vec.capacity() * sizeof(T);
+    for (const auto& element : vec) {
+      bytes += MemoryEstimate<T>::heap_bytes(element);
+    }
+    return bytes;
+  }
+};
+
+template <typename K, typename V> struct MemoryEstimate< std::map<K, V> > {
+  static inline size_t heap_bytes(const std::map<K, V>& m) {
+    size_t bytes = m.size() * ( STD_MAP_NODE_OVERHEAD
+      + sizeof(typename std::map<K, V>::value_type) );
+    for (const auto& pair : m) {
+      bytes += MemoryEstimate<K>::heap_bytes(pair.first);
+      bytes += MemoryEstimate<V>::heap_bytes(pair.second);
+    }
+    return bytes;
+  }
+};
+
+template <typename T> struct MemoryEstimate< Waveform<T> > {
+  static inline size_t heap_bytes(const Waveform<T>& wf) {
+    return MemoryEstimate< std::vector<T> >::heap_bytes( wf.Samples() );
+  }
+};
+
+template <typename T> struct MemoryEstimate< CalibratedADCWaveform<T> > {
+  static inline size_t heap_bytes(const CalibratedADCWaveform<T>& wf) {
+    return MemoryEstimate< std::vector<T> >::heap_bytes( wf.Samples() );
+  }
+};
+
+template <> struct MemoryEstimate<HeftyInfo> {
+  static inline size_t heap_bytes(const HeftyInfo& hi) {
+    // time_, label_, and t_since_beam_ each have one element per minibuffer
+    return hi.num_minibuffers() * ( sizeof(unsigned long long) + sizeof(int)
+      + sizeof(long long) );
+  }
+};
+
+template <> struct MemoryEstimate<PackedADCHits> {
+  static inline size_t heap_bytes(const PackedADCHits& hits) {
+    size_t bytes = 0u;
+    for (const auto& pair : hits.blocks()) {
+      bytes += STD_MAP_NODE_OVERHEAD + sizeof(pair);
+      bytes += pair.second.minibuffer_offsets.capacity() * sizeof(uint32_t);
+      bytes += pair.second.pulses.capacity() * sizeof(PackedADCPulse);
+    }
+    return bytes;
+  }
+};
+
+/// @brief Accumulated size information for a single Store key
+struct StoreKeyStats {
+  /// @brief Number of times the key was measured (usually one per entry)
+  uint64_t num_measurements = 0u;
+  /// @brief Sum of the estimated in-memory footprints (bytes)
+  uint64_t memory_bytes = 0u;
+  /// @brief Largest single in-memory footprint (bytes)
+  uint64_t peak_memory_bytes = 0u;
+  /// @brief Sum of the binary-archive sizes (bytes)
+  uint64_t serialized_bytes = 0u;
+  /// @brief Sum of the gzip-compressed binary-archive sizes (bytes)
+  uint64_t compressed_bytes = 0u;
+};
+
+class StoreStats {
+
+  public:
+
+    inline StoreStats(bool compress = true) : compress_(compress) {}
+
+    /// @brief Measure a single object stored (or about to be stored) under
+    /// a given key
+    template <typename T> void Measure(const std::string& key, const T& obj)
+    {
+      std::string archive;
+      {
+        std::ostringstream stream;
+        boost::archive::binary_oarchive oa(stream);
+        oa & obj;
+        archive = stream.str();
+      }
+
+      size_t compressed = 0u;
+      if (compress_) compressed = compressed_size(archive);
+
+      Record(key, estimate_memory(obj), archive.size(), compressed);
+    }
+
+    inline void Record(const std::string& key, size_t memory_bytes,
+      size_t serialized_bytes, size_t compressed_bytes)
+    {
+      StoreKeyStats& ks = stats_[key];
+      ++ks.num_measurements;
+      ks.memory_bytes += memory_bytes;
+      if (memory_bytes > ks.peak_memory_bytes) {
+        ks.peak_memory_bytes = memory_bytes;
+      }
+      ks.serialized_bytes += serialized_bytes;
+      ks.compressed_bytes += compressed_bytes;
+    }
+
+    /// @brief Count a key that was present but could not be measured
+    inline void RecordUnmeasured(const std::string& key) { ++unmeasured_[key]; }
+
+    inline const std::map<std::string, StoreKeyStats>& Stats() const
+      { return stats_; }
+
+    /// @brief Number of times each key could not be measured
+    inline const std::map<std::string, uint64_t>& Unmeasured() const
+      { return unmeasured_; }
+
+    inline void Clear() {
+      stats_.clear();
+      unmeasured_.clear();
+    }
+
+    /// @brief Print a table of per-key averages, sorted by key name
+    void Print(std::ostream& out = std::cout) const {
+      out << std::left << std::setw(28) << "Key" << std::right
+        << std::setw(8) << "N" << std::setw(14) << "Mem/entry"
+        << std::setw(14) << "PeakMem" << std::setw(14) << "Ser/entry"
+        << std::setw(14) << "Gz/entry" << std::setw(8) << "Gz%" << '\n';
+
+      StoreKeyStats total;
+      for (const auto& pair : stats_) {
+        const StoreKeyStats& ks = pair.second;
+        print_row(out, pair.first, ks);
+        total.memory_bytes += ks.memory_bytes;
+        total.peak_memory_bytes += ks.peak_memory_bytes;
+        total.serialized_bytes += ks.serialized_bytes;
+        total.compressed_bytes += ks.compressed_bytes;
+        if (ks.num_measurements > total.num_measurements) {
+          total.num_measurements = ks.num_measurements;
+        }
+      }
+      print_row(out, "TOTAL", total);
+
+      if ( unmeasured_.empty() ) return;
+      out << "Not measured (not catalogued, of another type, or set by"
+        " pointer):\n";
+      for (const auto& pair : unmeasured_) {
+        out << std::left << std::setw(28) << pair.first << std::right
+          << std::setw(8) << pair.second << '\n';
+      }
+    }
+
+  protected:
+
+    /// @brief Returns the size of a gzip-compressed copy of a string
+    static size_t compressed_size(const std::string& data) {
+
+      struct ByteCounter {
+        typedef char char_type;
+        typedef boost::iostreams::sink_tag category;
+        size_t* count;
+        std::streamsize write(const char*, std::streamsize n)
+          { *count += n; return n; }
+      };
+
+      size_t count = 0u;
+      boost::iostreams::filtering_ostream gz;
+      gz.push(boost::iostreams::gzip_compressor());
+      gz.push(ByteCounter{&count});
+      gz.write(data.data(), data.size());
+      gz.reset();
+      return count;
+    }
+
+    static void print_row(std::ostream& out, const std::string& key,
+      const StoreKeyStats& ks)
+    {
+      double n = (ks.num_measurements > 0u) ? ks.num_measurements : 1.;
+      double gz_pct = (ks.serialized_bytes > 0u) ? 100. * ks.compressed_bytes
+        / ks.serialized_bytes : 0.;
+      out << std::left << std::setw(28) << key << std::right
+        << std::setw(8) << ks.num_measurements
+        << std::setw(14) << static_cast<uint64_t>(ks.memory_bytes / n)
+        << std::setw(14) << ks.peak_memory_bytes
+        << std::setw(14) << static_cast<uint64_t>(ks.serialized_bytes / n)
+        << std::setw(14) << static_cast<uint64_t>(ks.compressed_bytes / n)
+        << std::setw(8) << std::fixed << std::setprecision(1) << gz_pct
+        << '\n';
+    }
+
+    bool compress_;
+    std::map<std::string, StoreKeyStats> stats_;
+    std::map<std::string, uint64_t> unmeasured_;
+};
+
+/// @brief Load a key of a known type from a Store and measure it. Returns
+/// false if the key is absent or could not be loaded as a T.
+template <typename T> bool measure_store_key(BoostStore& store,
+  const std::string& key, StoreStats& stats)
+{
+  if ( !store.Has(key) ) return false;
+  try {
+    T obj;
+    if ( !store.Get(key, obj) ) return false;
+    stats.Measure(key, obj);
+  }
+  catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+/// @brief Visitor that measures each ANNIEEvent key that it is given
+class StoreStatsVisitor {
+  public:
+    /// @param archived_keys Keys found in the archive of the store
+    inline StoreStatsVisitor(BoostStore& store, StoreStats& stats,
+      const std::set<std::string>& archived_keys)
+      : store_(store), stats_(stats), archived_keys_(archived_keys) {}
+
+    template <typename T> bool visit(const std::string& key) {
+      if ( !archived_keys_.count(key) ) {
+        // A key set by pointer is not archived. The pointer may be to any of
+        // the candidate types of the key, so the object is not measured.
+        T* object = nullptr;
+        if ( !store_.Get(key, object) ) return false;
+        stats_.RecordUnmeasured(key);
+        return true;
+      }
+      if ( !measure_store_key<T>(store_, key, stats_) ) return false;
+      measured_keys_.insert(key);
+      return true;
+    }
+
+    /// @brief Count the archived keys that were not measured
+    inline void record_unmeasured() const {
+      for (const auto& key : archived_keys_) {
+        if ( !measured_keys_.count(key) ) stats_.RecordUnmeasured(key);
+      }
+    }
+
+  protected:
+    BoostStore& store_;
+    StoreStats& stats_;
+    const std::set<std::string>& archived_keys_;
+    std::set<std::string> measured_keys_;
+};
+
+/// @brief Keys found in the archive of a store
+inline std::set<std::string> archived_store_keys(const BoostStore& store) {
+  std::vector<std::string> keys = store_keys(store);
+  return std::set<std::string>(keys.begin(), keys.end());
+}
+
+/// @brief Measure the known ANNIEEvent keys present in the current entry of
+/// an ANNIEEvent store, and count the other keys as not measured
+inline void measure_annie_event(BoostStore& store, StoreStats& stats) {
+  std::set<std::string> archived_keys = archived_store_keys(store);
+  StoreStatsVisitor visitor(store, stats, archived_keys);
+  visit_annie_event_keys(visitor);
+  visitor.record_unmeasured();
+}
+
+/// @brief Measure the known keys in the header of an ANNIEEvent store, and
+/// count the other keys (except TotalEntries) as not measured
+inline void measure_annie_event_header(BoostStore& header, StoreStats& stats)
+{
+  std::set<std::string> archived_keys = archived_store_keys(header);
+  archived_keys.erase("TotalEntries");
+  StoreStatsVisitor visitor(header, stats, archived_keys);
+  visit_annie_event_header_keys(visitor);
+  visitor.record_unmeasured();
+}
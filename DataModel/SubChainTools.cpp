@@ -0,0 +1,46 @@
+// standard library includes
+#include <fstream>
+#include <sstream>
+
+// ToolAnalysis includes
+#include "SubChainTools.h"
+
+namespace {
+  std::string the_main_tools_file;
+}
+
+bool load_sub_chain_tools(const std::string& filename,
+  std::vector<SubChainToolEntry>& entries, std::string& error)
+{
+  std::ifstream in(filename);
+  if ( !in.good() ) {
+    error = "could not open the tools file \"" + filename + '\"';
+    return false;
+  }
+
+  std::string line;
+  while ( std::getline(in, line) ) {
+    size_t comment = line.find('#');
+    if ( comment != std::string::npos ) line.erase(comment);
+
+    std::istringstream words(line);
+    SubChainToolEntry entry;
+    if ( !(words >> entry.name) ) continue; // blank line
+    if ( !(words >> entry.tool_class >> entry.config_file) ) {
+      error = "incomplete line \"" + line + "\" in the tools file \""
+        + filename + '\"';
+      return false;
+    }
+    entries.push_back(entry);
+  }
+
+  return true;
+}
+
+void set_main_tools_file(const std::string& filename) {
+  the_main_tools_file = filename;
+}
+
+const std::string& main_tools_file() {
+  return the_main_tools_file;
+}
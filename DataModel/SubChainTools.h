@@ -0,0 +1,32 @@
+// Lists of tools run by tools that contain their own tools
+//
+// ParallelSubChain and Pipeline read the tools that they run from files in
+// the same format as a ToolsConfig file: "name class configfile" on each
+// line, with # starting a comment.
+#pragma once
+
+// standard library includes
+#include <string>
+#include <vector>
+
+/// @brief One line of a ToolsConfig file
+struct SubChainToolEntry {
+  std::string name;
+  std::string tool_class;
+  std::string config_file;
+};
+
+/// @brief Read a file in the ToolsConfig format, adding its tools to entries
+/// @return false (with a message in error) if the file could not be read
+bool load_sub_chain_tools(const std::string& filename,
+  std::vector<SubChainToolEntry>& entries, std::string& error);
+
+/// @brief Record the ToolsConfig file of the main ToolChain, so that a tool
+/// can check where it has been put in it. Called by main() before the
+/// ToolChain is created, since the ToolChain does not pass its configuration
+/// on to the tools.
+void set_main_tools_file(const std::string& filename);
+
+/// @brief ToolsConfig file of the main ToolChain, or an empty string if it
+/// was not recorded
+const std::string& main_tools_file();
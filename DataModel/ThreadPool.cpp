@@ -0,0 +1,211 @@
+// standard library includes
+#include <chrono>
+
+// ToolAnalysis includes
+#include "ThreadPool.h"
+#include "Tracer.h"
+
+namespace {
+
+  // Size used when the shared pool is created
+  std::atomic<size_t> default_pool_size(1u);
+
+  // Index of the worker queue owned by the current thread, or -1 if the
+  // current thread is not a worker of the pool below
+  thread_local int current_worker = -1;
+  thread_local const ThreadPool* current_pool = nullptr;
+
+  // How long a waiting thread sleeps before looking for tasks to steal
+  constexpr std::chrono::microseconds WAIT_POLL_INTERVAL(200);
+}
+
+ThreadPool::ThreadPool(size_t num_threads) : num_queued_(0u), stop_(false)
+{
+  if ( num_threads == 0u ) num_threads = std::thread::hardware_concurrency();
+  if ( num_threads == 0u ) num_threads = 1u;
+
+  size_t num_workers = num_threads - 1u;
+  for (size_t w = 0; w <= num_workers; ++w) {
+    queues_.emplace_back( new WorkQueue );
+  }
+  for (size_t w = 0; w < num_workers; ++w) {
+    workers_.emplace_back(&ThreadPool::Run, this, w);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+  sleep_cond_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+ThreadPool& ThreadPool::Shared() {
+  static ThreadPool pool( default_pool_size.load() );
+  return pool;
+}
+
+void ThreadPool::SetDefaultSize(size_t num_threads) {
+  default_pool_size = num_threads;
+}
+
+size_t ThreadPool::DefaultSize() {
+  return default_pool_size.load();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+
+  size_t queue_index = queues_.size() - 1u;
+  if ( current_pool == this && current_worker >= 0 ) {
+    queue_index = current_worker;
+  }
+
+  // Count the task before it can be taken, so that TakeTask() never
+  // decrements the count below zero. A thread that sees the count first
+  // just finds no task until the push below.
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    ++num_queued_;
+  }
+
+  {
+    WorkQueue& queue = *queues_.at(queue_index);
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back( std::move(task) );
+  }
+  sleep_cond_.notify_one();
+}
+
+bool ThreadPool::TakeTask(size_t queue_index, std::function<void()>& task) {
+
+  if ( num_queued_ == 0u ) return false;
+
+  // Newest task from our own queue, since its data is most likely to still
+  // be in the cache
+  if ( queue_index < queues_.size() ) {
+    WorkQueue& queue = *queues_.at(queue_index);
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if ( !queue.tasks.empty() ) {
+      task = std::move( queue.tasks.back() );
+      queue.tasks.pop_back();
+      --num_queued_;
+      return true;
+    }
+  }
+
+  // Otherwise steal the oldest task from another queue
+  for (size_t offset = 1; offset <= queues_.size(); ++offset) {
+    size_t victim = (queue_index + offset) % queues_.size();
+    WorkQueue& queue = *queues_.at(victim);
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if ( !queue.tasks.empty() ) {
+      task = std::move( queue.tasks.front() );
+      queue.tasks.pop_front();
+      --num_queued_;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ThreadPool::RunPendingTask() {
+
+  size_t queue_index = queues_.size() - 1u;
+  if ( current_pool == this && current_worker >= 0 ) {
+    queue_index = current_worker;
+  }
+
+  std::function<void()> task;
+  if ( !TakeTask(queue_index, task) ) return false;
+  task();
+  return true;
+}
+
+void ThreadPool::Run(size_t worker_index) {
+
+  current_worker = worker_index;
+  current_pool = this;
+  Tracer::SetThreadName("Thread pool worker " + std::to_string(worker_index));
+
+  while (true) {
+    std::function<void()> task;
+    if ( TakeTask(worker_index, task) ) {
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleep_cond_.wait(lock, [this]{ return num_queued_ > 0u || stop_; });
+    if ( stop_ && num_queued_ == 0u ) return;
+  }
+}
+
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool_(pool), num_pending_(0u) {}
+
+TaskGroup::~TaskGroup() {
+  WaitForTasks();
+}
+
+void TaskGroup::Run(std::function<void()> task) {
+
+  // Without worker threads, there is nobody else to run the task
+  if ( pool_.size() == 1u ) {
+    try {
+      task();
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if ( !error_ ) error_ = std::current_exception();
+    }
+    return;
+  }
+
+  ++num_pending_;
+  pool_.Submit( [this, task]() {
+    try {
+      task();
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if ( !error_ ) error_ = std::current_exception();
+    }
+    // Hold the lock while decrementing so that the group cannot be
+    // destroyed by a waiting thread before notify_all() returns
+    std::lock_guard<std::mutex> lock(mutex_);
+    --num_pending_;
+    cond_.notify_all();
+  } );
+}
+
+void TaskGroup::Wait() {
+  WaitForTasks();
+
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(error, error_);
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+void TaskGroup::WaitForTasks() {
+
+  while ( num_pending_ > 0u ) {
+
+    // Help out rather than sleeping. The task may belong to another group.
+    if ( pool_.RunPendingTask() ) continue;
+
+    // Our remaining tasks are running on other threads. Wake up
+    // occasionally in case they queue nested tasks that we could steal.
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait_for(lock, WAIT_POLL_INTERVAL,
+      [this]{ return num_pending_ == 0u; });
+  }
+
+  // Make sure the last task has released the lock before returning
+  std::lock_guard<std::mutex> lock(mutex_);
+}
@@ -0,0 +1,175 @@
+// Work-stealing thread pool shared by all tools
+//
+// Tools that can split the work for one event into independent pieces (e.g.,
+// one piece per channel) should use the pool returned by DataModel::Pool()
+// rather than starting their own threads, so that the machine is not
+// oversubscribed. There is a single pool per process, shared by every
+// DataModel (including the private DataModels used by ParallelSubChain and
+// Pipeline). Its size is set by ThreadPoolSize in the ToolChainConfig file:
+//
+//   ThreadPoolSize 8 # threads used for work within an event (0 = one per
+//                    # core, 1 = run everything on the calling thread)
+//
+// The thread that waits for a parallel_for() or TaskGroup also runs tasks,
+// so the pool has ThreadPoolSize - 1 worker threads, and parallel loops may
+// be nested without deadlocking.
+//
+// Rules for using ROOT inside tasks:
+//   * Call enable_root_thread_safety() (see ROOTTreeOutput.h), which calls
+//     ROOT::EnableThreadSafety(), in the tool's Initialise() before any task
+//     uses ROOT.
+//   * Do not create named objects (histograms, functions, graphs) inside a
+//     task unless TH1::AddDirectory(false) has been called, and never give
+//     two tasks objects with the same name.
+//   * Do not fill shared histograms or trees, or write to TFiles, from
+//     tasks. Return the results and fill them after the loop.
+//   * Avoid ROOT interfaces that keep global state, such as
+//     TVirtualFFT::GetCurrentTransform(), gRandom, and the default fitter.
+#pragma once
+
+// standard library includes
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+class ThreadPool {
+
+  public:
+
+    /// @param num_threads Total number of threads that run tasks, including
+    /// the thread that waits for them. Zero means one per core.
+    explicit ThreadPool(size_t num_threads);
+
+    /// @brief Finishes any queued tasks and stops the worker threads
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// @brief The pool shared by the whole process (created on first use
+    /// with DefaultSize() threads)
+    static ThreadPool& Shared();
+
+    /// @brief Set the size of the shared pool. Only has an effect before the
+    /// shared pool is first used.
+    static void SetDefaultSize(size_t num_threads);
+    static size_t DefaultSize();
+
+    /// @brief Total number of threads that run tasks (workers plus the
+    /// waiting thread)
+    inline size_t size() const { return workers_.size() + 1u; }
+
+    /// @brief Call func(i) for every i in [begin, end), splitting the range
+    /// into chunks of at least grain indices that run in parallel. Returns
+    /// when every call has finished. If any call throws, the first exception
+    /// is rethrown here.
+    template <typename Function> void parallel_for(size_t begin, size_t end,
+      const Function& func, size_t grain = 0u);
+
+    /// @brief Run one queued task on the calling thread, if there is one
+    /// @return false if no task was available
+    bool RunPendingTask();
+
+  protected:
+
+    friend class TaskGroup;
+
+    /// @brief Queue a task. Tasks submitted from a worker thread go to that
+    /// worker's own queue; others go to a shared queue.
+    void Submit(std::function<void()> task);
+
+    /// @brief Take a task from the queue of the given worker (newest first)
+    /// or steal one from another queue (oldest first)
+    bool TakeTask(size_t queue_index, std::function<void()>& task);
+
+    /// @brief Function run by each worker thread
+    void Run(size_t worker_index);
+
+    struct WorkQueue {
+      std::mutex mutex;
+      std::deque< std::function<void()> > tasks;
+    };
+
+    /// @brief One queue per worker, plus one (the last) for tasks submitted
+    /// by other threads
+    std::vector< std::unique_ptr<WorkQueue> > queues_;
+    std::vector<std::thread> workers_;
+
+    /// @brief Number of tasks waiting in all queues. Incremented before a
+    /// task is pushed, so it may briefly count a task that is not there yet.
+    std::atomic<size_t> num_queued_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cond_;
+    bool stop_;
+};
+
+/// @brief A set of tasks that can be waited for together
+class TaskGroup {
+
+  public:
+
+    explicit TaskGroup(ThreadPool& pool);
+
+    /// @brief Waits for any tasks that are still running. Exceptions
+    /// thrown by them are discarded; call Wait() to see them.
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /// @brief Queue a task in the pool (or run it immediately if the pool
+    /// has no worker threads)
+    void Run(std::function<void()> task);
+
+    /// @brief Run queued tasks on this thread until every task in the group
+    /// has finished, then rethrow the first exception thrown by a task (if
+    /// any)
+    void Wait();
+
+  protected:
+
+    /// @brief Wait without rethrowing
+    void WaitForTasks();
+
+    ThreadPool& pool_;
+    std::atomic<size_t> num_pending_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::exception_ptr error_;
+};
+
+template <typename Function> void ThreadPool::parallel_for(size_t begin,
+  size_t end, const Function& func, size_t grain)
+{
+  if ( end <= begin ) return;
+  size_t count = end - begin;
+
+  // By default, aim for a few chunks per thread so that idle threads can
+  // steal work from busy ones
+  if ( grain == 0u ) grain = std::max<size_t>(1u, count / (4u * size()));
+
+  if ( size() == 1u || count <= grain ) {
+    for (size_t i = begin; i < end; ++i) func(i);
+    return;
+  }
+
+  TaskGroup group(*this);
+  for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += grain) {
+    size_t chunk_end = std::min(end, chunk_begin + grain);
+    group.Run( [&func, chunk_begin, chunk_end]() {
+      for (size_t i = chunk_begin; i < chunk_end; ++i) func(i);
+    } );
+  }
+  group.Wait();
+}
@@ -0,0 +1,411 @@
+// standard library includes
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+
+// ROOT includes
+#include "TFile.h"
+#include "TH1D.h"
+#include "TTree.h"
+
+// ToolAnalysis includes
+#include "AllocationTracker.h"
+#include "Sharding.h"
+#include "ToolProfiler.h"
+
+namespace {
+
+  const char* const PHASE_NAMES[ToolProfiler::NUM_PHASES]
+    = { "Initialise", "Execute", "Finalise" };
+
+  // Durations are reported in milliseconds
+  double to_ms(uint64_t ns) { return ns * 1e-6; }
+
+  bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size()
+      && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+      if ( c == '"' || c == '\\' ) out += '\\';
+      if ( static_cast<unsigned char>(c) < 0x20 ) {
+        char buffer[8];
+        std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+        out += buffer;
+      }
+      else out += c;
+    }
+    return out + '"';
+  }
+}
+
+LatencyHistogram::LatencyHistogram() : counts_(64u * SUB_BUCKETS, 0u),
+  count_(0u), total_ns_(0u), max_ns_(0u) {}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (size_t b = 0; b < counts_.size(); ++b) counts_[b] += other.counts_[b];
+  count_ += other.count_;
+  total_ns_ += other.total_ns_;
+  if ( other.max_ns_ > max_ns_ ) max_ns_ = other.max_ns_;
+}
+
+uint64_t LatencyHistogram::BucketLow(size_t b) {
+  if ( b < SUB_BUCKETS ) return b;
+  int exponent = b / SUB_BUCKETS + SUB_BITS - 1;
+  uint64_t sub = b % SUB_BUCKETS;
+  return (SUB_BUCKETS + sub) << (exponent - SUB_BITS);
+}
+
+uint64_t LatencyHistogram::BucketHigh(size_t b) {
+  if ( b < SUB_BUCKETS ) return b;
+  int exponent = b / SUB_BUCKETS + SUB_BITS - 1;
+  return BucketLow(b) + (uint64_t(1) << (exponent - SUB_BITS)) - 1u;
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const {
+  if ( count_ == 0u ) return 0u;
+  uint64_t rank = static_cast<uint64_t>( std::ceil(p * count_) );
+  if ( rank < 1u ) rank = 1u;
+  uint64_t seen = 0u;
+  for (size_t b = 0; b < counts_.size(); ++b) {
+    seen += counts_[b];
+    // Every call in the bucket took at most BucketHigh(b), and none took
+    // longer than the maximum
+    if ( seen >= rank ) return std::min(BucketHigh(b), max_ns_);
+  }
+  return max_ns_;
+}
+
+ToolProfiler& ToolProfiler::Shared() {
+  static ToolProfiler profiler;
+  return profiler;
+}
+
+ToolProfiler::ToolProfiler() : enabled_(false), active_tools_(0) {}
+
+void ToolProfiler::Configure(bool enabled, const std::string& output_file) {
+  enabled_ = enabled;
+  output_file_ = output_file;
+}
+
+void ToolProfiler::Started() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++active_tools_;
+}
+
+void ToolProfiler::Finished(const ToolStats& stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::string key = stats.tool_class + '|' + stats.config_file;
+  auto found = tool_indices_.find(key);
+  if ( found == tool_indices_.end() ) {
+    tool_indices_[key] = tools_.size();
+    tools_.push_back(stats);
+  }
+  else {
+    ToolStats& merged = tools_.at(found->second);
+    bool slower = stats.phases[EXECUTE].max_ns()
+      > merged.phases[EXECUTE].max_ns();
+    for (int p = 0; p < NUM_PHASES; ++p) {
+      merged.phases[p].Merge(stats.phases[p]);
+    }
+    for (int c = 0; c < PerfCounters::NUM_COUNTERS; ++c) {
+      merged.counter_totals[c] += stats.counter_totals[c];
+      merged.counter_valid[c] |= stats.counter_valid[c];
+    }
+    merged.counted_calls += stats.counted_calls;
+    if ( slower ) {
+      merged.slowest_call = stats.slowest_call;
+      merged.slowest_event = stats.slowest_event;
+      merged.has_slowest_event = stats.has_slowest_event;
+    }
+  }
+
+  if ( --active_tools_ > 0 ) return;
+
+  Report(std::cout);
+  if ( !output_file_.empty() ) Write(output_file_);
+}
+
+std::vector<ToolProfiler::ToolStats> ToolProfiler::Tools() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tools_;
+}
+
+std::string ToolProfiler::Label(const ToolStats& stats) const {
+  size_t configurations = 0u;
+  for (const auto& tool : tools_) {
+    if ( tool.tool_class == stats.tool_class ) ++configurations;
+  }
+  if ( configurations < 2u ) return stats.tool_class;
+  return stats.tool_class + " (" + stats.config_file + ')';
+}
+
+void ToolProfiler::Report(std::ostream& out) {
+  out << "Tool profile (wall time per call in ms):\n";
+  char line[256];
+  std::snprintf(line, sizeof(line), "%-30s %-10s %8s %11s %10s %10s %10s"
+    " %10s %10s  %s\n", "Tool", "Phase", "Calls", "Total", "Mean", "p50",
+    "p90", "p99", "Max", "Slowest call");
+  out << line;
+
+  for (const auto& tool : tools_) {
+    std::string label = Label(tool);
+    for (int p = 0; p < NUM_PHASES; ++p) {
+      const LatencyHistogram& hist = tool.phases[p];
+      if ( hist.count() == 0u ) continue;
+
+      std::string slowest;
+      if ( p == EXECUTE ) {
+        slowest = '#' + std::to_string(tool.slowest_call);
+        if ( tool.has_slowest_event ) {
+          slowest += " (EventNumber " + std::to_string(tool.slowest_event)
+            + ')';
+        }
+      }
+
+      std::snprintf(line, sizeof(line), "%-30s %-10s %8llu %11.3f %10.3f"
+        " %10.3f %10.3f %10.3f %10.3f  %s\n", label.c_str(), PHASE_NAMES[p],
+        static_cast<unsigned long long>( hist.count() ),
+        to_ms( hist.total_ns() ), to_ms( hist.total_ns() ) / hist.count(),
+        to_ms( hist.Percentile(0.5) ), to_ms( hist.Percentile(0.9) ),
+        to_ms( hist.Percentile(0.99) ), to_ms( hist.max_ns() ),
+        slowest.c_str());
+      out << line;
+      label.clear();
+    }
+  }
+
+  bool have_counters = false;
+  for (const auto& tool : tools_) have_counters |= (tool.counted_calls > 0u);
+  if (have_counters) {
+    out << "Hardware counters per Execute call:\n";
+    std::snprintf(line, sizeof(line), "%-30s %8s %14s %14s %7s %14s %14s\n",
+      "Tool", "Calls", "Cycles", "Instructions", "IPC", "Cache misses",
+      "Branch misses");
+    out << line;
+
+    for (const auto& tool : tools_) {
+      if ( tool.counted_calls == 0u ) continue;
+      std::string columns[PerfCounters::NUM_COUNTERS];
+      for (int c = 0; c < PerfCounters::NUM_COUNTERS; ++c) {
+        columns[c] = tool.counter_valid[c] ? std::to_string(
+          tool.counter_totals[c] / tool.counted_calls) : "n/a";
+      }
+      std::string ipc = "n/a";
+      if ( tool.counter_valid[PerfCounters::CYCLES]
+        && tool.counter_valid[PerfCounters::INSTRUCTIONS]
+        && tool.counter_totals[PerfCounters::CYCLES] > 0u )
+      {
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "%.2f",
+          double( tool.counter_totals[PerfCounters::INSTRUCTIONS] )
+          / tool.counter_totals[PerfCounters::CYCLES]);
+        ipc = buffer;
+      }
+      std::snprintf(line, sizeof(line), "%-30s %8llu %14s %14s %7s %14s"
+        " %14s\n", Label(tool).c_str(),
+        static_cast<unsigned long long>(tool.counted_calls),
+        columns[PerfCounters::CYCLES].c_str(),
+        columns[PerfCounters::INSTRUCTIONS].c_str(), ipc.c_str(),
+        columns[PerfCounters::CACHE_MISSES].c_str(),
+        columns[PerfCounters::BRANCH_MISSES].c_str());
+      out << line;
+    }
+  }
+
+  if ( AllocationTracker::enabled() ) {
+    out << "Heap allocations (operator new):\n";
+    std::snprintf(line, sizeof(line), "%-30s %12s %14s %12s %14s %14s"
+      " %14s\n", "Tool", "Allocations", "Bytes", "Allocs/event",
+      "Bytes/event", "Peak live", "Still live");
+    out << line;
+
+    for (const auto& tool : tools_) {
+      AllocationStats allocs;
+      if ( !AllocationTracker::Get(tool.tool_class + '|' + tool.config_file,
+        allocs) ) continue;
+      uint64_t events = tool.phases[EXECUTE].count();
+      std::snprintf(line, sizeof(line), "%-30s %12llu %14llu %12.1f %14.1f"
+        " %14lld %14lld\n", Label(tool).c_str(),
+        static_cast<unsigned long long>(allocs.allocations),
+        static_cast<unsigned long long>(allocs.bytes),
+        events ? double(allocs.execute_allocations) / events : 0.,
+        events ? double(allocs.execute_bytes) / events : 0.,
+        static_cast<long long>(allocs.peak_live_bytes),
+        static_cast<long long>(allocs.live_bytes));
+      out << line;
+    }
+  }
+  out << std::flush;
+}
+
+bool ToolProfiler::Write(const std::string& filename) {
+  // Each shard keeps its own profile, since merging the summary trees would
+  // not give the right percentiles
+  if ( ends_with(filename, ".json") ) {
+    if ( Sharding::enabled() ) {
+      return WriteJSON( filename + ".shard" + std::to_string(
+        Sharding::index() ) );
+    }
+    return WriteJSON(filename);
+  }
+  return WriteROOT( Sharding::ShardPath(filename,
+    Sharding::OutputType::ROOTFile) );
+}
+
+bool ToolProfiler::WriteJSON(const std::string& filename) {
+  std::ofstream out(filename);
+  if ( !out.good() ) {
+    std::cerr << "Error: Could not open the tool profile file "
+      << filename << '\n';
+    return false;
+  }
+
+  out << "{\n  \"unit\": \"ms\",\n  \"tools\": [";
+  for (size_t t = 0; t < tools_.size(); ++t) {
+    const ToolStats& tool = tools_.at(t);
+    out << (t == 0u ? "\n" : ",\n") << "    {\"name\": "
+      << json_string( Label(tool) ) << ", \"class\": "
+      << json_string(tool.tool_class) << ", \"config\": "
+      << json_string(tool.config_file);
+    for (int p = 0; p < NUM_PHASES; ++p) {
+      const LatencyHistogram& hist = tool.phases[p];
+      out << ",\n      \"" << PHASE_NAMES[p] << "\": {\"calls\": "
+        << hist.count() << ", \"total\": " << to_ms( hist.total_ns() )
+        << ", \"p50\": " << to_ms( hist.Percentile(0.5) )
+        << ", \"p90\": " << to_ms( hist.Percentile(0.9) )
+        << ", \"p99\": " << to_ms( hist.Percentile(0.99) )
+        << ", \"max\": " << to_ms( hist.max_ns() ) << '}';
+    }
+    out << ",\n      \"slowest_call\": " << tool.slowest_call;
+    if ( tool.has_slowest_event ) {
+      out << ", \"slowest_event\": " << tool.slowest_event;
+    }
+    AllocationStats allocs;
+    if ( AllocationTracker::Get(tool.tool_class + '|' + tool.config_file,
+      allocs) )
+    {
+      out << ",\n      \"allocations\": {\"count\": " << allocs.allocations
+        << ", \"bytes\": " << allocs.bytes << ", \"execute_count\": "
+        << allocs.execute_allocations << ", \"execute_bytes\": "
+        << allocs.execute_bytes << ", \"peak_live_bytes\": "
+        << allocs.peak_live_bytes << ", \"live_bytes\": "
+        << allocs.live_bytes << '}';
+    }
+    if ( tool.counted_calls > 0u ) {
+      // Totals over the Execute calls in which the counters were read
+      out << ",\n      \"counters\": {\"calls\": " << tool.counted_calls;
+      for (int c = 0; c < PerfCounters::NUM_COUNTERS; ++c) {
+        if ( !tool.counter_valid[c] ) continue;
+        std::string name = PerfCounters::Name(
+          static_cast<PerfCounters::Counter>(c) );
+        for (char& ch : name) if ( ch == ' ' ) ch = '_';
+        out << ", \"" << name << "\": " << tool.counter_totals[c];
+      }
+      out << '}';
+    }
+    out << '}';
+  }
+  out << "\n  ]\n}\n";
+  return out.good();
+}
+
+bool ToolProfiler::WriteROOT(const std::string& filename) {
+  std::unique_ptr<TFile> file( TFile::Open(filename.c_str(), "RECREATE") );
+  if ( !file || file->IsZombie() ) {
+    std::cerr << "Error: Could not open the tool profile file "
+      << filename << '\n';
+    return false;
+  }
+
+  // Summary tree with one entry per tool and phase
+  TTree* tree = new TTree("ToolProfile", "Tool timings (ms)");
+  std::string tree_tool, tree_phase;
+  ULong64_t calls, slowest_call, slowest_event;
+  double total, p50, p90, p99, max;
+  tree->Branch("tool", &tree_tool);
+  tree->Branch("phase", &tree_phase);
+  tree->Branch("calls", &calls, "calls/l");
+  tree->Branch("total", &total, "total/D");
+  tree->Branch("p50", &p50, "p50/D");
+  tree->Branch("p90", &p90, "p90/D");
+  tree->Branch("p99", &p99, "p99/D");
+  tree->Branch("max", &max, "max/D");
+  tree->Branch("slowest_call", &slowest_call, "slowest_call/l");
+  tree->Branch("slowest_event", &slowest_event, "slowest_event/l");
+  // Mean hardware counts per Execute call, or -1 if not measured
+  double counters[PerfCounters::NUM_COUNTERS];
+  tree->Branch("cycles", &counters[PerfCounters::CYCLES], "cycles/D");
+  tree->Branch("instructions", &counters[PerfCounters::INSTRUCTIONS],
+    "instructions/D");
+  tree->Branch("cache_misses", &counters[PerfCounters::CACHE_MISSES],
+    "cache_misses/D");
+  tree->Branch("branch_misses", &counters[PerfCounters::BRANCH_MISSES],
+    "branch_misses/D");
+
+  std::set<std::string> hist_names;
+  for (const auto& tool : tools_) {
+    for (int p = 0; p < NUM_PHASES; ++p) {
+      const LatencyHistogram& hist = tool.phases[p];
+      if ( hist.count() == 0u ) continue;
+
+      tree_tool = Label(tool);
+      tree_phase = PHASE_NAMES[p];
+      calls = hist.count();
+      total = to_ms( hist.total_ns() );
+      p50 = to_ms( hist.Percentile(0.5) );
+      p90 = to_ms( hist.Percentile(0.9) );
+      p99 = to_ms( hist.Percentile(0.99) );
+      max = to_ms( hist.max_ns() );
+      slowest_call = (p == EXECUTE) ? tool.slowest_call : 0u;
+      slowest_event = (p == EXECUTE && tool.has_slowest_event)
+        ? tool.slowest_event : 0u;
+      for (int c = 0; c < PerfCounters::NUM_COUNTERS; ++c) {
+        bool measured = ( p == EXECUTE && tool.counted_calls > 0u
+          && tool.counter_valid[c] );
+        counters[c] = measured ? double( tool.counter_totals[c] )
+          / tool.counted_calls : -1.;
+      }
+      tree->Fill();
+
+      // Latency distribution, using the non-empty range of buckets as
+      // variable-width bins
+      size_t first = hist.num_buckets(), last = 0u;
+      for (size_t b = 0; b < hist.num_buckets(); ++b) {
+        if ( hist.bucket_count(b) == 0u ) continue;
+        if ( first > b ) first = b;
+        last = b;
+      }
+      std::vector<double> edges;
+      for (size_t b = first; b <= last; ++b) {
+        edges.push_back( to_ms( LatencyHistogram::BucketLow(b) ) );
+      }
+      edges.push_back( to_ms( LatencyHistogram::BucketHigh(last) + 1u ) );
+
+      // Histogram names must be unique within the file
+      std::string name = tree_tool + '_' + tree_phase;
+      for (char& c : name) if ( !std::isalnum( (unsigned char) c ) ) c = '_';
+      while ( !hist_names.insert(name).second ) name += '_';
+
+      TH1D* latency = new TH1D(name.c_str(), (tree_tool + ' ' + tree_phase
+        + ";Wall time per call (ms);Calls").c_str(), edges.size() - 1u,
+        edges.data());
+      for (size_t b = first; b <= last; ++b) {
+        latency->SetBinContent(b - first + 1, hist.bucket_count(b));
+      }
+      latency->SetEntries(hist.count());
+    }
+  }
+
+  file->Write();
+  file->Close();
+  return true;
+}
@@ -0,0 +1,150 @@
+// Wall-clock timing of the Initialise, Execute and Finalise calls of every
+// tool
+//
+// When ToolProfile is set to 1 in the ToolChainConfig file, the Factory
+// wraps each tool that it creates in a MonitoredTool (see
+// UserTools/Factory/MonitoredTool.h), which times each call with a
+// monotonic clock. The timings are kept in LatencyHistograms owned by the
+// wrapper, so the measurements take no locks, and are merged into the shared
+// ToolProfiler when the tool is finalised. Instances of the same tool class
+// with the same configuration file (e.g. the clones made by
+// ParallelSubChain) are merged together. Once the last tool has been
+// finalised, the profile is printed and, if ToolProfileFile is set, written
+// to a JSON file (name ending in .json) or a ROOT file (any other name).
+//
+// When profiling is disabled, the Factory returns the tools unwrapped, so
+// there is no overhead.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ToolAnalysis includes
+#include "PerfCounters.h"
+
+/// @brief Histogram of call durations in nanoseconds, with buckets whose
+/// width is 1/16 of a power of two (so percentiles are accurate to ~6%)
+class LatencyHistogram {
+
+  public:
+
+    LatencyHistogram();
+
+    /// @brief Record one call
+    inline void Add(uint64_t ns) {
+      ++counts_[ Bucket(ns) ];
+      ++count_;
+      total_ns_ += ns;
+      if ( ns > max_ns_ ) max_ns_ = ns;
+    }
+
+    void Merge(const LatencyHistogram& other);
+
+    /// @brief Estimate of the duration below which a fraction p of the
+    /// calls fall (e.g. p = 0.99)
+    uint64_t Percentile(double p) const;
+
+    inline uint64_t count() const { return count_; }
+    inline uint64_t total_ns() const { return total_ns_; }
+    inline uint64_t max_ns() const { return max_ns_; }
+
+    inline size_t num_buckets() const { return counts_.size(); }
+    inline uint64_t bucket_count(size_t b) const { return counts_.at(b); }
+    static uint64_t BucketLow(size_t b);
+    static uint64_t BucketHigh(size_t b);
+
+  protected:
+
+    static inline size_t Bucket(uint64_t ns) {
+      if ( ns < SUB_BUCKETS ) return ns;
+      int exponent = 63 - __builtin_clzll(ns);
+      size_t sub = (ns >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1u);
+      return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    static constexpr int SUB_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BITS;
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_;
+    uint64_t total_ns_;
+    uint64_t max_ns_;
+};
+
+class ToolProfiler {
+
+  public:
+
+    enum Phase { INITIALISE = 0, EXECUTE = 1, FINALISE = 2, NUM_PHASES = 3 };
+
+    /// @brief Timings of one tool (or of several instances that share a
+    /// class and configuration file)
+    struct ToolStats {
+      std::string tool_class;
+      std::string config_file;
+      LatencyHistogram phases[NUM_PHASES];
+      /// @brief Index of the slowest Execute call (counting from 0)
+      uint64_t slowest_call = 0u;
+      /// @brief EventNumber in the ANNIEEvent store after the slowest call
+      uint64_t slowest_event = 0u;
+      bool has_slowest_event = false;
+      /// @brief Hardware counter totals over the Execute calls in which
+      /// they could be read (see PerfCounters.h)
+      uint64_t counter_totals[PerfCounters::NUM_COUNTERS] = {};
+      bool counter_valid[PerfCounters::NUM_COUNTERS] = {};
+      uint64_t counted_calls = 0u;
+    };
+
+    /// @brief The profiler used by the Factory
+    static ToolProfiler& Shared();
+
+    /// @brief Called by main() before the ToolChain is created
+    void Configure(bool enabled, const std::string& output_file);
+
+    inline bool enabled() const { return enabled_; }
+
+    /// @brief Called when a monitored tool starts to initialise
+    void Started();
+
+    /// @brief Called when a monitored tool has been finalised. Reports the
+    /// profile once every tool that started has finished.
+    void Finished(const ToolStats& stats);
+
+    /// @brief Print a table of the timings, and one of the hardware
+    /// counters if they were read
+    void Report(std::ostream& out);
+
+    /// @brief Write the timings to a JSON or ROOT file
+    bool Write(const std::string& filename);
+
+    /// @brief Copy of the merged timings of the tools finalised so far
+    /// (used by the benchmark harnesses in bench/)
+    std::vector<ToolStats> Tools();
+
+  protected:
+
+    ToolProfiler();
+
+    bool WriteJSON(const std::string& filename);
+    bool WriteROOT(const std::string& filename);
+
+    /// @brief Name shown for each tool: its class, followed by its
+    /// configuration file if several configurations of the class were used
+    std::string Label(const ToolStats& stats) const;
+
+    bool enabled_;
+    std::string output_file_;
+
+    std::mutex mutex_;
+    int active_tools_;
+
+    /// @brief Merged timings, in the order in which the tools finished,
+    /// indexed by class and configuration file
+    std::vector<ToolStats> tools_;
+    std::map<std::string, size_t> tool_indices_;
+};
@@ -0,0 +1,183 @@
+// standard library includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// POSIX includes
+#include <unistd.h>
+
+// ToolAnalysis includes
+#include "Sharding.h"
+#include "Tracer.h"
+
+namespace {
+
+  const size_t MAX_NAME_LENGTH = 63u;
+
+  struct TraceSlot {
+    /// Position of the span in the sequence of recorded spans plus one, or
+    /// zero for an unused slot
+    std::atomic<uint64_t> sequence;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+    uint32_t thread;
+    const char* category;
+    char name[MAX_NAME_LENGTH + 1];
+  };
+
+  std::unique_ptr<TraceSlot[]> slots;
+  size_t capacity = 0u;
+  std::atomic<uint64_t> next_sequence(0u);
+  std::string output_filename;
+  std::chrono::steady_clock::time_point start_time;
+
+  std::atomic<uint32_t> next_thread(0u);
+  thread_local uint32_t thread_number = UINT32_MAX;
+
+  std::mutex thread_names_mutex;
+  std::map<uint32_t, std::string> thread_names;
+
+  uint32_t current_thread() {
+    if ( thread_number == UINT32_MAX ) thread_number = next_thread++;
+    return thread_number;
+  }
+
+  std::string json_string(const char* s) {
+    std::string out = "\"";
+    for (; *s; ++s) {
+      if ( *s == '"' || *s == '\\' ) out += '\\';
+      if ( static_cast<unsigned char>(*s) < 0x20 ) out += ' ';
+      else out += *s;
+    }
+    return out + '"';
+  }
+
+  // Trace-event timestamps are in microseconds
+  std::string to_us(uint64_t ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", ns * 1e-3);
+    return buffer;
+  }
+}
+
+std::atomic<bool> Tracer::enabled_(false);
+
+void Tracer::Configure(size_t buffer_size, const std::string& output_file) {
+  enabled_ = false;
+  capacity = buffer_size;
+  slots.reset( capacity > 0u ? new TraceSlot[capacity] : nullptr );
+  for (size_t s = 0; s < capacity; ++s) slots[s].sequence = 0u;
+  next_sequence = 0u;
+  output_filename = output_file.empty() ? "trace.json" : output_file;
+  start_time = std::chrono::steady_clock::now();
+  if ( capacity > 0u ) {
+    enabled_ = true;
+    SetThreadName("main");
+  }
+}
+
+uint64_t Tracer::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start_time).count();
+}
+
+void Tracer::Record(const char* category, const char* name,
+  uint64_t begin_ns, uint64_t end_ns)
+{
+  uint64_t sequence = next_sequence.fetch_add(1u, std::memory_order_relaxed);
+  TraceSlot& slot = slots[sequence % capacity];
+
+  // A slot is only reused after capacity more spans have been recorded, so
+  // two threads write the same slot at once only if the buffer is very small
+  slot.sequence.store(0u, std::memory_order_relaxed);
+  slot.begin_ns = begin_ns;
+  slot.end_ns = end_ns;
+  slot.thread = current_thread();
+  slot.category = category;
+  std::strncpy(slot.name, name, MAX_NAME_LENGTH);
+  slot.name[MAX_NAME_LENGTH] = '\0';
+  slot.sequence.store(sequence + 1u, std::memory_order_release);
+}
+
+void Tracer::SetThreadName(const std::string& name) {
+  if ( !enabled() ) return;
+  uint32_t thread = current_thread();
+  std::lock_guard<std::mutex> lock(thread_names_mutex);
+  thread_names[thread] = name;
+}
+
+bool Tracer::Flush() {
+  if ( !enabled() ) return true;
+  // Each shard process writes its own trace
+  if ( Sharding::enabled() ) {
+    return Write( output_filename + ".shard"
+      + std::to_string( Sharding::index() ) );
+  }
+  return Write(output_filename);
+}
+
+bool Tracer::Write(const std::string& filename) {
+  std::ofstream out(filename);
+  if ( !out.good() ) {
+    std::cerr << "Error: Could not open the trace file " << filename << '\n';
+    return false;
+  }
+
+  // Collect the completed spans, oldest first
+  std::vector<const TraceSlot*> spans;
+  for (size_t s = 0; s < capacity; ++s) {
+    if ( slots[s].sequence.load(std::memory_order_acquire) != 0u ) {
+      spans.push_back(&slots[s]);
+    }
+  }
+  std::sort(spans.begin(), spans.end(),
+    [](const TraceSlot* a, const TraceSlot* b) {
+      return a->begin_ns < b->begin_ns;
+    });
+
+  uint64_t recorded = next_sequence.load();
+  if ( recorded > capacity ) {
+    std::cerr << "Tracer: The trace buffer kept the last " << capacity
+      << " of " << recorded << " spans. Increase TraceBufferSize to keep"
+      " them all.\n";
+  }
+
+  int pid = getpid();
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool first = true;
+  {
+    std::lock_guard<std::mutex> lock(thread_names_mutex);
+    for (const auto& thread : thread_names) {
+      out << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\","
+        " \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << thread.first
+        << ", \"args\": {\"name\": " << json_string( thread.second.c_str() )
+        << "}}";
+      first = false;
+    }
+  }
+  for (const TraceSlot* span : spans) {
+    out << (first ? "\n" : ",\n") << "{\"name\": "
+      << json_string(span->name) << ", \"cat\": "
+      << json_string(span->category) << ", \"ph\": \"X\", \"ts\": "
+      << to_us(span->begin_ns) << ", \"dur\": "
+      << to_us(span->end_ns - span->begin_ns) << ", \"pid\": " << pid
+      << ", \"tid\": " << span->thread << '}';
+    first = false;
+  }
+  out << "\n]}\n";
+
+  if ( !out.good() ) {
+    std::cerr << "Error: Could not write the trace file " << filename << '\n';
+    return false;
+  }
+  std::cout << "Tracer: Wrote " << spans.size() << " spans to " << filename
+    << std::endl;
+  return true;
+}
@@ -0,0 +1,94 @@
+// Timeline of what each thread was doing, for viewing in Perfetto
+// (https://ui.perfetto.dev) or chrome://tracing
+//
+// Code marks the spans that it wants to appear on the timeline with a
+// TraceSpan, which records the span when it goes out of scope:
+//
+//   {
+//     TraceSpan span("io", "BoostStore::GetEntry");
+//     store->GetEntry(entry);
+//   }
+//
+// The spans are kept in a fixed-size ring buffer, so only the most recent
+// ones are written out. Recording a span takes no locks and makes no
+// allocations. The Factory adds a span for every Initialise, Execute and
+// Finalise call of each tool (see UserTools/Factory/MonitoredTool.h).
+//
+// Tracing is enabled by TraceBufferSize (the number of spans kept, 0 = off)
+// in the ToolChainConfig file. At the end of the run, the spans are written
+// in the Chrome trace-event JSON format to TraceFile (default trace.json).
+// When tracing is disabled, a TraceSpan costs one relaxed atomic load.
+#pragma once
+
+// standard library includes
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class Tracer {
+
+  public:
+
+    /// @brief Called by main() before the ToolChain is created. A capacity
+    /// of zero disables tracing.
+    static void Configure(size_t capacity, const std::string& output_file);
+
+    static inline bool enabled() {
+      return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Nanoseconds since the tracer was configured (monotonic)
+    static uint64_t Now();
+
+    /// @brief Add a span to the buffer. The category must be a string
+    /// literal. Names longer than the space in the buffer are truncated.
+    static void Record(const char* category, const char* name,
+      uint64_t begin_ns, uint64_t end_ns);
+
+    /// @brief Label the calling thread's row in the timeline (ignored when
+    /// tracing is disabled)
+    static void SetThreadName(const std::string& name);
+
+    /// @brief Write the buffer to the configured file (called by main() at
+    /// the end of the run)
+    static bool Flush();
+
+    /// @brief Write the buffer in the Chrome trace-event format
+    static bool Write(const std::string& filename);
+
+  protected:
+
+    static std::atomic<bool> enabled_;
+};
+
+/// @brief Records the time between its construction and destruction as a
+/// span in the Tracer
+class TraceSpan {
+
+  public:
+
+    TraceSpan(const char* category, const char* name)
+      : active_( Tracer::enabled() ), category_(category), name_(name),
+      begin_ns_(active_ ? Tracer::Now() : 0u) {}
+
+    TraceSpan(const char* category, const std::string& name)
+      : TraceSpan(category, name.c_str()) {}
+
+    /// @brief The name must outlive the span
+    TraceSpan(const char* category, std::string&& name) = delete;
+
+    ~TraceSpan() {
+      if (active_) Tracer::Record(category_, name_, begin_ns_, Tracer::Now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  protected:
+
+    bool active_;
+    const char* category_;
+    /// @brief Must stay valid until the span ends
+    const char* name_;
+    uint64_t begin_ns_;
+};
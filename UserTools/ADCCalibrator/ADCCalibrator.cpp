@@ -13,6 +13,19 @@ bool ADCCalibrator::Initialise(std::string config_filename, DataModel& data)
   // Assign a transient data pointer
   m_data = &data;
 
+  // Resolve the ANNIEEvent keys used on every event
+  raw_data_handle_ = m_data->Handle< std::map<ChannelKey,
+    std::vector< Waveform<unsigned short> > > >("ANNIEEvent", "RawADCData");
+  calibrated_data_handle_ = m_data->Handle< std::map<ChannelKey,
+    std::vector< CalibratedADCWaveform<double> > > >("ANNIEEvent",
+    "CalibratedADCData");
+
+  // Read the calibration settings once, since they are used for every
+  // channel (possibly from several threads at once)
+  m_variables.Get("QCritical", q_critical_);
+  m_variables.Get("NumSubMinibuffers", num_sub_minibuffers_);
+  m_variables.Get("NumBaselineSamples", num_baseline_samples_);
+
   return true;
 }
 
@@ -21,10 +34,8 @@ bool ADCCalibrator::Execute() {
   int verbosity;
   m_variables.Get("verbose", verbosity);
 
-  // Get a pointer to the ANNIEEvent Store
-  auto* annie_event = m_data->Stores["ANNIEEvent"];
-
-  if (!annie_event) {
+  // Check that the ANNIEEvent Store exists
+  if ( !raw_data_handle_.store() ) {
     Log("Error: The ADCCalibrator tool could not find the ANNIEEvent Store", 0,
       verbosity);
     return false;
@@ -34,7 +45,7 @@ bool ADCCalibrator::Execute() {
   std::map<ChannelKey, std::vector<Waveform<unsigned short> > >
     raw_waveform_map;
 
-  bool got_raw_data = annie_event->Get("RawADCData", raw_waveform_map);
+  bool got_raw_data = raw_data_handle_.Get(raw_waveform_map);
 
   // Check for problems
   if ( !got_raw_data ) {
@@ -52,15 +63,26 @@ bool ADCCalibrator::Execute() {
   std::map<ChannelKey, std::vector<CalibratedADCWaveform<double> > >
     calibrated_waveform_map;
 
-  for (const auto& temp_pair : raw_waveform_map) {
-    const auto& channel_key = temp_pair.first;
-    const auto& raw_waveforms = temp_pair.second;
+  // The channels are independent, so calibrate them in parallel using the
+  // shared thread pool, then fill the map in channel order
+  std::vector<const std::pair<const ChannelKey,
+    std::vector<Waveform<unsigned short> > >*> channels;
+  for (const auto& temp_pair : raw_waveform_map) channels.push_back(&temp_pair);
+
+  std::vector< std::vector<CalibratedADCWaveform<double> > >
+    calibrated_waveforms( channels.size() );
+
+  m_data->Pool().parallel_for(0u, channels.size(), [&](size_t c) {
+    calibrated_waveforms[c] = make_calibrated_waveforms(
+      channels[c]->second);
+  });
 
-    calibrated_waveform_map[channel_key] = make_calibrated_waveforms(
-      raw_waveforms);
+  for (size_t c = 0; c < channels.size(); ++c) {
+    calibrated_waveform_map.emplace_hint(calibrated_waveform_map.end(),
+      channels[c]->first, std::move(calibrated_waveforms[c]));
   }
 
-  annie_event->Set("CalibratedADCData", calibrated_waveform_map);
+  calibrated_data_handle_.Set(calibrated_waveform_map);
 
   return true;
 }
@@ -76,8 +98,7 @@ void ADCCalibrator::ze3ra_baseline(
 {
   // All F-distribution probabilities below this value will pass the
   // variance consistency test in ze3ra_baseline()
-  double q_critical;
-  m_variables.Get("QCritical", q_critical);
+  double q_critical = q_critical_;
 
   // Signal ADC means, variances, and F-distribution probability values
   // ("Q") for the first num_baseline_samples from each minibuffer
@@ -104,8 +125,7 @@ void ADCCalibrator::ze3ra_baseline(
     }
   }
   else {
-    size_t num_sub_minibuffers;
-    m_variables.Get("NumSubMinibuffers", num_sub_minibuffers);
+    size_t num_sub_minibuffers = num_sub_minibuffers_;
 
     // For non-Hefty data, split the early part of the single minibuffer
     // into sub-minibuffers and compute the mean and variance of each one.
@@ -179,8 +199,7 @@ std::vector< CalibratedADCWaveform<double> >
 ADCCalibrator::make_calibrated_waveforms(
   const std::vector< Waveform<unsigned short> >& raw_waveforms)
 {
-  size_t num_baseline_samples;
-  m_variables.Get("NumBaselineSamples", num_baseline_samples);
+  size_t num_baseline_samples = num_baseline_samples_;
 
   // Determine the baseline for the set of raw waveforms (assumed to all
   // come from the same readout for the same channel)
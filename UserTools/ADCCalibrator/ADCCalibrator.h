@@ -6,12 +6,19 @@
 // Steven Gardiner <sjgardiner@ucdavis.edu>
 #pragma once
 
+// standard library includes
+#include <map>
+#include <vector>
+
 // ToolAnalysis includes
 #include "CalibratedADCWaveform.h"
+#include "ChannelKey.h"
+#include "ParallelSafe.h"
+#include "StoreHandle.h"
 #include "Tool.h"
 #include "Waveform.h"
 
-class ADCCalibrator : public Tool {
+class ADCCalibrator : public Tool, public ParallelSafe {
 
   public:
 
@@ -31,4 +38,24 @@ class ADCCalibrator : public Tool {
 
     std::vector< CalibratedADCWaveform<double> > make_calibrated_waveforms(
       const std::vector< Waveform<unsigned short> >& raw_waveforms);
+
+    /// @brief Handle to the RawADCData entry in the ANNIEEvent store
+    StoreHandle< std::map<ChannelKey, std::vector< Waveform<unsigned short> > > >
+      raw_data_handle_;
+
+    /// @brief Handle to the CalibratedADCData entry in the ANNIEEvent store
+    StoreHandle< std::map<ChannelKey,
+      std::vector< CalibratedADCWaveform<double> > > > calibrated_data_handle_;
+
+    /// @brief F-distribution probability below which a minibuffer passes
+    /// the variance consistency test in ze3ra_baseline()
+    double q_critical_ = 0.;
+
+    /// @brief Number of sub-minibuffers used to find the baseline of
+    /// non-Hefty data
+    size_t num_sub_minibuffers_ = 0u;
+
+    /// @brief Number of samples at the start of each (sub-)minibuffer used
+    /// to find the baseline
+    size_t num_baseline_samples_ = 0u;
 };
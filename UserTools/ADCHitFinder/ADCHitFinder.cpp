@@ -9,6 +9,7 @@
 #include "ADCPulse.h"
 #include "ANNIEconstants.h"
 #include "CalibratedADCWaveform.h"
+#include "PackedADCPulse.h"
 #include "Waveform.h"
 
 ADCHitFinder::ADCHitFinder() : Tool() {}
@@ -21,6 +22,19 @@ bool ADCHitFinder::Initialise(std::string config_filename, DataModel& data) {
   // Assign a transient data pointer
   m_data = &data;
 
+  // Optionally store the pulses using the fixed-layout packed format,
+  // which is much cheaper to save and load for large Hefty datasets
+  int use_packed_pulses = 0;
+  m_variables.Get("UsePackedPulses", use_packed_pulses);
+  use_packed_pulses_ = use_packed_pulses;
+
+  // Resolve the ANNIEEvent keys used on every event
+  raw_data_handle_ = m_data->Handle< std::map<ChannelKey,
+    std::vector< Waveform<unsigned short> > > >("ANNIEEvent", "RawADCData");
+  calibrated_data_handle_ = m_data->Handle< std::map<ChannelKey,
+    std::vector< CalibratedADCWaveform<double> > > >("ANNIEEvent",
+    "CalibratedADCData");
+
   return true;
 }
 
@@ -31,7 +45,7 @@ bool ADCHitFinder::Execute() {
 
   try {
     // Get a pointer to the ANNIEEvent Store
-    auto* annie_event = m_data->Stores["ANNIEEvent"];
+    auto* annie_event = raw_data_handle_.store();
 
     if (!annie_event) {
       Log("Error: The ADCHitFinder tool could not find the ANNIEEvent Store", 0,
@@ -43,7 +57,7 @@ bool ADCHitFinder::Execute() {
     std::map<ChannelKey, std::vector<Waveform<unsigned short> > >
       raw_waveform_map;
 
-    bool got_raw_data = annie_event->Get("RawADCData", raw_waveform_map);
+    bool got_raw_data = raw_data_handle_.Get(raw_waveform_map);
 
     // Check for problems
     if ( !got_raw_data ) {
@@ -61,7 +75,7 @@ bool ADCHitFinder::Execute() {
     std::map<ChannelKey, std::vector<CalibratedADCWaveform<double> > >
       calibrated_waveform_map;
 
-    bool got_calibrated_data = annie_event->Get("CalibratedADCData",
+    bool got_calibrated_data = calibrated_data_handle_.Get(
       calibrated_waveform_map);
 
     // Check for problems
@@ -134,7 +148,10 @@ bool ADCHitFinder::Execute() {
       pulse_map[channel_key] = pulse_vec;
     }
 
-    annie_event->Set("RecoADCHits", pulse_map);
+    if (use_packed_pulses_) {
+      annie_event->Set("RecoADCHitsPacked", PackedADCHits(pulse_map));
+    }
+    else annie_event->Set("RecoADCHits", pulse_map);
 
     return true;
   }
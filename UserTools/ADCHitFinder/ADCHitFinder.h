@@ -7,10 +7,12 @@
 #include "ADCPulse.h"
 #include "CalibratedADCWaveform.h"
 #include "ChannelKey.h"
+#include "ParallelSafe.h"
+#include "StoreHandle.h"
 #include "Tool.h"
 #include "Waveform.h"
 
-class ADCHitFinder : public Tool {
+class ADCHitFinder : public Tool, public ParallelSafe {
 
   public:
 
@@ -25,4 +27,16 @@ class ADCHitFinder : public Tool {
       const Waveform<unsigned short>& raw_minibuffer_data,
       const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
       unsigned short adc_threshold, const ChannelKey& channel_key) const;
+
+    /// @brief Handle to the RawADCData entry in the ANNIEEvent store
+    StoreHandle< std::map<ChannelKey, std::vector< Waveform<unsigned short> > > >
+      raw_data_handle_;
+
+    /// @brief Handle to the CalibratedADCData entry in the ANNIEEvent store
+    StoreHandle< std::map<ChannelKey,
+      std::vector< CalibratedADCWaveform<double> > > > calibrated_data_handle_;
+
+    /// @brief Whether to store the pulses as RecoADCHitsPacked rather than
+    /// RecoADCHits
+    bool use_packed_pulses_ = false;
 };
@@ -0,0 +1,112 @@
+// standard library includes
+#include <fstream>
+
+// ToolAnalysis includes
+#include "ANNIEEventMerge.h"
+#include "Sharding.h"
+
+ANNIEEventMerge::ANNIEEventMerge():Tool() {}
+
+bool ANNIEEventMerge::Initialise(std::string config_filename,
+  DataModel &data)
+{
+  // Load settings from the configuration file
+  if ( !config_filename.empty() ) m_variables.Initialise(config_filename);
+
+  // Assign transient data pointer
+  m_data= &data;
+
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("ANNIEEventMerge") ) return false;
+
+  verbosity_ = 0;
+  m_variables.Get("verbose", verbosity_);
+
+  std::string input_list_filename;
+  bool got_input_file_list = m_variables.Get("FileForListOfInputs",
+    input_list_filename);
+
+  if ( !got_input_file_list ) {
+    Log("Error: Missing input list file in the configuration for the"
+      " ANNIEEventMerge tool", 0, verbosity_);
+    return false;
+  }
+
+  std::string output_filename;
+  if ( !m_variables.Get("OutputFile", output_filename) ) {
+    Log("Error: Missing output file in the configuration for the"
+      " ANNIEEventMerge tool", 0, verbosity_);
+    return false;
+  }
+
+  std::ifstream list_file(input_list_filename);
+  if ( !list_file.good() ) {
+    Log("Error: Could not open the input list file for the ANNIEEventMerge"
+      " tool", 0, verbosity_);
+    return false;
+  }
+
+  std::string temp_str;
+  while ( list_file >> temp_str ) input_filenames_.push_back( temp_str );
+
+  int require_same_run = 1;
+  m_variables.Get("RequireSameRun", require_same_run);
+
+  int skip_bad_files = 0;
+  m_variables.Get("SkipBadFiles", skip_bad_files);
+  skip_bad_files_ = skip_bad_files;
+
+  merger_.reset( new ANNIEEventMerger(output_filename, require_same_run) );
+  current_file_ = 0u;
+
+  return true;
+}
+
+
+bool ANNIEEventMerge::Execute() {
+
+  if ( current_file_ >= input_filenames_.size() ) {
+    m_data->vars.Set("StopLoop", 1);
+    return true;
+  }
+
+  const std::string& input_filename = input_filenames_.at(current_file_);
+  ++current_file_;
+  if ( current_file_ >= input_filenames_.size() ) {
+    m_data->vars.Set("StopLoop", 1);
+  }
+
+  Log("Merging the ANNIEEvent input file \"" + input_filename + '\"', 1,
+    verbosity_);
+
+  std::string error;
+  if ( !merger_->AddFile(input_filename, error) ) {
+    // An input that was partly written can't be skipped
+    if ( skip_bad_files_ && !merger_->incomplete() ) {
+      Log("Warning: Skipping input file: " + error, 0, verbosity_);
+      return true;
+    }
+    Log("Error: " + error, 0, verbosity_);
+    m_data->vars.Set("StopLoop", 1);
+    return false;
+  }
+
+  return true;
+}
+
+
+bool ANNIEEventMerge::Finalise() {
+
+  if (!merger_) return true;
+
+  merger_->Close();
+
+  std::string run_string = merger_->has_run_number()
+    ? std::to_string( merger_->run_number() ) : "unknown";
+
+  Log("Merged " + std::to_string( merger_->num_entries() ) + " entries from "
+    + std::to_string( merger_->num_files() ) + " input files (run "
+    + run_string + ')', 1, verbosity_);
+
+  return true;
+}
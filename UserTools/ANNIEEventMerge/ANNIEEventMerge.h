@@ -0,0 +1,38 @@
+#pragma once
+
+// standard library includes
+#include <memory>
+#include <string>
+#include <vector>
+
+// ToolAnalysis includes
+#include "ANNIEEventMerger.h"
+#include "Tool.h"
+
+class ANNIEEventMerge: public Tool {
+
+  public:
+
+    ANNIEEventMerge();
+    bool Initialise(std::string configfile, DataModel& data);
+    bool Execute();
+    bool Finalise();
+
+  protected:
+
+    /// @brief Integer code that determines the level of logging to show in
+    /// the output
+    int verbosity_;
+
+    /// @brief Vector of filenames for each of the input files
+    std::vector<std::string> input_filenames_;
+
+    /// @brief The index of the next input file to merge
+    size_t current_file_;
+
+    /// @brief Whether to keep going when an input file is rejected
+    bool skip_bad_files_;
+
+    /// @brief Object that writes the merged ANNIEEvent file
+    std::unique_ptr<ANNIEEventMerger> merger_;
+};
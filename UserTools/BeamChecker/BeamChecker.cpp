@@ -11,6 +11,7 @@
 #include "BeamStatus.h"
 #include "HeftyInfo.h"
 #include "TimeClass.h"
+#include "Tracer.h"
 
 // Definitions local to this source file
 namespace {
@@ -241,6 +242,7 @@ BeamStatus BeamChecker::get_beam_status(uint64_t ns_since_epoch,
   static bool got_first_beam_entry = false;
 
   if ( !got_first_beam_entry ) {
+    TraceSpan span("io", "BoostStore::GetEntry (beam DB)");
     beam_db_store_.GetEntry(current_beam_db_entry);
     beam_db_store_.Get("BeamDB", beam_data);
     got_first_beam_entry = true;
@@ -281,6 +283,7 @@ BeamStatus BeamChecker::get_beam_status(uint64_t ns_since_epoch,
   int new_entry_number = iter->first;
   if ( new_entry_number != current_beam_db_entry ) {
 
+    TraceSpan span("io", "BoostStore::GetEntry (beam DB)");
     beam_db_store_.GetEntry(new_entry_number);
     beam_db_store_.Get("BeamDB", beam_data);
 
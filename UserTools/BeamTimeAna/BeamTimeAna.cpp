@@ -20,17 +20,17 @@ bool BeamTimeAna::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("tc2", tc2);
   m_variables.Get("tc3", tc3);
 
-  hbt = new TH1D("beamtime","beamtime",100,0.0,8.0);
-  hbE0 = new TH1D("beamenergy0","beamenergy0",100.,0.,2.5);
+  hbt = histograms.Register(new TH1D("beamtime","beamtime",100,0.0,8.0));
+  hbE0 = histograms.Register(new TH1D("beamenergy0","beamenergy0",100.,0.,2.5));
 
-  hbE_early = new TH1D("beamenergy_early","beamenergy_early",100.,0.,2.5);
-  hbE_med = new TH1D("beamenergy_med","beamenergy_med",100.,0.,2.5);
-  hbE_late = new TH1D("beamenergy_late","beamenergy_late",100.,0.,2.5);
-  hbdvstimecorr = new TH2D("starttime","beamdist_vs_timecorr",100,0.,50.,100,0.,50.);
-  hntp = new TH1D("neut_type","neut_type",4,-0.5,3.5);
+  hbE_early = histograms.Register(new TH1D("beamenergy_early","beamenergy_early",100.,0.,2.5));
+  hbE_med = histograms.Register(new TH1D("beamenergy_med","beamenergy_med",100.,0.,2.5));
+  hbE_late = histograms.Register(new TH1D("beamenergy_late","beamenergy_late",100.,0.,2.5));
+  hbdvstimecorr = histograms.Register(new TH2D("starttime","beamdist_vs_timecorr",100,0.,50.,100,0.,50.));
+  hntp = histograms.Register(new TH1D("neut_type","neut_type",4,-0.5,3.5));
 
-  hbz0 = new TH1D("z0","z0",100,0.,5000.);
-  hbbaseline = new TH1D("baseline","baseline",1000,-1.,15000.);
+  hbz0 = histograms.Register(new TH1D("z0","z0",100,0.,5000.));
+  hbbaseline = histograms.Register(new TH1D("baseline","baseline",1000,-1.,15000.));
 
   ientry=0;
 
@@ -144,6 +144,8 @@ vector<double> BeamTimeAna::Transit(double x0, double y0, double z0, double xslo
 
 bool BeamTimeAna::Finalise(){
 
+  histograms.Merge();
+
 /*
   TFile* tout = new TFile(OutFile,"RECREATE");
 
@@ -5,7 +5,10 @@
 #include <iostream>
 
 #include "Tool.h"
+#include "HistogramRegistry.h"
 
+#include "TH1D.h"
+#include "TH2D.h"
 #include "TVector3.h"
 
 class BeamTimeAna: public Tool {
@@ -19,15 +22,18 @@ class BeamTimeAna: public Tool {
   bool Finalise();
   vector<double> Transit(double x0, double y0, double z0, double xslope, double yslope, double baseline, double radius);
 
-  TH1D* hntp;
-  TH1D* hbt;
-  TH1D* hbE0;
-  TH1D* hbE_early;
-  TH1D* hbE_med;
-  TH1D* hbE_late;
-  TH1D* hbz0;
-  TH1D* hbbaseline;
-  TH2D* hbdvstimecorr;
+  // histograms are filled through handles so that Execute may be called
+  // from more than one thread; Finalise merges the per-thread copies
+  HistogramRegistry histograms;
+  HistogramHandle<TH1D> hntp;
+  HistogramHandle<TH1D> hbt;
+  HistogramHandle<TH1D> hbE0;
+  HistogramHandle<TH1D> hbE_early;
+  HistogramHandle<TH1D> hbE_med;
+  HistogramHandle<TH1D> hbE_late;
+  HistogramHandle<TH1D> hbz0;
+  HistogramHandle<TH1D> hbbaseline;
+  HistogramHandle<TH2D> hbdvstimecorr;
 
   TString InFile;
   TString OutFile;
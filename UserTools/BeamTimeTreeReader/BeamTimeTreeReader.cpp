@@ -1,4 +1,6 @@
 #include "BeamTimeTreeReader.h"
+#include "Sharding.h"
+#include "Tracer.h"
 
 BeamTimeTreeReader::BeamTimeTreeReader():Tool(){}
 
@@ -12,6 +14,9 @@ bool BeamTimeTreeReader::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("BeamTimeTreeReader") ) return false;
+
   m_data->Stores["NeutrinoEvent"]= new BoostStore(false,2);
 
 
@@ -52,7 +57,10 @@ bool BeamTimeTreeReader::Execute(){
   if(ientry%500==0) cout<<"READING TREE, entry="<<ientry<<endl;
 
 
-  fChain->GetEntry(ientry);
+  {
+    TraceSpan span("io", "TChain::GetEntry");
+    fChain->GetEntry(ientry);
+  }
 
   double xslope,yslope;
   vector<double> vtransit;
@@ -0,0 +1,98 @@
+// ToolAnalysis includes
+#include "Checkpoint.h"
+#include "Sharding.h"
+
+Checkpoint::Checkpoint():Tool() {}
+
+bool Checkpoint::Initialise(std::string config_filename, DataModel &data) {
+
+  // Load settings from the configuration file
+  if ( !config_filename.empty() ) m_variables.Initialise(config_filename);
+
+  // Assign transient data pointer
+  m_data= &data;
+
+  verbosity_ = 0;
+  m_variables.Get("verbose", verbosity_);
+
+  std::string checkpoint_filename = "./checkpoint.txt";
+  m_variables.Get("CheckpointFile", checkpoint_filename);
+
+  // Each shard process keeps its own checkpoint
+  if ( Sharding::enabled() ) {
+    checkpoint_filename += ".shard" + std::to_string( Sharding::index() );
+  }
+
+  int interval = 1000;
+  m_variables.Get("CheckpointInterval", interval);
+  if ( interval <= 0 ) {
+    Log("Error: CheckpointInterval must be positive", 0, verbosity_);
+    return false;
+  }
+  interval_ = interval;
+
+  int resume = 1;
+  m_variables.Get("Resume", resume);
+
+  int remove_on_success = 1;
+  m_variables.Get("RemoveOnSuccess", remove_on_success);
+  remove_on_success_ = remove_on_success;
+
+  events_completed_ = 0u;
+
+  if ( !m_data->Checkpoints.Open(checkpoint_filename, resume) ) {
+    Log("Error: Could not resume from the checkpoint file \""
+      + checkpoint_filename + '\"', 0, verbosity_);
+    return false;
+  }
+
+  if ( !m_data->Checkpoints.Register("Checkpoint", this) ) return false;
+
+  if ( m_data->Checkpoints.resumed() ) {
+    Log("Resuming from the checkpoint file \"" + checkpoint_filename
+      + "\" after " + std::to_string(events_completed_) + " events", 0,
+      verbosity_);
+  }
+
+  return true;
+}
+
+
+bool Checkpoint::Execute() {
+
+  // Execute() is called before the other tools process the next event, so
+  // every event counted here has been completed by the whole ToolChain
+  if ( events_completed_ > 0u && events_completed_ % interval_ == 0u ) {
+    if ( !m_data->Checkpoints.Write() ) {
+      Log("Warning: Failed to write the checkpoint file \""
+        + m_data->Checkpoints.filename() + '\"', 0, verbosity_);
+    }
+    else Log("Wrote checkpoint after " + std::to_string(events_completed_)
+      + " events", 1, verbosity_);
+  }
+
+  ++events_completed_;
+
+  return true;
+}
+
+
+bool Checkpoint::Finalise() {
+
+  // The job finished normally, so the checkpoint is no longer needed
+  if (remove_on_success_) m_data->Checkpoints.Remove();
+  m_data->Checkpoints.Unregister("Checkpoint");
+
+  return true;
+}
+
+
+bool Checkpoint::SaveCheckpoint(CheckpointState& state) {
+  state.Set("EventsCompleted", events_completed_);
+  return true;
+}
+
+
+bool Checkpoint::RestoreCheckpoint(const CheckpointState& state) {
+  return state.Get("EventsCompleted", events_completed_);
+}
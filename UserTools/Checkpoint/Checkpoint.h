@@ -0,0 +1,43 @@
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <string>
+
+// ToolAnalysis includes
+#include "CheckpointManager.h"
+#include "Tool.h"
+
+/// @brief Periodically saves the state of all Checkpointable tools so that a
+/// job can be resumed after it is interrupted
+/// @details This tool should be the first one in the ToolChain, so that the
+/// checkpoint file is loaded before the other tools are initialised, and so
+/// that each checkpoint is written between two events.
+class Checkpoint: public Tool, public Checkpointable {
+
+  public:
+
+    Checkpoint();
+    bool Initialise(std::string configfile, DataModel& data);
+    bool Execute();
+    bool Finalise();
+
+    bool SaveCheckpoint(CheckpointState& state) override;
+    bool RestoreCheckpoint(const CheckpointState& state) override;
+
+  protected:
+
+    /// @brief Integer code that determines the level of logging to show in
+    /// the output
+    int verbosity_;
+
+    /// @brief Number of events between checkpoints
+    uint64_t interval_;
+
+    /// @brief Number of events completed so far (including those completed
+    /// before the job was resumed)
+    uint64_t events_completed_;
+
+    /// @brief Whether to delete the checkpoint file when the job finishes
+    bool remove_on_success_;
+};
@@ -0,0 +1,216 @@
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "EventCollector.h"
+#include "EventMessage.h"
+#include "Sharding.h"
+
+EventCollector::EventCollector():Tool() {}
+
+bool EventCollector::Initialise(std::string config_filename, DataModel &data)
+{
+  // Load settings from the configuration file
+  if ( !config_filename.empty() ) m_variables.Initialise(config_filename);
+
+  // Assign transient data pointer
+  m_data= &data;
+
+  // The events come from the network rather than from a slice of the input
+  if ( Sharding::Unsupported("EventCollector") ) return false;
+
+  verbosity_ = 0;
+  m_variables.Get("verbose", verbosity_);
+
+  std::string role;
+  m_variables.Get("Role", role);
+  if ( role == "Collector" ) is_collector_ = true;
+  else if ( role == "Worker" ) is_collector_ = false;
+  else {
+    Log("Error: The EventCollector Role must be Collector or Worker", 0,
+      verbosity_);
+    return false;
+  }
+
+  std::string address;
+  if ( !m_variables.Get("Address", address) ) {
+    Log("Error: Missing Address in the configuration for the EventCollector"
+      " tool", 0, verbosity_);
+    return false;
+  }
+
+  std::string stores = "ANNIEEvent";
+  m_variables.Get("Stores", stores);
+  store_names_ = split_store_names(stores);
+
+  int timeout_seconds = 600;
+  m_variables.Get("TimeoutSeconds", timeout_seconds);
+  timeout_ms_ = ( timeout_seconds > 0 ) ? 1000l * timeout_seconds : -1l;
+
+  if ( !m_data->context ) {
+    Log("Error: No ZeroMQ context is available to the EventCollector tool",
+      0, verbosity_);
+    return false;
+  }
+
+  next_sequence_number_ = 0u;
+  total_events_ = 0u;
+  total_known_ = false;
+  max_pending_ = 0u;
+  sent_header_hashes_.clear();
+  events_handled_ = 0u;
+
+  try {
+    if (is_collector_) {
+      socket_.reset( new zmq::socket_t(*m_data->context, ZMQ_PULL) );
+      socket_->bind( address.c_str() );
+      Log("EventCollector: Receiving events from workers on " + address, 1,
+        verbosity_);
+
+      for (const auto& name : store_names_) {
+        BoostStore*& store = m_data->Stores[name];
+        if ( !store ) store = new BoostStore(false,
+          BOOST_STORE_MULTIEVENT_FORMAT);
+      }
+    }
+    else {
+      socket_.reset( new zmq::socket_t(*m_data->context, ZMQ_PUSH) );
+      socket_->connect( address.c_str() );
+      Log("EventCollector: Sending events to " + address, 1, verbosity_);
+    }
+  }
+  catch (const zmq::error_t& e) {
+    Log("Error: EventCollector could not open " + address + ": " + e.what(),
+      0, verbosity_);
+    return false;
+  }
+
+  return true;
+}
+
+bool EventCollector::Execute() {
+  if (is_collector_) return ExecuteCollector();
+  return ExecuteWorker();
+}
+
+bool EventCollector::ExecuteWorker() {
+
+  // Nothing to send if the EventDistributor did not receive an event
+  bool has_event = false;
+  m_data->CStore.Get("DistributedEvent", has_event);
+  if ( !has_event ) return true;
+
+  uint64_t sequence_number = 0u;
+  bool last = false;
+  m_data->CStore.Get("DistributedEventNumber", sequence_number);
+  m_data->CStore.Get("DistributedEventLast", last);
+
+  // The headers are only sent when they have changed
+  std::string body, error;
+  if ( !encode_event_stores(m_data->Stores, store_names_,
+    sent_header_hashes_, body, error) )
+  {
+    Log("Error: EventCollector could not encode event "
+      + std::to_string(sequence_number) + ": " + error, 0, verbosity_);
+    return false;
+  }
+  if ( !send_frames(*socket_, { "EVENT",
+    event_sequence_frame(sequence_number, last), body }) )
+  {
+    Log("Error: EventCollector failed to send event "
+      + std::to_string(sequence_number), 0, verbosity_);
+    return false;
+  }
+  ++events_handled_;
+
+  return true;
+}
+
+bool EventCollector::ExecuteCollector() {
+
+  // Wait for the next event in sequence, keeping any that arrive early
+  while ( !pending_events_.count(next_sequence_number_) ) {
+    std::vector<std::string> frames;
+    if ( !receive_frames(*socket_, frames, timeout_ms_) ) {
+      Log("Error: EventCollector timed out waiting for event "
+        + std::to_string(next_sequence_number_), 0, verbosity_);
+      m_data->vars.Set("StopLoop", 1);
+      return false;
+    }
+
+    uint64_t sequence_number = 0u;
+    bool last = false;
+    if ( frames.size() != 3u || frames.front() != "EVENT"
+      || !parse_event_sequence_frame(frames.at(1), sequence_number, last) )
+    {
+      Log("Warning: EventCollector ignored a malformed message", 0,
+        verbosity_);
+      continue;
+    }
+
+    if (last) {
+      total_events_ = sequence_number + 1u;
+      total_known_ = true;
+    }
+    pending_events_[sequence_number].swap( frames.at(2) );
+    if ( pending_events_.size() > max_pending_ ) {
+      max_pending_ = pending_events_.size();
+    }
+  }
+
+  auto iter = pending_events_.find(next_sequence_number_);
+  bool has_geometry = false;
+  std::string error;
+  bool decoded = decode_event_stores(iter->second, m_data->Stores,
+    has_geometry, error);
+  pending_events_.erase(iter);
+  if ( !decoded ) {
+    Log("Error: EventCollector could not decode event "
+      + std::to_string(next_sequence_number_) + ": " + error, 0, verbosity_);
+    m_data->vars.Set("StopLoop", 1);
+    return false;
+  }
+
+  if (has_geometry) {
+    for (const auto& name : store_names_) {
+      BoostStore* store = m_data->Stores[name];
+      Geometry geometry;
+      if ( store->Header && store->Header->Has("AnnieGeometry")
+        && store->Header->Get("AnnieGeometry", geometry) )
+      {
+        m_data->UpdateGeometry(geometry);
+        break;
+      }
+    }
+  }
+
+  ++next_sequence_number_;
+  ++events_handled_;
+  if ( total_known_ && next_sequence_number_ >= total_events_ ) {
+    m_data->vars.Set("StopLoop", 1);
+  }
+
+  return true;
+}
+
+bool EventCollector::Finalise() {
+
+  if (is_collector_) {
+    Log("EventCollector: Loaded " + std::to_string(events_handled_)
+      + " events (at most " + std::to_string(max_pending_) + " waiting for"
+      " an earlier event)", 1, verbosity_);
+    if ( !total_known_ || events_handled_ < total_events_ ) {
+      Log("Warning: EventCollector stopped before the last event arrived",
+        0, verbosity_);
+    }
+  }
+  else {
+    Log("EventCollector: Sent " + std::to_string(events_handled_)
+      + " events", 1, verbosity_);
+
+    // Make sure the results reach the collector before the worker exits
+    int linger = static_cast<int>(timeout_ms_);
+    socket_->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+  }
+
+  socket_.reset();
+  return true;
+}
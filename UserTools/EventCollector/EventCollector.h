@@ -0,0 +1,74 @@
+// Gathers the events processed by worker ToolChain processes over ZeroMQ
+//
+// In each "Worker" ToolChain, EventCollector is the last tool, and sends the
+// event received by the worker's EventDistributor tool, as processed by the
+// tools in between, to the collector process (a PUSH socket). In the
+// "Collector" ToolChain, it is the first tool: it receives the processed
+// events from all of the workers (a PULL socket) and loads them into the
+// stores in their original order, so that the output tools that follow it
+// see the same sequence of events as a single-process job.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ZeroMQ includes
+#include <zmq.hpp>
+
+// ToolAnalysis includes
+#include "Tool.h"
+
+class EventCollector: public Tool {
+
+  public:
+
+    EventCollector();
+    bool Initialise(std::string configfile, DataModel& data);
+    bool Execute();
+    bool Finalise();
+
+  protected:
+
+    bool ExecuteCollector();
+    bool ExecuteWorker();
+
+    /// @brief Integer code that determines the level of logging to show in
+    /// the output
+    int verbosity_;
+
+    /// @brief Whether this is the collector (true) or a worker (false)
+    bool is_collector_;
+
+    /// @brief Names of the stores sent with each event
+    std::vector<std::string> store_names_;
+
+    /// @brief How long to wait for a message, or -1 to wait forever
+    long timeout_ms_;
+
+    std::unique_ptr<zmq::socket_t> socket_;
+
+    /// @brief Sequence number of the next event to load (collector only)
+    uint64_t next_sequence_number_;
+
+    /// @brief Number of events in the input, once the last one has arrived
+    /// (collector only)
+    uint64_t total_events_;
+    bool total_known_;
+
+    /// @brief Events that arrived ahead of their turn, indexed by sequence
+    /// number (collector only)
+    std::map<uint64_t, std::string> pending_events_;
+
+    /// @brief Maximum number of events held in pending_events_ so far
+    size_t max_pending_;
+
+    /// @brief Hash of the header of each store last sent (worker only)
+    std::map<std::string, uint64_t> sent_header_hashes_;
+
+    /// @brief Number of events sent or loaded
+    uint64_t events_handled_;
+};
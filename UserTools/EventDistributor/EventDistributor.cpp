@@ -0,0 +1,267 @@
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "EventDistributor.h"
+#include "EventMessage.h"
+#include "Sharding.h"
+
+EventDistributor::EventDistributor():Tool() {}
+
+bool EventDistributor::Initialise(std::string config_filename,
+  DataModel &data)
+{
+  // Load settings from the configuration file
+  if ( !config_filename.empty() ) m_variables.Initialise(config_filename);
+
+  // Assign transient data pointer
+  m_data= &data;
+
+  // The events come from the network rather than from a slice of the input
+  if ( Sharding::Unsupported("EventDistributor") ) return false;
+
+  verbosity_ = 0;
+  m_variables.Get("verbose", verbosity_);
+
+  std::string role;
+  m_variables.Get("Role", role);
+  if ( role == "Broker" ) is_broker_ = true;
+  else if ( role == "Worker" ) is_broker_ = false;
+  else {
+    Log("Error: The EventDistributor Role must be Broker or Worker", 0,
+      verbosity_);
+    return false;
+  }
+
+  std::string address;
+  if ( !m_variables.Get("Address", address) ) {
+    Log("Error: Missing Address in the configuration for the"
+      " EventDistributor tool", 0, verbosity_);
+    return false;
+  }
+
+  std::string stores = "ANNIEEvent";
+  m_variables.Get("Stores", stores);
+  store_names_ = split_store_names(stores);
+
+  int timeout_seconds = 600;
+  m_variables.Get("TimeoutSeconds", timeout_seconds);
+  timeout_ms_ = ( timeout_seconds > 0 ) ? 1000l * timeout_seconds : -1l;
+
+  int prefetch = 2;
+  m_variables.Get("Prefetch", prefetch);
+  if ( prefetch < 1 ) prefetch = 1;
+
+  if ( !m_data->context ) {
+    Log("Error: No ZeroMQ context is available to the EventDistributor"
+      " tool", 0, verbosity_);
+    return false;
+  }
+
+  next_sequence_number_ = 0u;
+  events_processed_ = 0u;
+
+  try {
+    if (is_broker_) {
+      socket_.reset( new zmq::socket_t(*m_data->context, ZMQ_ROUTER) );
+      socket_->bind( address.c_str() );
+      Log("EventDistributor: Sending events to workers on " + address, 1,
+        verbosity_);
+    }
+    else {
+      socket_.reset( new zmq::socket_t(*m_data->context, ZMQ_DEALER) );
+      socket_->connect( address.c_str() );
+      Log("EventDistributor: Receiving events from " + address, 1,
+        verbosity_);
+
+      for (const auto& name : store_names_) {
+        BoostStore*& store = m_data->Stores[name];
+        if ( !store ) store = new BoostStore(false,
+          BOOST_STORE_MULTIEVENT_FORMAT);
+      }
+
+      // Ask for the first few events
+      for (int r = 0; r < prefetch; ++r) send_frames(*socket_, { "READY" });
+    }
+  }
+  catch (const zmq::error_t& e) {
+    Log("Error: EventDistributor could not open " + address + ": "
+      + e.what(), 0, verbosity_);
+    return false;
+  }
+
+  return true;
+}
+
+bool EventDistributor::Execute() {
+  if (is_broker_) return ExecuteBroker();
+  return ExecuteWorker();
+}
+
+bool EventDistributor::ExecuteBroker() {
+
+  // The loader sets StopLoop when it loads the last event
+  int stop_loop = 0;
+  m_data->vars.Get("StopLoop", stop_loop);
+  bool last = ( stop_loop != 0 );
+
+  // Wait for a worker to ask for an event
+  while ( requests_.empty() ) {
+    std::vector<std::string> frames;
+    if ( !receive_frames(*socket_, frames, timeout_ms_) ) {
+      Log("Error: No worker asked for an event before the EventDistributor"
+        " timed out", 0, verbosity_);
+      m_data->vars.Set("StopLoop", 1);
+      return false;
+    }
+    if ( frames.size() == 2u && frames.back() == "READY" ) {
+      requests_.push_back( frames.front() );
+    }
+  }
+
+  std::string worker = requests_.front();
+  requests_.pop_front();
+
+  // The headers are only sent to workers that do not have them yet
+  std::string body, error;
+  if ( !encode_event_stores(m_data->Stores, store_names_,
+    worker_header_hashes_[worker], body, error) )
+  {
+    Log("Error: EventDistributor could not encode event "
+      + std::to_string(next_sequence_number_) + ": " + error, 0, verbosity_);
+    m_data->vars.Set("StopLoop", 1);
+    return false;
+  }
+  if ( !send_frames(*socket_, { worker, "EVENT",
+    event_sequence_frame(next_sequence_number_, last), body }) )
+  {
+    Log("Error: EventDistributor failed to send event "
+      + std::to_string(next_sequence_number_), 0, verbosity_);
+    return false;
+  }
+  ++next_sequence_number_;
+
+  return true;
+}
+
+bool EventDistributor::ReceiveFromBroker(std::vector<std::string>& frames) {
+  if ( receive_frames(*socket_, frames, timeout_ms_) && !frames.empty() ) {
+    return true;
+  }
+  Log("Error: EventDistributor timed out waiting for an event from the"
+    " broker", 0, verbosity_);
+  return false;
+}
+
+bool EventDistributor::ExecuteWorker() {
+
+  m_data->CStore.Set("DistributedEvent", false);
+
+  std::vector<std::string> frames;
+  if ( next_frames_.empty() ) {
+    if ( !ReceiveFromBroker(frames) ) {
+      m_data->vars.Set("StopLoop", 1);
+      return false;
+    }
+  }
+  else frames.swap(next_frames_);
+
+  // The broker ran out of events before sending one to this worker
+  if ( frames.front() == "END" ) {
+    Log("Warning: EventDistributor received no events", 0, verbosity_);
+    for (const auto& name : store_names_) m_data->Stores[name]->Delete();
+    m_data->vars.Set("StopLoop", 1);
+    return true;
+  }
+
+  uint64_t sequence_number = 0u;
+  bool last = false;
+  if ( frames.size() != 3u || frames.front() != "EVENT"
+    || !parse_event_sequence_frame(frames.at(1), sequence_number, last) )
+  {
+    Log("Error: EventDistributor received a malformed message", 0,
+      verbosity_);
+    m_data->vars.Set("StopLoop", 1);
+    return false;
+  }
+
+  bool has_geometry = false;
+  std::string error;
+  if ( !decode_event_stores(frames.at(2), m_data->Stores, has_geometry,
+    error) )
+  {
+    Log("Error: EventDistributor could not decode event "
+      + std::to_string(sequence_number) + ": " + error, 0, verbosity_);
+    m_data->vars.Set("StopLoop", 1);
+    return false;
+  }
+
+  if (has_geometry) {
+    for (const auto& name : store_names_) {
+      BoostStore* store = m_data->Stores[name];
+      Geometry geometry;
+      if ( store->Header && store->Header->Has("AnnieGeometry")
+        && store->Header->Get("AnnieGeometry", geometry) )
+      {
+        m_data->UpdateGeometry(geometry);
+        break;
+      }
+    }
+  }
+
+  // Replace the request that this event used up
+  send_frames(*socket_, { "READY" });
+
+  // Look at the next message to find out whether this is the last event
+  // that this worker will receive
+  if ( !ReceiveFromBroker(next_frames_) ) {
+    next_frames_.clear();
+    m_data->vars.Set("StopLoop", 1);
+  }
+  else if ( next_frames_.front() == "END" ) m_data->vars.Set("StopLoop", 1);
+
+  m_data->CStore.Set("DistributedEvent", true);
+  m_data->CStore.Set("DistributedEventNumber", sequence_number);
+  m_data->CStore.Set("DistributedEventLast", last);
+  ++events_processed_;
+
+  return true;
+}
+
+bool EventDistributor::Finalise() {
+
+  if (is_broker_) {
+
+    // Tell every worker that has been in touch that there are no more
+    // events, including any whose requests have not been read yet
+    std::vector<std::string> frames;
+    while ( receive_frames(*socket_, frames, 0) ) {
+      if ( frames.size() == 2u && frames.back() == "READY" ) {
+        worker_header_hashes_[ frames.front() ];
+      }
+    }
+    for (const auto& worker : requests_) {
+      worker_header_hashes_[worker];
+    }
+    for (const auto& pair : worker_header_hashes_) {
+      send_frames(*socket_, { pair.first, "END" });
+    }
+
+    Log("EventDistributor: Sent " + std::to_string(next_sequence_number_)
+      + " events to " + std::to_string( worker_header_hashes_.size() )
+      + " workers", 1, verbosity_);
+
+    // Give the queued messages time to reach the workers
+    int linger = static_cast<int>(timeout_ms_);
+    socket_->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+  }
+  else {
+    Log("EventDistributor: Processed " + std::to_string(events_processed_)
+      + " events", 1, verbosity_);
+
+    // Outstanding requests do not need to reach the broker
+    int linger = 0;
+    socket_->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+  }
+
+  socket_.reset();
+  return true;
+}
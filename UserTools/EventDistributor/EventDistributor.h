@@ -0,0 +1,76 @@
+// Hands events out to worker ToolChain processes over ZeroMQ
+//
+// In a "Broker" ToolChain, EventDistributor follows the loader tool and
+// sends each event to the next worker that asks for one (a ROUTER socket, so
+// faster workers get more events). In each "Worker" ToolChain, it is the
+// first tool, and receives the events into the worker's stores. The worker's
+// EventCollector tool then sends the processed events on to the collector
+// process (see UserTools/EventCollector).
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ZeroMQ includes
+#include <zmq.hpp>
+
+// ToolAnalysis includes
+#include "Tool.h"
+
+class EventDistributor: public Tool {
+
+  public:
+
+    EventDistributor();
+    bool Initialise(std::string configfile, DataModel& data);
+    bool Execute();
+    bool Finalise();
+
+  protected:
+
+    bool ExecuteBroker();
+    bool ExecuteWorker();
+
+    /// @brief Wait for the next message from the broker
+    /// @return false if nothing arrived before the timeout
+    bool ReceiveFromBroker(std::vector<std::string>& frames);
+
+    /// @brief Integer code that determines the level of logging to show in
+    /// the output
+    int verbosity_;
+
+    /// @brief Whether this is the broker (true) or a worker (false)
+    bool is_broker_;
+
+    /// @brief Names of the stores sent with each event
+    std::vector<std::string> store_names_;
+
+    /// @brief How long to wait for a message, or -1 to wait forever
+    long timeout_ms_;
+
+    std::unique_ptr<zmq::socket_t> socket_;
+
+    /// @brief Sequence number of the next event to send (broker only)
+    uint64_t next_sequence_number_;
+
+    /// @brief One entry per event requested by a worker, holding the
+    /// worker's identity (broker only)
+    std::deque<std::string> requests_;
+
+    /// @brief Hash of the header of each store last sent to each worker
+    /// (broker only)
+    std::map< std::string, std::map<std::string, uint64_t> >
+      worker_header_hashes_;
+
+    /// @brief Event received ahead of the one being processed, used to find
+    /// out whether the current event is the last one (worker only)
+    std::vector<std::string> next_frames_;
+
+    /// @brief Number of events processed by this worker
+    uint64_t events_processed_;
+};
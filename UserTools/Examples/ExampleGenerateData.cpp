@@ -1,4 +1,5 @@
 #include "ExampleGenerateData.h"
+#include "Sharding.h"
 
 ExampleGenerateData::ExampleGenerateData():Tool(){}
 
@@ -12,6 +13,9 @@ bool ExampleGenerateData::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
+  // Every shard would generate the same events
+  if ( Sharding::Unsupported("ExampleGenerateData") ) return false;
+
   //// loading values from config file
   m_variables.Get("NumEvents",NumEvents);
   m_variables.Get("verbose",verbose);
@@ -1,4 +1,5 @@
 #include "ExampleLoadRoot.h"
+#include "Sharding.h"
 
 ExampleLoadRoot::ExampleLoadRoot():Tool(){}
 
@@ -12,6 +13,9 @@ bool ExampleLoadRoot::Initialise(std::string configfile, DataModel &data){
 
   m_data= &data; //assigning transient data pointer
 
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("ExampleLoadRoot") ) return false;
+
   /////////////////////////////////////////////////////////////////
 
   m_variables.Get("verbose",verbose);
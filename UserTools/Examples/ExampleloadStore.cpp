@@ -1,4 +1,5 @@
 #include "ExampleloadStore.h"
+#include "Sharding.h"
 
 ExampleloadStore::ExampleloadStore():Tool(){}
 
@@ -12,6 +13,9 @@ bool ExampleloadStore::Initialise(std::string configfile, DataModel &data){
 
   m_data= &data; //assigning transient data pointer
 
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("ExampleloadStore") ) return false;
+
   /////////////////////////////////////////////////////////////////
 
   m_variables.Get("verbose",verbose);
@@ -1,6 +1,7 @@
 #include "../Unity.cpp"
+#include "MonitoredTool.h"
 
-Tool* Factory(std::string tool){
+static Tool* CreateTool(std::string tool){
 Tool* ret=0;
 
 // if (tool=="Type") tool=new Type;
@@ -41,5 +42,15 @@ if (tool=="BeamFetcher") ret=new BeamFetcher;
 if (tool=="FindTrackLengthInWater") ret=new FindTrackLengthInWater;
 if (tool=="LoadANNIEEvent") ret=new LoadANNIEEvent;
 if (tool=="PhaseITreeMaker") ret=new PhaseITreeMaker;
+if (tool=="ANNIEEventMerge") ret=new ANNIEEventMerge;
+if (tool=="Checkpoint") ret=new Checkpoint;
+if (tool=="ParallelSubChain") ret=new ParallelSubChain;
+if (tool=="Pipeline") ret=new Pipeline;
+if (tool=="EventDistributor") ret=new EventDistributor;
+if (tool=="EventCollector") ret=new EventCollector;
 return ret;
 }
+
+Tool* Factory(std::string tool){
+  return monitor_tool(tool, CreateTool(tool));
+}
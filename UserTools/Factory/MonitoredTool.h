@@ -0,0 +1,225 @@
+// Wrapper that times the Initialise, Execute and Finalise calls of a tool
+// for the ToolProfiler (see DataModel/ToolProfiler.h) and the Tracer (see
+// DataModel/Tracer.h), reads the hardware counters around its Execute
+// calls (see DataModel/PerfCounters.h), counts its heap allocations (see
+// DataModel/AllocationTracker.h) and samples the resident memory around
+// its Execute calls (see DataModel/MemoryMonitor.h). In sharding mode it also
+// records any call that fails, so that the worker exits with an error (see
+// DataModel/Sharding.h).
+#pragma once
+
+// standard library includes
+#include <chrono>
+#include <memory>
+#include <string>
+
+// ToolAnalysis includes
+#include "Tool.h"
+#include "AllocationTracker.h"
+#include "MemoryMonitor.h"
+#include "PerfCounters.h"
+#include "Sharding.h"
+#include "ToolProfiler.h"
+#include "Tracer.h"
+
+/// @brief Forwards every call to the wrapped tool and records how long it
+/// took. The timings are merged into the shared ToolProfiler when the tool
+/// is finalised, and each call is added to the trace if tracing is enabled.
+class MonitoredTool : public Tool {
+
+  public:
+
+    MonitoredTool(const std::string& tool_class, Tool* tool)
+      : Tool(), tool_(tool), profile_( ToolProfiler::Shared().enabled() ),
+      memory_( MemoryMonitor::enabled() ), allocation_slot_(0),
+      memory_index_(0), executions_(0u), started_(false), finished_(false)
+    {
+      stats_.tool_class = tool_class;
+      span_names_[ToolProfiler::INITIALISE] = tool_class + "::Initialise";
+      span_names_[ToolProfiler::EXECUTE] = tool_class + "::Execute";
+      span_names_[ToolProfiler::FINALISE] = tool_class + "::Finalise";
+    }
+
+    ~MonitoredTool() {
+      // Report tools that were never finalised (e.g. because an earlier
+      // tool failed), so that the profile is still printed
+      if ( started_ && !finished_ ) Finished();
+    }
+
+    bool Initialise(std::string configfile, DataModel &data) {
+      m_data = &data;
+      stats_.config_file = configfile;
+      allocation_slot_ = AllocationTracker::RegisterTool(
+        stats_.tool_class + '|' + configfile);
+      if (memory_) {
+        memory_index_ = MemoryMonitor::RegisterTool(stats_.tool_class,
+          configfile);
+        MemoryMonitor::Started();
+      }
+      if (profile_) ToolProfiler::Shared().Started();
+      started_ = profile_ || memory_;
+
+      auto start = std::chrono::steady_clock::now();
+      TraceSpan span("tool", span_names_[ToolProfiler::INITIALISE]);
+      bool ok;
+      {
+        AllocationScope scope(allocation_slot_,
+          AllocationTracker::OTHER_PHASE);
+        ok = Call(ToolProfiler::INITIALISE, [&]{
+          return tool_->Initialise(configfile, data); });
+      }
+      Record(ToolProfiler::INITIALISE, start);
+      return ok;
+    }
+
+    bool Execute() {
+      // A shard that has failed will not be merged, so stop its loop rather
+      // than process the rest of the input
+      if ( Sharding::failed() ) {
+        m_data->vars.Set("StopLoop", 1);
+        return true;
+      }
+
+      PerfCounts counts_before, counts_after;
+      bool counted = PerfCounters::enabled()
+        && PerfCounters::Read(counts_before);
+      uint64_t rss_before = memory_ ? MemoryMonitor::ReadRSS() : 0u;
+
+      auto start = std::chrono::steady_clock::now();
+      TraceSpan span("tool", span_names_[ToolProfiler::EXECUTE]);
+      bool ok;
+      {
+        AllocationScope scope(allocation_slot_,
+          AllocationTracker::EXECUTE_PHASE);
+        ok = Call(ToolProfiler::EXECUTE, [&]{ return tool_->Execute(); });
+      }
+      uint64_t ns = Record(ToolProfiler::EXECUTE, start);
+
+      if (memory_) {
+        MemoryMonitor::Executed(memory_index_, rss_before,
+          MemoryMonitor::ReadRSS());
+      }
+
+      // Both reads are of the calling thread's counters
+      if ( counted && PerfCounters::Read(counts_after) ) {
+        for (int c = 0; c < PerfCounters::NUM_COUNTERS; ++c) {
+          if ( !counts_after.valid[c] ) continue;
+          stats_.counter_totals[c] += counts_after.values[c]
+            - counts_before.values[c];
+          stats_.counter_valid[c] = true;
+        }
+        ++stats_.counted_calls;
+      }
+
+      // Only look up the event number for a new slowest call, so that the
+      // usual cost of monitoring is two clock reads
+      if ( profile_ && ns == stats_.phases[ToolProfiler::EXECUTE].max_ns() ) {
+        stats_.slowest_call = executions_;
+        stats_.has_slowest_event = GetEventNumber(stats_.slowest_event);
+      }
+      ++executions_;
+      return ok;
+    }
+
+    bool Finalise() {
+      auto start = std::chrono::steady_clock::now();
+      TraceSpan span("tool", span_names_[ToolProfiler::FINALISE]);
+      bool ok;
+      {
+        AllocationScope scope(allocation_slot_,
+          AllocationTracker::OTHER_PHASE);
+        ok = Call(ToolProfiler::FINALISE, [&]{ return tool_->Finalise(); });
+      }
+      Record(ToolProfiler::FINALISE, start);
+
+      if ( started_ && !finished_ ) Finished();
+      return ok;
+    }
+
+    /// @brief The tool being timed
+    inline Tool* inner() const { return tool_.get(); }
+
+  protected:
+
+    /// @brief Make a call to the wrapped tool, recording a failure for
+    /// Sharding if it returns false or throws
+    template <typename Function> bool Call(ToolProfiler::Phase phase,
+      Function function)
+    {
+      bool ok;
+      try {
+        ok = function();
+      }
+      catch (...) {
+        Sharding::RecordFailure(span_names_[phase]);
+        throw;
+      }
+      if ( !ok ) Sharding::RecordFailure(span_names_[phase]);
+      return ok;
+    }
+
+    void Finished() {
+      finished_ = true;
+      if (profile_) ToolProfiler::Shared().Finished(stats_);
+      if (memory_) MemoryMonitor::Finished();
+    }
+
+    inline uint64_t Record(ToolProfiler::Phase phase,
+      std::chrono::steady_clock::time_point start)
+    {
+      uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+      stats_.phases[phase].Add(ns);
+      return ns;
+    }
+
+    /// @brief Get the EventNumber from the ANNIEEvent store, which some
+    /// loaders write as a uint32_t and others as a uint64_t
+    bool GetEventNumber(uint64_t& event_number) {
+      auto found = m_data->Stores.find("ANNIEEvent");
+      if ( found == m_data->Stores.end() || !found->second ) return false;
+      try {
+        if ( found->second->Get("EventNumber", event_number) ) return true;
+      }
+      catch (...) {}
+      try {
+        uint32_t event_number32;
+        if ( found->second->Get("EventNumber", event_number32) ) {
+          event_number = event_number32;
+          return true;
+        }
+      }
+      catch (...) {}
+      return false;
+    }
+
+    std::unique_ptr<Tool> tool_;
+    bool profile_;
+    bool memory_;
+    std::string span_names_[ToolProfiler::NUM_PHASES];
+    int allocation_slot_;
+    int memory_index_;
+    ToolProfiler::ToolStats stats_;
+    uint64_t executions_;
+    bool started_;
+    bool finished_;
+};
+
+/// @brief Wrap a tool made by the Factory if profiling, tracing, memory
+/// monitoring or sharding is enabled
+inline Tool* monitor_tool(const std::string& tool_class, Tool* tool) {
+  if ( !tool || !( ToolProfiler::Shared().enabled() || Tracer::enabled()
+    || PerfCounters::enabled() || AllocationTracker::enabled()
+    || MemoryMonitor::enabled() || Sharding::enabled() ) )
+  {
+    return tool;
+  }
+  return new MonitoredTool(tool_class, tool);
+}
+
+/// @brief The tool inside a MonitoredTool, or the tool itself. Use this
+/// before casting a tool made by the Factory to another type.
+inline Tool* unwrap_tool(Tool* tool) {
+  MonitoredTool* monitored = dynamic_cast<MonitoredTool*>(tool);
+  return monitored ? monitored->inner() : tool;
+}
@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "FindMrdTracks.h"
+#include "Sharding.h"
 #include "TCanvas.h"
 #include <numeric>      // std::iota
 
@@ -23,11 +24,24 @@ bool FindMrdTracks::Initialise(std::string configfile, DataModel &data){
 	m_variables.Get("MinDigitsForTrack",minimumdigits);
 	m_variables.Get("MaxMrdSubEventDuration",maxsubeventduration);
 	m_variables.Get("WriteTracksToFile",writefile);
+	m_variables.Get("AutoSaveEvents",autosaveevents);
 	
 	// create a BoostStore for recording the found tracks
 	m_data->Stores["MRDSubEvents"] = new BoostStore(2,false);
 	
-	m_data->Stores["ANNIEEvent"]->Header->Get("AnnieGeometry",geo);
+	// use the geometry shared through the DataModel, falling back to the header
+	geo = m_data->GetGeometry();
+	if(geo==nullptr){
+		Geometry* headergeo=nullptr;
+		m_data->Stores["ANNIEEvent"]->Header->Get("AnnieGeometry",headergeo);
+		if(headergeo) m_data->UpdateGeometry(*headergeo);
+		geo = m_data->GetGeometry();
+	}
+	if(geo==nullptr){
+		cerr<<"FindMrdTracks could not find the AnnieGeometry"<<endl;
+		return false;
+	}
+	geohash = m_data->GetGeometryHash();
 	numvetopmts = geo->GetNumVetoPMTs();
 	
 	// create clonesarray for storing the MRD Track details as they're found
@@ -41,6 +55,13 @@ bool FindMrdTracks::Execute(){
 	
 	if(verbose) cout<<"Tool FindMrdTracks finding tracks in next event."<<endl;
 	
+	// only refresh the geometry if a new input file brought a different one
+	if(m_data->GetGeometryHash()!=geohash){
+		geo = m_data->GetGeometry();
+		geohash = m_data->GetGeometryHash();
+		numvetopmts = geo->GetNumVetoPMTs();
+	}
+	
 	int lastrunnum=runnum;
 	int lastsubrunnum=subrunnum;
 	
@@ -117,7 +138,7 @@ if your class contains pointers, use TrackArray.Clear("C"). You MUST then provid
 			//mrdtree->Fill();						// fill the branches so the entries align.
 			mrdtrackfile->cd();
 			mrdtree->SetEntries(nummrdtracksthiseventb->GetEntries());
-			mrdtree->Write("",TObject::kOverwrite);
+			AutoSaveTree();
 			gROOT->cd();
 		}
 		return true;
@@ -370,7 +391,7 @@ if your class contains pointers, use TrackArray.Clear("C"). You MUST then provid
 	if(writefile){
 		mrdtrackfile->cd();
 		mrdtree->SetEntries(nummrdtracksthiseventb->GetEntries());
-		mrdtree->Write("",TObject::kOverwrite);
+		AutoSaveTree();
 	}
 	if(cMRDSubEvent::imgcanvas) cMRDSubEvent::imgcanvas->Update();
 	gROOT->cd();
@@ -465,8 +486,9 @@ if your class contains pointers, use TrackArray.Clear("C"). You MUST then provid
 
 void FindMrdTracks::StartNewFile(){
 	TString filenameout = TString::Format("%s/mrdtrackfile.%d.%d.root",outputdir.c_str(),runnum,subrunnum);
+	filenameout = Sharding::OutputPath(filenameout.Data(),Sharding::OutputType::ROOTFile).c_str();
 	if(verbose) cout<<"creating mrd output file "<<filenameout.Data()<<endl;
-	if(mrdtrackfile) mrdtrackfile->Close();
+	CloseFile();
 	mrdtrackfile = new TFile(filenameout.Data(),"RECREATE","MRD Tracks file");
 	mrdtrackfile->cd();
 	mrdtree = new TTree("mrdtree","Tree for reconstruction data");
@@ -478,14 +500,32 @@ void FindMrdTracks::StartNewFile(){
 	gROOT->cd();
 }
 
+void FindMrdTracks::AutoSaveTree(){
+	// The branches are filled individually, so the tree's own AutoFlush and
+	// AutoSave (which are triggered by TTree::Fill) never run. By default the
+	// tree is saved after every event, as before; saving it every
+	// autosaveevents events instead is faster, but a crash loses the events
+	// since the last save.
+	if(autosaveevents>0 && (mrdtree->GetEntries()%autosaveevents)==0){
+		mrdtree->AutoSave("SaveSelf");
+	}
+}
+
+void FindMrdTracks::CloseFile(){
+	if(mrdtrackfile==nullptr) return;
+	mrdtrackfile->cd();
+	if(mrdtree) mrdtree->Write("",TObject::kOverwrite);
+	mrdtrackfile->Close();
+	delete mrdtrackfile;
+	mrdtrackfile=nullptr;
+	mrdtree=nullptr;  // owned and deleted by the file
+	gROOT->cd();
+}
+
 
 bool FindMrdTracks::Finalise(){
 	//SubEventArray->Clear("C");
-	if(mrdtrackfile){
-		mrdtrackfile->Close();
-		delete mrdtrackfile;
-		mrdtrackfile=nullptr;
-	}
+	CloseFile();
 	//if(SubEventArray){ SubEventArray->Delete(); delete SubEventArray; SubEventArray=0;}
 	return true;
 }
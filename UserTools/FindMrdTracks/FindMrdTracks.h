@@ -29,6 +29,8 @@ public:
 	bool Finalise();
 	
 	void StartNewFile();
+	void AutoSaveTree();
+	void CloseFile();
 	
 private:
 	//ANNIEEvent* annieevent=nullptr; // used for retrieving the current event
@@ -36,7 +38,8 @@ private:
 	int runnum, subrunnum, eventnum, triggernum;
 	std::string currentfilestring;  // raw / MC file being analyzed
 	std::map<ChannelKey,vector<Hit>>* TDCData;
-	Geometry* geo=nullptr;
+	const Geometry* geo=nullptr;    // shared geometry owned by the DataModel
+	uint64_t geohash=0;             // hash of geo, used to spot a new geometry
 	int numvetopmts=0;              // current method for separating veto / mrd pmts in TDCData
 	
 	// MRD TRACK RECONSTRUCTION
@@ -44,6 +47,7 @@ private:
 	// variables for file writing
 	TFile* mrdtrackfile=0;
 	TTree* mrdtree=0;  // mrd track reconstruction tree
+	int autosaveevents=1;  // save the tree to the file every this many events
 	std::vector<double> mrddigittimesthisevent;
 	std::vector<int> mrddigitpmtsthisevent;
 	std::vector<double> mrddigitchargesthisevent;
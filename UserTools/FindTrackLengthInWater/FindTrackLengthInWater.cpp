@@ -1,4 +1,6 @@
 #include "FindTrackLengthInWater.h"
+#include "Sharding.h"
+#include "Tracer.h"
 
 FindTrackLengthInWater::FindTrackLengthInWater():Tool(){}
 
@@ -11,6 +13,10 @@ bool FindTrackLengthInWater::Initialise(std::string configfile, DataModel &data)
 
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
+
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("FindTrackLengthInWater") ) return false;
+
   // get configuration variables for this tool 
   m_variables.Get("InputFile",infile);
 
@@ -101,7 +107,10 @@ bool FindTrackLengthInWater::Execute(){
    std::vector<double> *digitX=0; std::vector<double> *digitY=0;  std::vector<double> *digitZ=0; 
    std::vector<double> *digitT=0; std::vector<string>  *digitType=0;
 
-   regTree->GetEntry(currententry);
+   {
+     TraceSpan span("io", "TTree::GetEntry");
+     regTree->GetEntry(currententry);
+   }
 
    regTree->SetBranchAddress("run", &run);
    regTree->SetBranchAddress("event", &event);
@@ -1,4 +1,5 @@
 #include "GenerateHits.h"
+#include "Sharding.h"
 
 GenerateHits::GenerateHits():Tool(){}
 
@@ -12,6 +13,9 @@ bool GenerateHits::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
+  // Every shard would generate the same events
+  if ( Sharding::Unsupported("GenerateHits") ) return false;
+
   return true;
 }
 
@@ -8,8 +8,9 @@
 #include "TVector3.h"
 
 #include "Tool.h"
+#include "ParallelSafe.h"
 
-class LAPPDFindPeak: public Tool {
+class LAPPDFindPeak: public Tool, public ParallelSafe {
 
 
  public:
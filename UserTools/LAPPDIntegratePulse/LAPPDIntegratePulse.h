@@ -5,8 +5,9 @@
 #include <iostream>
 
 #include "Tool.h"
+#include "ParallelSafe.h"
 
-class LAPPDIntegratePulse: public Tool {
+class LAPPDIntegratePulse: public Tool, public ParallelSafe {
 
 
  public:
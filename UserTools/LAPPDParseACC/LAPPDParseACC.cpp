@@ -1,4 +1,5 @@
 #include "LAPPDParseACC.h"
+#include "Sharding.h"
 
 LAPPDParseACC::LAPPDParseACC():Tool(){}
 
@@ -15,11 +16,14 @@ bool LAPPDParseACC::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
-  bool isSim = false;
-  m_data->Stores["ANNIEEvent"]->Header->Set("isSim",isSim);
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("LAPPDParseACC") ) return false;
 
   m_data->Stores["ANNIEEvent"] = new BoostStore(false, 2);
 
+  bool isSim = false;
+  m_data->Stores["ANNIEEvent"]->Header->Set("isSim",isSim);
+
   /* Get Pedestal Data */
   string path;
   m_variables.Get("filepath", path);
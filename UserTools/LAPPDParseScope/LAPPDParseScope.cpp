@@ -1,4 +1,5 @@
 #include "LAPPDParseScope.h"
+#include "Sharding.h"
 #include <stdlib.h>
 #include <TF1.h>
 
@@ -14,6 +15,9 @@ bool LAPPDParseScope::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("LAPPDParseScope") ) return false;
+
   m_data->Stores["ANNIEEvent"]= new BoostStore(false,2);
 
   std::string FileInput = "test.fff";	 //default input file name
@@ -47,26 +47,26 @@ bool LAPPDSaveROOT::Initialise(std::string configfile, DataModel &data){
   outtree->Branch("Twidth",&twidth);
 
   // declare the histograms
-  hAmp = new TH1D*[NChannel];
-  hTime = new TH1D*[NChannel];
-  hQ = new TH1D*[NChannel];
+  hAmp.resize(NChannel);
+  hTime.resize(NChannel);
+  hQ.resize(NChannel);
 
   // initialize the histograms
   for(int i=0; i<NChannel; i++){
     TString AmpName;
     AmpName+="Amplitudes_CH";
     AmpName+=i;
-    hAmp[i] = new TH1D(AmpName,AmpName,1000,0.,50.);
+    hAmp[i] = histograms.Register(new TH1D(AmpName,AmpName,1000,0.,50.));
 
     TString QName;
     QName+="Charge_CH";
     QName+=i;
-    hQ[i] = new TH1D(QName,QName,8800,-1e7,10e7);
+    hQ[i] = histograms.Register(new TH1D(QName,QName,8800,-1e7,10e7));
 
     TString TimeName;
     TimeName+="Time_CH";
     TimeName+=i;
-    hTime[i] = new TH1D(TimeName,TimeName,10000,0.,100000.);
+    hTime[i] = histograms.Register(new TH1D(TimeName,TimeName,10000,0.,100000.));
   }
 
   return true;
@@ -211,11 +211,14 @@ bool LAPPDSaveROOT::Finalise(){
   // go to the top level of the output file
   tf->cd();
 
+  // add up the histograms filled on other threads
+  histograms.Merge();
+
   // write the summary histos to file
   for(int i=0; i<NChannel; i++){
-    hAmp[i]->Write();
-    hTime[i]->Write();
-    hQ[i]->Write();
+    hAmp[i].merged()->Write();
+    hTime[i].merged()->Write();
+    hQ[i].merged()->Write();
   }
   // write the output tree to file
   outtree->Write();
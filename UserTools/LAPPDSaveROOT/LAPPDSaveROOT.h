@@ -3,11 +3,13 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 #include "TFile.h"
 #include "TH1D.h"
 #include "TString.h"
 
 #include "Tool.h"
+#include "HistogramRegistry.h"
 
 class LAPPDSaveROOT: public Tool {
 
@@ -29,9 +31,12 @@ class LAPPDSaveROOT: public Tool {
    int NChannel;
    int TrigChannel;
    int NHistos;
-   TH1D** hAmp;
-   TH1D** hQ;
-   TH1D** hTime;
+   // summary histograms, filled through handles so that channels may be
+   // processed on several threads
+   HistogramRegistry histograms;
+   std::vector<HistogramHandle<TH1D>> hAmp;
+   std::vector<HistogramHandle<TH1D>> hQ;
+   std::vector<HistogramHandle<TH1D>> hTime;
    bool isFiltered;
    bool isIntegrated;
    bool isSim;
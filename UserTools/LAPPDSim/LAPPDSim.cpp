@@ -21,9 +21,6 @@ bool LAPPDSim::Initialise(std::string configfile, DataModel &data){
   bool isSim = true;
   m_data->Stores["ANNIEEvent"]->Header->Set("isSim",isSim);
 
-  // initialize the ROOT random number generator
-  myTR = new TRandom3();
-
   m_variables.Get("SimInput", SimInput);
 
   iter=0;
@@ -42,6 +39,14 @@ bool LAPPDSim::Execute(){
   std::map<int,vector<LAPPDHit>> lappdmchits;
   bool testval =  m_data->Stores["ANNIEEvent"]->Get("MCLAPPDHit",lappdmchits);
 
+  // the random numbers depend only on the event, so the results are the
+  // same whatever the order in which events are processed
+  uint64_t eventnumber = iter;
+  uint32_t runnumber = 0;
+  m_data->Stores["ANNIEEvent"]->Get("EventNumber",eventnumber);
+  m_data->Stores["ANNIEEvent"]->Get("RunNumber",runnumber);
+  myTR = m_data->RandomStream(runnumber, eventnumber, "LAPPDSim", "pulses");
+
   map <int, vector<LAPPDHit>> :: iterator itr;
 
   // loop over the number of lappds
@@ -53,6 +58,7 @@ bool LAPPDSim::Execute(){
     std::vector<double> pulsetimes;
     //LAPPDresponse* response = new LAPPDresponse();  //SD
     LAPPDresponse response;
+    response.SetRandomStream(m_data->RandomStream(runnumber, eventnumber, "LAPPDSim", "response"+std::to_string(tubeno)));
 
     // loop over the pulses on each lappd
     for(int j=0; j<mchits.size(); j++){
@@ -126,7 +132,7 @@ Waveform<double> LAPPDSim::SimpleGenPulse(vector<double> pulsetimes){
       aGauss[i] = new TF1(gname,"gaus",0,256);
 
       // random pulse amplitude chosen with from a gaussian distribution
-      double theamp = fabs(myTR->Gaus(30.,30.)); // 30 mV mean, 30 mV sigma
+      double theamp = fabs(myTR.Gaus(30.,30.)); // 30 mV mean, 30 mV sigma
 
       aGauss[i]->SetParameter(0,theamp); // amplitude of the pulse
       aGauss[i]->SetParameter(1,pulsetimes.at(i)); // peak location (in samples)
@@ -138,7 +144,7 @@ Waveform<double> LAPPDSim::SimpleGenPulse(vector<double> pulsetimes){
     Waveform<double> thewav;
     for(int i=0; i<256; i++){
 
-      double noise = myTR->Gaus(0.,2.0); //add in random baseline noise (2 mV sig)
+      double noise = myTR.Gaus(0.,2.0); //add in random baseline noise (2 mV sig)
       double signal = 0;
 
       //now add all the pulses to the signal
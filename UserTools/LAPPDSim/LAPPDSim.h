@@ -20,8 +20,8 @@ class LAPPDSim: public Tool {
 
  private:
 
-   //ROOT random number generator
-   TRandom3* myTR;
+   // random stream for the current event (see DataModel/RandomStreams.h)
+   CounterRNG myTR;
    TString SimInput;
 
    int iter=0;
@@ -4,6 +4,7 @@
 #include "TFile.h"
 #include "TH1.h"
 #include "TF1.h"
+#include "TMath.h"
 #include "TimeClass.h"
 #include <vector>
 #include <iostream>
@@ -29,9 +30,6 @@ LAPPDresponse::LAPPDresponse()
 
   // structure to store the pulses, count them, and organize them by channel
   //_pulseCluster = new LAPPDpulseCluster()  This is no longer needed, kept for reference for now
-
-  // random numbers for generating noise
-  mrand = new TRandom3();
 }
 LAPPDresponse::~LAPPDresponse()
 {
@@ -43,7 +41,7 @@ LAPPDresponse::~LAPPDresponse()
 void LAPPDresponse::AddSinglePhotonTrace(double trans, double para, double time)
 {
   // Draw a random value for the peak signal peak
-  double peak = (_PHD->GetRandom())/10.;
+  double peak = (this->GetRandom(_PHD))/10.;
 
   // find nearest strip
   int neareststripnum = this->FindStripNumber(trans);
@@ -150,7 +148,7 @@ Waveform<double> LAPPDresponse::GetTrace(int CHnumber, double starttime, double
   if(LAPPDPulseCluster.count(CHnumber)==0) {   //SD
     for(int j=0; j<numsamples; j++){
 
-      double mnoise = thenoise*(mrand->Rndm()-0.5);
+      double mnoise = thenoise*(mrand.Rndm()-0.5);
 
       trace->SetBinContent(j+1, mnoise);
 
@@ -199,7 +197,7 @@ Waveform<double> LAPPDresponse::GetTrace(int CHnumber, double starttime, double
         double mnoise=0.0;
 
         //only add the noise on ONCE
-        if(k==0) mnoise = thenoise*(mrand->Rndm()-0.5);
+        if(k==0) mnoise = thenoise*(mrand.Rndm()-0.5);
         mbincontent+=mnoise;
 
         //if the sample time actually falls in the window for when the pulse
@@ -258,3 +256,18 @@ double LAPPDresponse::StripCoordinate(int stripnumber){
   return coor;
 
 }
+
+
+double LAPPDresponse::GetRandom(TH1D* hist)
+{
+  // same method as TH1::GetRandom, which always draws from gRandom
+  int nbins = hist->GetNbinsX();
+  double* integral = hist->GetIntegral();
+  if(integral[nbins]==0) return 0;
+
+  double r1 = mrand.Rndm();
+  int ibin = TMath::BinarySearch(nbins,integral,r1);
+  double x = hist->GetBinLowEdge(ibin+1);
+  if(r1>integral[ibin]) x += hist->GetBinWidth(ibin+1)*(r1-integral[ibin])/(integral[ibin+1]-integral[ibin]);
+  return x;
+}
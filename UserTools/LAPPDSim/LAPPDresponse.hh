@@ -5,7 +5,7 @@
 //#include "LAPPDpulseCluster.hh"
 #include "TObject.h"
 #include "TH1.h"
-#include "TRandom3.h"
+#include "RandomStreams.h"
 #include <map>
 #include "Tool.h"
 #include "LAPPDPulse.h"
@@ -25,6 +25,9 @@ class LAPPDresponse {
 
   int FindStripNumber(double trans);
 
+  // set the random stream used for the noise and pulse heights
+  void SetRandomStream(const CounterRNG& rng) {mrand = rng;}
+
   double StripCoordinate(int stripnumber);
 
   map <int, vector<LAPPDPulse> > LAPPDPulseCluster;  //SD
@@ -50,7 +53,10 @@ class LAPPDresponse {
   //  LAPPDpulseCluster* _pulseCluster;
 
   //randomizer
-  TRandom3* mrand;
+  CounterRNG mrand;
+
+  // draw a value from a histogram using mrand (like TH1::GetRandom)
+  double GetRandom(TH1D* hist);
 
   //useful functions
   int FindNearestStrip(double trans);
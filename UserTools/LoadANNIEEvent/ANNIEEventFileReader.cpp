@@ -0,0 +1,173 @@
+// standard library includes
+#include <limits>
+
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "ANNIEEventFileReader.h"
+#include "Sharding.h"
+#include "Tracer.h"
+
+bool get_annie_event_time(BoostStore& store, uint64_t& time_ns) {
+
+  try {
+    if ( store.Has("TriggerData") ) {
+      std::vector<TriggerClass> triggers;
+      if ( store.Get("TriggerData", triggers) && !triggers.empty() ) {
+        time_ns = std::numeric_limits<uint64_t>::max();
+        for (auto& trigger : triggers) {
+          uint64_t trigger_ns = trigger.GetTime().GetNs();
+          if (trigger_ns < time_ns) time_ns = trigger_ns;
+        }
+        return true;
+      }
+    }
+
+    TimeClass event_time;
+    if ( store.Has("EventTime") && store.Get("EventTime", event_time) ) {
+      time_ns = event_time.GetNs();
+      return true;
+    }
+
+    std::vector<TimeClass> mb_timestamps;
+    if ( store.Has("MinibufferTimestamps")
+      && store.Get("MinibufferTimestamps", mb_timestamps)
+      && !mb_timestamps.empty() )
+    {
+      time_ns = mb_timestamps.front().GetNs();
+      return true;
+    }
+  }
+  catch (const std::exception&) {}
+
+  return false;
+}
+
+ANNIEEventFileReader::ANNIEEventFileReader(const std::string& filename,
+  size_t file_index, size_t max_queued, bool need_time, size_t first_entry,
+  bool shard_entries) : filename_(filename), file_index_(file_index),
+  max_queued_(max_queued > 0u ? max_queued : 1u), need_time_(need_time),
+  first_entry_(first_entry), next_entry_(first_entry),
+  shard_entries_(shard_entries), header_ready_(false),
+  done_(false), stop_(false)
+{
+  thread_ = std::thread(&ANNIEEventFileReader::Read, this);
+}
+
+ANNIEEventFileReader::~ANNIEEventFileReader() {
+  {
+    // Set under the lock so that the reader can't miss the notification
+    // between checking stop_ and starting to wait
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if ( thread_.joinable() ) thread_.join();
+}
+
+bool ANNIEEventFileReader::WaitForHeader() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]{ return header_ready_; });
+  return error_.empty();
+}
+
+const DecodedANNIEEvent* ANNIEEventFileReader::Peek() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]{ return !queue_.empty() || done_; });
+  if ( queue_.empty() ) return nullptr;
+  return &queue_.front();
+}
+
+void ANNIEEventFileReader::Pop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ( !queue_.empty() ) {
+      next_entry_ = queue_.front().entry + 1u;
+      queue_.pop_front();
+    }
+  }
+  cond_.notify_all();
+}
+
+void ANNIEEventFileReader::Read() {
+
+  Tracer::SetThreadName("ANNIEEvent reader " + std::to_string(file_index_));
+  BoostStore input(false, BOOST_STORE_MULTIEVENT_FORMAT);
+  long total_entries = 0;
+
+  // Read the header first so that the main thread can apply it while
+  // the entries are still being read
+  try {
+    if ( !input.Initialise(filename_) ) error_ = "could not open the file";
+    else if ( !archive_store(*input.Header, header_archive_) ) {
+      error_ = "could not archive the file header";
+    }
+    else {
+      input.Header->Get("TotalEntries", total_entries);
+
+      Geometry geometry;
+      if ( input.Header->Get("AnnieGeometry", geometry) ) {
+        geometry_.reset( new Geometry(geometry) );
+      }
+    }
+  }
+  catch (const std::exception& e) {
+    error_ = e.what();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    header_ready_ = true;
+    if ( !error_.empty() ) done_ = true;
+  }
+  cond_.notify_all();
+  if ( !error_.empty() ) return;
+
+  // Read only this process's slice of the entries when sharding by entry
+  size_t begin_entry = first_entry_;
+  size_t end_entry = (total_entries > 0) ? total_entries : 0u;
+  if (shard_entries_) {
+    size_t slice_begin;
+    Sharding::Slice(end_entry, slice_begin, end_entry);
+    if ( begin_entry < slice_begin ) begin_entry = slice_begin;
+  }
+
+  for (size_t entry = begin_entry; entry < end_entry && !stop_; ++entry) {
+
+    DecodedANNIEEvent decoded;
+    decoded.file_index = file_index_;
+    decoded.entry = entry;
+
+    {
+      TraceSpan span("io", "BoostStore::GetEntry");
+      input.GetEntry(entry);
+    }
+    {
+      TraceSpan span("io", "archive_store");
+      if ( !archive_store(input, decoded.archive) ) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = "could not archive entry " + std::to_string(entry);
+        break;
+      }
+    }
+    if (need_time_) {
+      TraceSpan span("io", "BoostStore::Get");
+      decoded.has_time = get_annie_event_time(input, decoded.time_ns);
+    }
+
+    TraceSpan wait_span("wait", "Wait for queue space");
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]{ return queue_.size() < max_queued_ || stop_; });
+    if (stop_) break;
+    queue_.push_back( std::move(decoded) );
+    lock.unlock();
+    cond_.notify_all();
+  }
+
+  input.Close();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  cond_.notify_all();
+}
@@ -0,0 +1,127 @@
+#pragma once
+// Background reader used by the LoadANNIEEvent tool to open and decode a
+// multi-event ANNIEEvent file on its own thread
+//
+// Each entry is loaded from the file on the reader thread and archived as a
+// whole store (see DataModel/StoreCopy.h), so that every key is kept byte for
+// byte whatever its type. The archived entries are buffered in a bounded
+// queue until the main thread restores them into the ANNIEEvent store that
+// the rest of the ToolChain sees.
+
+// standard library includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ToolAnalysis includes
+#include "BoostStore.h"
+#include "Geometry.h"
+#include "StoreCopy.h"
+
+/// @brief A single ANNIEEvent entry read by an ANNIEEventFileReader
+struct DecodedANNIEEvent {
+  /// @brief Index of the file (in the LoadANNIEEvent input list) that
+  /// contains this entry
+  size_t file_index = 0u;
+  /// @brief Index of this entry within its file
+  size_t entry = 0u;
+  /// @brief Trigger time (ns since the Unix epoch) used to sort entries
+  uint64_t time_ns = 0u;
+  /// @brief Whether time_ns could be determined for this entry
+  bool has_time = false;
+  /// @brief The entry's store, as written by archive_store()
+  std::string archive;
+
+  /// @brief Replace the contents of a store with this entry
+  /// @return false if the entry could not be restored
+  inline bool apply(BoostStore& store) const {
+    return restore_store(archive, store);
+  }
+};
+
+/// @brief Find the time of an ANNIEEvent entry, trying the earliest
+/// TriggerTime in TriggerData, then EventTime, then the first minibuffer
+/// timestamp
+bool get_annie_event_time(BoostStore& store, uint64_t& time_ns);
+
+class ANNIEEventFileReader {
+
+  public:
+
+    /// @param filename Name of the ANNIEEvent file to read
+    /// @param file_index Index of the file in the input list
+    /// @param max_queued Maximum number of entries to buffer
+    /// @param need_time Whether to determine the time of each entry
+    /// @param first_entry Index of the first entry to read (used to resume
+    /// from a checkpoint)
+    /// @param shard_entries Whether to read only this process's slice of the
+    /// entries (see Sharding.h)
+    ANNIEEventFileReader(const std::string& filename, size_t file_index,
+      size_t max_queued, bool need_time, size_t first_entry = 0u,
+      bool shard_entries = false);
+
+    /// @brief Stops the reader thread, discarding any unread entries
+    ~ANNIEEventFileReader();
+
+    ANNIEEventFileReader(const ANNIEEventFileReader&) = delete;
+    ANNIEEventFileReader& operator=(const ANNIEEventFileReader&) = delete;
+
+    /// @brief Wait until the next entry has been read and return a
+    /// pointer to it, or nullptr if there are no more entries
+    const DecodedANNIEEvent* Peek();
+
+    /// @brief Remove the entry returned by the last call to Peek()
+    void Pop();
+
+    /// @brief Wait until the file header has been read
+    /// @return false if the file could not be opened
+    bool WaitForHeader();
+
+    /// @brief The file header, as written by archive_store() (valid after
+    /// WaitForHeader)
+    inline const std::string& header_archive() const
+      { return header_archive_; }
+
+    /// @brief Detector geometry from the header, or nullptr if there was
+    /// none (valid after WaitForHeader)
+    inline const Geometry* geometry() const { return geometry_.get(); }
+
+    /// @brief Index of the entry after the last one removed with Pop()
+    inline size_t next_entry() const { return next_entry_; }
+
+    inline const std::string& filename() const { return filename_; }
+    inline size_t file_index() const { return file_index_; }
+    inline const std::string& error() const { return error_; }
+
+  protected:
+
+    /// @brief Function run by the reader thread
+    void Read();
+
+    std::string filename_;
+    size_t file_index_;
+    size_t max_queued_;
+    bool need_time_;
+    size_t first_entry_;
+    size_t next_entry_;
+    bool shard_entries_;
+
+    std::string header_archive_;
+    std::unique_ptr<Geometry> geometry_;
+    std::string error_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<DecodedANNIEEvent> queue_;
+    bool header_ready_;
+    bool done_;
+    std::atomic<bool> stop_;
+
+    std::thread thread_;
+};
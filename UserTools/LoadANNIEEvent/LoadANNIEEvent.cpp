@@ -1,8 +1,11 @@
 // standard library includes
 #include <fstream>
+#include <sstream>
 
 // ToolAnalysis includes
 #include "LoadANNIEEvent.h"
+#include "Sharding.h"
+#include "Tracer.h"
 
 LoadANNIEEvent::LoadANNIEEvent():Tool() {}
 
@@ -36,9 +39,69 @@ bool LoadANNIEEvent::Initialise(std::string config_filename, DataModel &data) {
   std::string temp_str;
   while ( list_file >> temp_str ) input_filenames_.push_back( temp_str );
 
+  // When running as one of several shard processes, read only this
+  // process's contiguous slice of the input files (or of each file's
+  // entries)
+  std::string shard_mode = "File";
+  m_variables.Get("ShardMode", shard_mode);
+  shard_entries_ = false;
+  if ( Sharding::enabled() ) {
+    if ( shard_mode == "Entry" ) shard_entries_ = true;
+    else if ( shard_mode == "File" ) {
+      size_t begin, end;
+      Sharding::Slice(input_filenames_.size(), begin, end);
+      input_filenames_ = std::vector<std::string>(
+        input_filenames_.begin() + begin, input_filenames_.begin() + end);
+      if ( input_filenames_.empty() ) {
+        Log("Warning: Shard " + std::to_string( Sharding::index() ) + " has"
+          " no input files. Use ShardMode Entry when there are fewer files"
+          " than shards.", 0, verbosity_);
+      }
+    }
+    else {
+      Log("Error: Unrecognized ShardMode \"" + shard_mode + "\" given to the"
+        " LoadANNIEEvent tool (use File or Entry)", 0, verbosity_);
+      return false;
+    }
+  }
+
   current_entry_ = 0u;
   current_file_ = 0u;
   need_new_file_ = true;
+
+  int num_reader_threads = 1;
+  m_variables.Get("NumReaderThreads", num_reader_threads);
+  num_reader_threads_ = (num_reader_threads > 1) ? num_reader_threads : 1u;
+
+  int reader_queue_size = 16;
+  m_variables.Get("ReaderQueueSize", reader_queue_size);
+  reader_queue_size_ = (reader_queue_size > 1) ? reader_queue_size : 1u;
+
+  std::string output_order = "FileOrder";
+  m_variables.Get("OutputOrder", output_order);
+  if ( output_order == "TriggerTime" ) sort_by_time_ = true;
+  else if ( output_order == "FileOrder" ) sort_by_time_ = false;
+  else {
+    Log("Error: Unrecognized OutputOrder \"" + output_order + "\" given to"
+      " the LoadANNIEEvent tool (use FileOrder or TriggerTime)", 0,
+      verbosity_);
+    return false;
+  }
+
+  next_file_ = 0u;
+  have_header_ = false;
+
+  if ( num_reader_threads_ > 1 ) {
+    Log("Reading up to " + std::to_string(num_reader_threads_) + " ANNIEEvent"
+      " input files concurrently", 1, verbosity_);
+  }
+
+  // Pick up where a previous job left off if there is a checkpoint
+  if ( !m_data->Checkpoints.Register("LoadANNIEEvent", this) ) {
+    Log("Error: Could not restore the LoadANNIEEvent state from the"
+      " checkpoint", 0, verbosity_);
+    return false;
+  }
  
   return true;
 }
@@ -50,7 +113,14 @@ bool LoadANNIEEvent::Execute() {
   m_data->vars.Get("StopLoop", stop_the_loop);
   if ( stop_the_loop == 1 ) return false;
 
-  if (need_new_file_) {
+  if ( num_reader_threads_ > 1 ) return ExecuteParallel();
+
+  if ( input_filenames_.empty() ) {
+    m_data->vars.Set("StopLoop", 1);
+    return true;
+  }
+
+  while (need_new_file_) {
 
     // Delete the old ANNIEEvent Store if there is one
     if ( m_data->Stores.count("ANNIEEvent") ) {
@@ -64,9 +134,43 @@ bool LoadANNIEEvent::Execute() {
 
     // Load it from the new input file
     std::string input_filename = input_filenames_.at(current_file_);
-    m_data->Stores["ANNIEEvent"]->Initialise(input_filename);
+    {
+      TraceSpan span("io", "BoostStore::Initialise");
+      m_data->Stores["ANNIEEvent"]->Initialise(input_filename);
+    }
     m_data->Stores["ANNIEEvent"]->Header->Get("TotalEntries",
       total_entries_in_file_);
+
+    // Deserialize the geometry once per file and share it through the
+    // DataModel. The shared copy is only replaced if it has changed.
+    Geometry geometry;
+    if ( m_data->Stores["ANNIEEvent"]->Header->Get("AnnieGeometry", geometry)
+      && m_data->UpdateGeometry(geometry) )
+    {
+      Log("Loaded new geometry (version "
+        + std::to_string( geometry.GetVersion() ) + ") from the ANNIEEvent"
+        " input file \"" + input_filename + '\"', 1, verbosity_);
+    }
+
+    end_entry_in_file_ = total_entries_in_file_;
+    if (shard_entries_) {
+      size_t begin_entry;
+      Sharding::Slice(total_entries_in_file_, begin_entry, end_entry_in_file_);
+      if ( current_entry_ < begin_entry ) current_entry_ = begin_entry;
+    }
+
+    need_new_file_ = false;
+
+    // This shard may have no entries in the file
+    if ( current_entry_ >= end_entry_in_file_ ) {
+      if ( current_file_ + 1 >= input_filenames_.size() ) {
+        m_data->vars.Set("StopLoop", 1);
+        return true;
+      }
+      ++current_file_;
+      current_entry_ = 0u;
+      need_new_file_ = true;
+    }
   }
 
 
@@ -74,11 +178,14 @@ bool LoadANNIEEvent::Execute() {
     " ANNIEEvent input file \"" + input_filenames_.at(current_file_)
     + '\"', 1, verbosity_);
  
-  m_data->Stores["ANNIEEvent"]->GetEntry(current_entry_);  
+  {
+    TraceSpan span("io", "BoostStore::GetEntry");
+    m_data->Stores["ANNIEEvent"]->GetEntry(current_entry_);
+  }
   ++current_entry_;
   
-  if ( current_entry_ >= total_entries_in_file_ ) {
-    if ( current_file_ >= input_filenames_.size() ) {
+  if ( current_entry_ >= end_entry_in_file_ ) {
+    if ( current_file_ + 1 >= input_filenames_.size() ) {
       m_data->vars.Set("StopLoop", 1);
     }
     else {
@@ -92,6 +199,194 @@ bool LoadANNIEEvent::Execute() {
 }
 
 
+bool LoadANNIEEvent::ExecuteParallel() {
+
+  ANNIEEventFileReader* reader = NextReader();
+  if ( !reader ) {
+    m_data->vars.Set("StopLoop", 1);
+    return true;
+  }
+
+  // In parallel mode, the same ANNIEEvent store is reused for all files
+  if (need_new_file_) {
+    if ( m_data->Stores.count("ANNIEEvent") ) {
+      auto* annie_event = m_data->Stores.at("ANNIEEvent");
+      if (annie_event) delete annie_event;
+    }
+    m_data->Stores["ANNIEEvent"] = new BoostStore(false,
+      BOOST_STORE_MULTIEVENT_FORMAT);
+    need_new_file_ = false;
+  }
+  BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+
+  const DecodedANNIEEvent* decoded = reader->Peek();
+
+  // Apply the header of the entry's file whenever we switch files
+  if ( !have_header_ || decoded->file_index != current_file_ ) {
+    if ( !restore_store(reader->header_archive(), *annie_event->Header) ) {
+      Log("Error: Could not restore the header of the ANNIEEvent input file"
+        " \"" + reader->filename() + '\"', 0, verbosity_);
+      return false;
+    }
+    if ( reader->geometry() && m_data->UpdateGeometry(*reader->geometry()) ) {
+      Log("Loaded new geometry (version "
+        + std::to_string( reader->geometry()->GetVersion() ) + ") from the"
+        " ANNIEEvent input file \"" + reader->filename() + '\"', 1,
+        verbosity_);
+    }
+    current_file_ = decoded->file_index;
+    have_header_ = true;
+  }
+
+  Log("Loading entry " + std::to_string(decoded->entry) + " from the"
+    " ANNIEEvent input file \"" + reader->filename() + '\"', 1, verbosity_);
+
+  {
+    TraceSpan span("io", "restore_store");
+    if ( !decoded->apply(*annie_event) ) {
+      Log("Error: Could not restore entry " + std::to_string(decoded->entry)
+        + " of the ANNIEEvent input file \"" + reader->filename() + '\"', 0,
+        verbosity_);
+      return false;
+    }
+  }
+  reader->Pop();
+
+  // Stop after this entry if it was the last one
+  TraceSpan span("wait", "Wait for reader");
+  if ( !NextReader() ) m_data->vars.Set("StopLoop", 1);
+
+  return true;
+}
+
+
+ANNIEEventFileReader* LoadANNIEEvent::NextReader() {
+
+  while (true) {
+
+    while ( readers_.size() < num_reader_threads_
+      && next_file_ < input_filenames_.size() )
+    {
+      readers_.emplace_back( new ANNIEEventFileReader(
+        input_filenames_.at(next_file_), next_file_, reader_queue_size_,
+        sort_by_time_, 0u, shard_entries_) );
+      ++next_file_;
+    }
+
+    if ( readers_.empty() ) return nullptr;
+
+    // In file order, only the oldest reader matters. Other readers keep
+    // decoding in the background until their queues are full.
+    if (!sort_by_time_) {
+      if ( readers_.front()->Peek() ) return readers_.front().get();
+      if ( !readers_.front()->error().empty() ) {
+        Log("Error: Skipping the ANNIEEvent input file \""
+          + readers_.front()->filename() + "\": "
+          + readers_.front()->error(), 0, verbosity_);
+      }
+      readers_.pop_front();
+      continue;
+    }
+
+    // Otherwise, choose the earliest entry among the files being read.
+    // Entries without a known time are emitted as soon as they are reached.
+    bool removed_reader = false;
+    ANNIEEventFileReader* earliest = nullptr;
+    const DecodedANNIEEvent* earliest_entry = nullptr;
+
+    for (auto iter = readers_.begin(); iter != readers_.end(); ) {
+      const DecodedANNIEEvent* entry = (*iter)->Peek();
+      if ( !entry ) {
+        if ( !(*iter)->error().empty() ) {
+          Log("Error: Skipping the ANNIEEvent input file \""
+            + (*iter)->filename() + "\": " + (*iter)->error(), 0,
+            verbosity_);
+        }
+        iter = readers_.erase(iter);
+        removed_reader = true;
+        continue;
+      }
+      bool is_earlier = !earliest_entry || ( earliest_entry->has_time
+        && ( !entry->has_time || entry->time_ns < earliest_entry->time_ns ) );
+      if (is_earlier) {
+        earliest = iter->get();
+        earliest_entry = entry;
+      }
+      ++iter;
+    }
+
+    // Open replacement readers before choosing, since the new files may
+    // contain earlier entries
+    if (removed_reader) continue;
+
+    return earliest;
+  }
+}
+
+
 bool LoadANNIEEvent::Finalise() {
+  m_data->Checkpoints.Unregister("LoadANNIEEvent");
+  // Stop any reader threads that are still running
+  readers_.clear();
+  return true;
+}
+
+
+bool LoadANNIEEvent::SaveCheckpoint(CheckpointState& state) {
+
+  if ( num_reader_threads_ <= 1 ) {
+    // Position of the next entry to load
+    state.Set("CurrentFile", current_file_);
+    state.Set("CurrentEntry", current_entry_);
+    return true;
+  }
+
+  // For parallel reading, save the next entry of each open file as a list
+  // of "file:entry" pairs. Files before NextFile that are not listed have
+  // been read completely.
+  std::string open_files;
+  for (const auto& reader : readers_) {
+    if ( !open_files.empty() ) open_files += ',';
+    open_files += std::to_string( reader->file_index() ) + ':'
+      + std::to_string( reader->next_entry() );
+  }
+  state.Set("NextFile", next_file_);
+  state.Set("OpenFiles", open_files);
+  return true;
+}
+
+
+bool LoadANNIEEvent::RestoreCheckpoint(const CheckpointState& state) {
+
+  if ( num_reader_threads_ <= 1 ) {
+    if ( !state.Get("CurrentFile", current_file_)
+      || !state.Get("CurrentEntry", current_entry_) ) return false;
+    need_new_file_ = true;
+    Log("Resuming from entry " + std::to_string(current_entry_) + " of input"
+      " file " + std::to_string(current_file_), 1, verbosity_);
+    return true;
+  }
+
+  std::string open_files;
+  if ( !state.Get("NextFile", next_file_) ) return false;
+  state.Get("OpenFiles", open_files);
+
+  readers_.clear();
+  std::istringstream in(open_files);
+  std::string pair;
+  while ( std::getline(in, pair, ',') ) {
+    size_t colon = pair.find(':');
+    if ( colon == std::string::npos ) return false;
+    size_t file_index = std::stoul( pair.substr(0, colon) );
+    size_t first_entry = std::stoul( pair.substr(colon + 1) );
+    if ( file_index >= input_filenames_.size() ) return false;
+    readers_.emplace_back( new ANNIEEventFileReader(
+      input_filenames_.at(file_index), file_index, reader_queue_size_,
+      sort_by_time_, first_entry, shard_entries_) );
+  }
+
+  Log("Resuming parallel reading at input file " + std::to_string(next_file_)
+    + " with " + std::to_string( readers_.size() ) + " partly-read files", 1,
+    verbosity_);
   return true;
 }
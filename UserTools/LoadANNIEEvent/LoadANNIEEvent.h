@@ -1,13 +1,17 @@
 #pragma once
 
 // standard library includes
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
 // ToolAnalysis includes
+#include "ANNIEEventFileReader.h"
+#include "CheckpointManager.h"
 #include "Tool.h"
 
-class LoadANNIEEvent: public Tool {
+class LoadANNIEEvent: public Tool, public Checkpointable {
 
   public:
 
@@ -16,8 +20,20 @@ class LoadANNIEEvent: public Tool {
     bool Execute();
     bool Finalise();
 
+    bool SaveCheckpoint(CheckpointState& state) override;
+    bool RestoreCheckpoint(const CheckpointState& state) override;
+
   protected:
 
+    /// @brief Execute() implementation used when the input files are read
+    /// by background threads
+    bool ExecuteParallel();
+
+    /// @brief Open input files until there are num_reader_threads_ readers,
+    /// and return the reader that holds the next entry to emit (or nullptr
+    /// if all of the files have been read)
+    ANNIEEventFileReader* NextReader();
+
     /// @brief Integer code that determines the level of logging to show in
     /// the output
     int verbosity_;
@@ -34,8 +50,36 @@ class LoadANNIEEvent: public Tool {
     /// @brief The total number of ANNIEEvent entries in the current file
     size_t total_entries_in_file_;
 
+    /// @brief Index after the last entry to load from the current file
+    size_t end_entry_in_file_;
+
+    /// @brief Whether each shard process reads a slice of the entries in
+    /// every file (true) or a slice of the files (false)
+    bool shard_entries_;
+
     /// @brief Flag indicating whether we need to load a new file
     bool need_new_file_;
 
+    /// @brief Number of input files to read concurrently. A value of 1
+    /// reads the files one at a time on the main thread.
+    size_t num_reader_threads_;
+
+    /// @brief Maximum number of decoded entries buffered by each reader
+    size_t reader_queue_size_;
+
+    /// @brief Whether entries from the files being read concurrently are
+    /// emitted in time order (true) or in file order (false)
+    bool sort_by_time_;
+
+    /// @brief Readers for the files currently being read, in file order
+    std::deque< std::unique_ptr<ANNIEEventFileReader> > readers_;
+
+    /// @brief Index of the next input file to give to a reader
+    size_t next_file_;
+
+    /// @brief Whether the header of current_file_ has been applied to the
+    /// ANNIEEvent store (parallel reading only)
+    bool have_header_;
+
     std::stringstream logmessage;
 };
@@ -1,6 +1,8 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 
 #include "LoadWCSim.h"
+#include "Sharding.h"
+#include "Tracer.h"
 
 LoadWCSim::LoadWCSim():Tool(){}
 
@@ -15,6 +17,9 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 	
 	m_data= &data; //assigning transient data pointer
 	
+	// Every shard would read the whole input
+	if ( Sharding::Unsupported("LoadWCSim") ) return false;
+	
 	// Get the Tool configuration variables
 	// ====================================
 	m_variables.Get("verbose",verbose);
@@ -127,6 +132,8 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 	                                   nummrdpmts, numvetopmts, numlappds, detectorstatus::ON);
 	if(verbose>1) cout<<"constructed anniegom at "<<anniegeom<<endl;
 	m_data->Stores["ANNIEEvent"]->Header->Set("AnnieGeometry",anniegeom,true);
+	// share an immutable copy with downstream tools through the DataModel
+	m_data->UpdateGeometry(*anniegeom);
 	
 	// Set run-level information in the ANNIEEvent
 	// ===========================================
@@ -157,6 +164,7 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 	if(verbose>1) cout<<"getting Run start time"<<endl;
 	do{
 		MCEventNum++;
+		TraceSpan span("io", "TChain::GetEntry");
 		WCSimEntry->GetEntry(MCEventNum);
 	} while(WCSimEntry->wcsimrootevent->GetNumberOfEvents()==0);
 	atrigt = WCSimEntry->wcsimrootevent->GetTrigger(0);
@@ -187,7 +195,10 @@ bool LoadWCSim::Execute(){
 	//m_data->Stores["ANNIEEvent"]->Clear();
 	
 	if(verbose>1) cout<<"Tool LoadWCSim getting entry "<<MCEventNum<<", trigger "<<MCTriggernum<<endl;
-	WCSimEntry->GetEntry(MCEventNum);
+	{
+		TraceSpan span("io", "TChain::GetEntry");
+		WCSimEntry->GetEntry(MCEventNum);
+	}
 	MCFile = wcsimtree->GetCurrentFile()->GetName();
 	
 	MCParticles->clear();
@@ -396,7 +407,10 @@ bool LoadWCSim::Execute(){
 	
 	// this should be everything. save the entry to the BoostStore
 	if(verbose>2) cout<<"saving"<<endl;
-	m_data->Stores["ANNIEEvent"]->Save();
+	{
+		TraceSpan span("io", "BoostStore::Save");
+		m_data->Stores["ANNIEEvent"]->Save();
+	}
 	
 	MCTriggernum++;
 	if(verbose>2) cout<<"checking if we're done on trigs in this event"<<endl;
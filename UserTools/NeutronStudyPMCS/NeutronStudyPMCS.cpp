@@ -12,9 +12,8 @@ bool NeutronStudyPMCS::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
-  // i should change the random seed here
-  ttr = new TRandom3();
-  trr = new TRandom3();
+  // random numbers are drawn from per-event streams in Execute
+  nevents = 0;
 
   // currently hard coded energy smearing
   muEsmear = 100.; //in MeV
@@ -44,6 +43,14 @@ bool NeutronStudyPMCS::Execute(){
   m_data->Stores["NeutrinoEvent"]->Get("trueQ2",q2);
   m_data->Stores["NeutrinoEvent"]->Get("recoNeutrinoEnergy",recoE);
 
+  // the random numbers depend only on the event, so the results are the
+  // same whatever the order in which events are processed
+  uint64_t eventnumber = nevents;
+  m_data->Stores["NeutrinoEvent"]->Get("EventNumber",eventnumber);
+  ttr = m_data->RandomStream(0, eventnumber, "NeutronStudyPMCS", "efficiency");
+  trr = m_data->RandomStream(0, eventnumber, "NeutronStudyPMCS", "smearing");
+  nevents++;
+
   // Output variables
   int isgoodmuon,isPismeared,Ntotneutsmeared,Nprimneutsmeared,Nbkgdneutrons,Nbkgdneutrons_high;
   int passedselection;
@@ -73,7 +80,7 @@ bool NeutronStudyPMCS::Execute(){
   //efficiency for detecting events based on ANNIE acceptance cuts
   double mueffic = MuonEfficiency(muE,unsmearedMuangle);
   muonefficiency = mueffic;
-  double mroll = ttr->Rndm();
+  double mroll = ttr.Rndm();
   //did the muon pass the ANNIE acceptance cut
   if(mroll<mueffic) {isgoodmuon=1;}
 
@@ -171,7 +178,7 @@ double NeutronStudyPMCS::PionInefficiency(double pi_E, double pi_angle)
 double NeutronStudyPMCS::MuEsmear(double mu_E, double Eres)
 {
   double thesmearedE;
-  double sv = trr->Gaus(0.,Eres);
+  double sv = trr.Gaus(0.,Eres);
   thesmearedE=mu_E + sv;
 
   return thesmearedE;
@@ -186,7 +193,7 @@ double NeutronStudyPMCS::MuAnglesmear(double mu_px, double mu_py, double mu_pz,
 
   //cout<<mu_angle<<endl;
   double thesmearedAngle;
-  double sv = trr->Gaus(0.,angsmear);
+  double sv = trr.Gaus(0.,angsmear);
 
   thesmearedAngle=mu_angle + sv;
 
@@ -217,7 +224,7 @@ int NeutronStudyPMCS::DetectedNeutrons(int totneut)
   int detneut=0;
   double neutdeteffic = 0.7;
   for(int i=0; i<totneut; i++){
-    double rolln = ttr->Rndm();
+    double rolln = ttr.Rndm();
     if(rolln<neutdeteffic) detneut++;
   }
 
@@ -229,7 +236,7 @@ int NeutronStudyPMCS::DetectedNeutrons(int totneut)
 int NeutronStudyPMCS::BkgNeutrons(double prob)
 {
   int bgneut=0;
-  double rollbn=ttr->Rndm();
+  double rollbn=ttr.Rndm();
   double neutbgrate=prob;
   if(rollbn<neutbgrate) bgneut=1;
 
@@ -3,7 +3,7 @@
 
 #include <string>
 #include <iostream>
-#include "TRandom3.h"
+#include "RandomStreams.h"
 #include "TVector3.h"
 
 #include "Tool.h"
@@ -28,8 +28,11 @@ class NeutronStudyPMCS: public Tool {
 
  private:
 
-  TRandom3* ttr;
-  TRandom3* trr;
+  // random streams for the current event (see DataModel/RandomStreams.h)
+  CounterRNG ttr;
+  CounterRNG trr;
+  // events processed, used as the event number if the input has none
+  uint64_t nevents;
   // how much to smear the muon energy
   double muEsmear;
   // how much to smear muon angle
@@ -1,4 +1,6 @@
 #include "NeutronStudyReadSandbox.h"
+#include "Sharding.h"
+#include "Tracer.h"
 
 NeutronStudyReadSandbox::NeutronStudyReadSandbox():Tool(){}
 
@@ -12,6 +14,9 @@ bool NeutronStudyReadSandbox::Initialise(std::string configfile, DataModel &data
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("NeutronStudyReadSandbox") ) return false;
+
   m_data->Stores["NeutrinoEvent"]= new BoostStore(false,2);
 
 
@@ -32,7 +37,10 @@ bool NeutronStudyReadSandbox::Initialise(std::string configfile, DataModel &data
 
   iterationNum=0;
 
-  tf = new TFile("/ANNIEcode/neutronsout.root","READ");
+  std::string inputfile="/ANNIEcode/neutronsout.root";
+  m_variables.Get("InputFile",inputfile);
+
+  tf = new TFile(inputfile.c_str(),"READ");
   neutT = (TTree*) tf->Get("ANNIEToyEventTree");
 
   neutT->SetBranchAddress("nu_E",&nuE);
@@ -57,7 +65,10 @@ bool NeutronStudyReadSandbox::Initialise(std::string configfile, DataModel &data
 
 bool NeutronStudyReadSandbox::Execute(){
 
-  neutT->GetEntry(iterationNum);
+  {
+    TraceSpan span("io", "TTree::GetEntry");
+    neutT->GetEntry(iterationNum);
+  }
 
   if(iterationNum%1000==0) std::cout<<"Now on iteration number: "<<iterationNum<<"  out of "<<nentries<<std::endl;
 
@@ -74,6 +85,8 @@ bool NeutronStudyReadSandbox::Execute(){
   m_data->Stores["NeutrinoEvent"]->Set("truePionAngle",piAngle);
   m_data->Stores["NeutrinoEvent"]->Set("trueQ2",q2);
   m_data->Stores["NeutrinoEvent"]->Set("recoNeutrinoEnergy",recoE);
+  // the tree entry identifies the event (e.g. for random number streams)
+  m_data->Stores["NeutrinoEvent"]->Set("EventNumber",static_cast<uint64_t>(iterationNum));
 
   iterationNum++;
 
@@ -1,4 +1,5 @@
 #include "NeutronStudyWriteTree.h"
+#include "Sharding.h"
 
 NeutronStudyWriteTree::NeutronStudyWriteTree():Tool(){}
 
@@ -12,7 +13,10 @@ bool NeutronStudyWriteTree::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
-  tf = new TFile ("savem.root","RECREATE");
+  std::string outputfile="savem.root";
+  m_variables.Get("OutputFile",outputfile);
+
+  tf = new TFile (Sharding::OutputPath(outputfile,Sharding::OutputType::ROOTFile).c_str(),"RECREATE");
   outtree = new TTree("ANNIEOutTree","ANNIEOutTree");
 
   outtree->Branch("nu_E",&nuE);
@@ -41,6 +45,11 @@ bool NeutronStudyWriteTree::Initialise(std::string configfile, DataModel &data){
   outtree->Branch("PassedSelection",&passedselection);
   outtree->Branch("MuonEffic",&muonefficiency);
 
+  // Write baskets incrementally rather than holding the whole tree in memory
+  outputsettings.Load(m_variables);
+  configure_output_tree(outtree,outputsettings);
+  if(outputsettings.async_fill) asyncfiller.reset(new AsyncTreeFiller(outtree,outputsettings.max_queued_entries));
+
   return true;
 }
 
@@ -75,7 +84,8 @@ bool NeutronStudyWriteTree::Execute(){
 
 
 
-  outtree->Fill();
+  if(asyncfiller) asyncfiller->Fill();
+  else outtree->Fill();
 
   return true;
 }
@@ -83,6 +93,8 @@ bool NeutronStudyWriteTree::Execute(){
 
 bool NeutronStudyWriteTree::Finalise(){
 
+  if(asyncfiller) asyncfiller->Stop();
+  tf->cd();
   outtree->Write();
   tf->Close();
 
@@ -3,8 +3,10 @@
 
 #include <string>
 #include <iostream>
+#include <memory>
 
 #include "Tool.h"
+#include "ROOTTreeOutput.h"
 
 class NeutronStudyWriteTree: public Tool {
 
@@ -21,6 +23,8 @@ class NeutronStudyWriteTree: public Tool {
 
  TFile* tf;
  TTree* outtree;
+ TreeOutputSettings outputsettings;
+ std::unique_ptr<AsyncTreeFiller> asyncfiller;
 
  int primneut,totneut,ispi;
  double nuE,muE,muAngle,mupx,mupy,mupz,piE,piAngle,q2,recoE;
@@ -0,0 +1,498 @@
+// standard library includes
+#include <exception>
+#include <set>
+#include <sstream>
+
+// ToolAnalysis includes
+#include "ANNIEEventKeys.h"
+#include "ANNIEconstants.h"
+#include "MonitoredTool.h"
+#include "ParallelSafe.h"
+#include "ParallelSubChain.h"
+#include "ROOTTreeOutput.h"
+#include "StoreCopy.h"
+#include "Tracer.h"
+
+namespace {
+
+  // Copy the header keys from one store to another
+  void copy_store_header(BoostStore& from, BoostStore& to) {
+    if ( !from.Header || !to.Header ) return;
+    copy_store(*from.Header, *to.Header);
+  }
+
+  // Look up a store by name, returning nullptr if it does not exist
+  BoostStore* find_store(DataModel& data, const std::string& name) {
+    auto iter = data.Stores.find(name);
+    if ( iter == data.Stores.end() ) return nullptr;
+    return iter->second;
+  }
+
+  // Finds the catalogued keys (see ANNIEEventKeys.h) of a store that were
+  // set by pointer. They are missing from the store's archive, but can still
+  // be retrieved from the store as pointers.
+  struct PointerKeyFinder {
+    BoostStore& store;
+    std::set<std::string> archived_keys;
+    std::vector<std::string> pointer_keys;
+
+    template <typename T> bool visit(const std::string& key) {
+      if ( archived_keys.count(key) ) return true;
+      T* object = nullptr;
+      if ( !store.Get(key, object) ) return false;
+      pointer_keys.push_back(key);
+      return true;
+    }
+  };
+}
+
+SubChainClone::SubChainClone(size_t index, DataModel& main_data,
+  const std::vector<std::string>& store_names) : index_(index),
+  store_names_(store_names), busy_(false), sequence_number_(0u),
+  has_work_(false), done_(false), stop_(false), succeeded_(true)
+{
+  data_.Log = main_data.Log;
+  data_.context = main_data.context;
+
+  for (const auto& name : store_names_) {
+    data_.Stores[name] = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+  }
+}
+
+SubChainClone::~SubChainClone() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if ( thread_.joinable() ) thread_.join();
+
+  // The tools (and any StoreHandles that they hold) go first. The entries
+  // of the Stores map are left in place, as handles point into it.
+  tools_.clear();
+  for (const auto& name : store_names_) {
+    delete data_.Stores[name];
+    data_.Stores[name] = nullptr;
+  }
+}
+
+bool SubChainClone::Initialise(const std::vector<SubChainToolEntry>& entries,
+  bool allow_unsafe_tools, std::string& error)
+{
+  for (const auto& entry : entries) {
+    Tool* tool = Factory(entry.tool_class);
+    if ( !tool ) {
+      error = "unknown tool class \"" + entry.tool_class + '\"';
+      return false;
+    }
+    tools_.emplace_back(tool);
+    tool_names_.push_back(entry.name);
+
+    if ( !allow_unsafe_tools && !dynamic_cast<ParallelSafe*>(unwrap_tool(tool)) ) {
+      error = "the tool \"" + entry.name + "\" (" + entry.tool_class
+        + ") is not marked as parallel-safe";
+      return false;
+    }
+
+    if ( !tool->Initialise(entry.config_file, data_) ) {
+      error = "the tool \"" + entry.name + "\" failed to initialise";
+      return false;
+    }
+  }
+
+  thread_ = std::thread(&SubChainClone::Run, this);
+  return true;
+}
+
+void SubChainClone::Start(uint64_t sequence_number) {
+  busy_ = true;
+  sequence_number_ = sequence_number;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    has_work_ = true;
+    done_ = false;
+  }
+  cond_.notify_all();
+}
+
+bool SubChainClone::Wait() {
+  TraceSpan span("wait", "Wait for sub-chain clone");
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]{ return done_; });
+  busy_ = false;
+  return succeeded_;
+}
+
+bool SubChainClone::Finalise() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if ( thread_.joinable() ) thread_.join();
+
+  bool ok = true;
+  for (size_t t = 0; t < tools_.size(); ++t) {
+    if ( !tools_.at(t)->Finalise() ) {
+      error_ = "the tool \"" + tool_names_.at(t) + "\" failed to finalise";
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+void SubChainClone::Run() {
+
+  Tracer::SetThreadName("ParallelSubChain clone " + std::to_string(index_));
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]{ return has_work_ || stop_; });
+      if ( !has_work_ ) return; // stopping
+    }
+
+    // The event is read from its archives here rather than on the main
+    // thread, which only has to archive it
+    bool succeeded = true;
+    std::string error;
+    for (const auto& name : store_names_) {
+      BoostStore* store = data_.Stores[name];
+      auto archive = archives_.find(name);
+      if ( archive == archives_.end() ) store->Delete();
+      else if ( !restore_store(archive->second, *store) ) {
+        error = "the store \"" + name + "\" could not be read";
+        succeeded = false;
+      }
+    }
+
+    for (size_t t = 0; t < tools_.size() && succeeded; ++t) {
+      try {
+        if ( !tools_.at(t)->Execute() ) {
+          error = "the tool \"" + tool_names_.at(t) + "\" failed to execute";
+          succeeded = false;
+        }
+      }
+      catch (const std::exception& e) {
+        error = "the tool \"" + tool_names_.at(t) + "\" threw an exception: "
+          + e.what();
+        succeeded = false;
+      }
+    }
+
+    // Archive the results for the main thread. The strings keep their
+    // capacity from one event to the next.
+    for (size_t n = 0; n < store_names_.size() && succeeded; ++n) {
+      const std::string& name = store_names_.at(n);
+      if ( !archive_store(*data_.Stores[name], archives_[name]) ) {
+        error = "the store \"" + name + "\" could not be archived";
+        succeeded = false;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      has_work_ = false;
+      done_ = true;
+      succeeded_ = succeeded;
+      error_ = error;
+    }
+    cond_.notify_all();
+  }
+}
+
+
+ParallelSubChain::ParallelSubChain():Tool() {}
+
+bool ParallelSubChain::Initialise(std::string config_filename,
+  DataModel &data)
+{
+  // Load settings from the configuration file
+  if ( !config_filename.empty() ) m_variables.Initialise(config_filename);
+
+  // Assign transient data pointer
+  m_data= &data;
+
+  verbosity_ = 0;
+  m_variables.Get("verbose", verbosity_);
+
+  int num_clones = 2;
+  m_variables.Get("NumClones", num_clones);
+  if ( num_clones < 1 ) {
+    Log("Error: NumClones must be positive", 0, verbosity_);
+    return false;
+  }
+
+  int allow_unsafe_tools = 0;
+  m_variables.Get("AllowUnsafeTools", allow_unsafe_tools);
+
+  std::string stores = "ANNIEEvent";
+  m_variables.Get("Stores", stores);
+  std::istringstream store_list(stores);
+  std::string store_name;
+  while ( std::getline(store_list, store_name, ',') ) {
+    if ( !store_name.empty() ) store_names_.push_back(store_name);
+  }
+
+  std::string parallel_tools_file;
+  if ( !m_variables.Get("ParallelToolsConfig", parallel_tools_file) ) {
+    Log("Error: Missing ParallelToolsConfig in the configuration for the"
+      " ParallelSubChain tool", 0, verbosity_);
+    return false;
+  }
+
+  std::string error;
+  std::vector<SubChainToolEntry> parallel_tools;
+  if ( !load_sub_chain_tools(parallel_tools_file, parallel_tools, error) ) {
+    Log("Error: ParallelSubChain " + error, 0, verbosity_);
+    return false;
+  }
+
+  // The main DataModel holds an earlier event once ParallelSubChain has run,
+  // so no tool may follow it
+  if ( !main_tools_file().empty() ) {
+    std::vector<SubChainToolEntry> main_tools;
+    if ( !load_sub_chain_tools(main_tools_file(), main_tools, error) ) {
+      Log("Error: ParallelSubChain " + error, 0, verbosity_);
+      return false;
+    }
+    if ( main_tools.empty()
+      || main_tools.back().tool_class != "ParallelSubChain"
+      || main_tools.back().config_file != config_filename )
+    {
+      Log("Error: ParallelSubChain must be the last tool in "
+        + main_tools_file() + ". Put the tools that need its results in"
+        " SerialToolsConfig instead.", 0, verbosity_);
+      return false;
+    }
+  }
+
+  std::vector<SubChainToolEntry> serial_tools;
+  std::string serial_tools_file;
+  if ( m_variables.Get("SerialToolsConfig", serial_tools_file)
+    && !load_sub_chain_tools(serial_tools_file, serial_tools, error) )
+  {
+    Log("Error: ParallelSubChain " + error, 0, verbosity_);
+    return false;
+  }
+
+  // Tools in different clones may create ROOT objects at the same time
+  if ( num_clones > 1 ) enable_root_thread_safety();
+
+  for (int c = 0; c < num_clones; ++c) {
+    clones_.emplace_back( new SubChainClone(c, *m_data, store_names_) );
+    SubChainClone& clone = *clones_.back();
+
+    // Give the clone the current headers (e.g., isSim) and geometry so
+    // that its tools can read them in Initialise()
+    for (const auto& name : store_names_) {
+      BoostStore* main_store = find_store(*m_data, name);
+      if (main_store) copy_store_header(*main_store, *clone.data().Stores[name]);
+    }
+    if ( m_data->GetGeometry() ) {
+      clone.data().UpdateGeometry( *m_data->GetGeometry() );
+    }
+    clone_geometry_hashes_.push_back( clone.data().GetGeometryHash() );
+
+    if ( !clone.Initialise(parallel_tools, allow_unsafe_tools, error) ) {
+      Log("Error: Could not set up ParallelSubChain clone "
+        + std::to_string(c) + ": " + error, 0, verbosity_);
+      return false;
+    }
+  }
+
+  // Pass on any header flags set by the parallel tools in Initialise()
+  for (const auto& name : store_names_) {
+    BoostStore* main_store = find_store(*m_data, name);
+    if (main_store) copy_store_header(*clones_.front()->data().Stores[name],
+      *main_store);
+  }
+
+  for (const auto& entry : serial_tools) {
+    Tool* tool = Factory(entry.tool_class);
+    if ( !tool ) {
+      Log("Error: ParallelSubChain could not create the serial tool \""
+        + entry.name + "\" of unknown class \"" + entry.tool_class + '\"', 0,
+        verbosity_);
+      return false;
+    }
+    serial_tools_.emplace_back(tool);
+    serial_tool_names_.push_back(entry.name);
+    if ( !tool->Initialise(entry.config_file, *m_data) ) {
+      Log("Error: The serial tool \"" + entry.name + "\" failed to"
+        " initialise", 0, verbosity_);
+      return false;
+    }
+  }
+
+  num_dispatched_ = 0u;
+
+  Log("Running " + std::to_string( parallel_tools.size() ) + " tools on "
+    + std::to_string(num_clones) + " events at once, followed by "
+    + std::to_string( serial_tools.size() ) + " serial tools", 1,
+    verbosity_);
+
+  return true;
+}
+
+
+bool ParallelSubChain::Execute() {
+
+  // There is always an idle clone here, since the previous call left at
+  // most NumClones - 1 events in flight
+  if ( !Dispatch() ) return false;
+
+  // Once every clone is busy, wait for the oldest event and pass it on.
+  // Clones that finish early keep their events until all earlier events
+  // have been emitted.
+  bool ok = true;
+  while ( in_flight_.size() >= clones_.size() ) ok = EmitOldest() && ok;
+
+  // The ToolChain stops after this event, so finish everything now
+  int stop_the_loop = 0;
+  m_data->vars.Get("StopLoop", stop_the_loop);
+  if ( stop_the_loop == 1 ) {
+    while ( !in_flight_.empty() ) ok = EmitOldest() && ok;
+  }
+
+  return ok;
+}
+
+
+bool ParallelSubChain::Dispatch() {
+
+  SubChainClone* clone = nullptr;
+  for (auto& c : clones_) {
+    if ( !c->busy() ) {
+      clone = c.get();
+      break;
+    }
+  }
+
+  // Archiving copies the stored values as they are, without decoding them,
+  // so every key of the event reaches the clone
+  std::map<std::string, std::string>& archives = clone->archives();
+  for (const auto& name : store_names_) {
+    BoostStore* main_store = find_store(*m_data, name);
+    if ( !main_store ) archives.erase(name);
+    else if ( !archive_store(*main_store, archives[name]) ) {
+      Log("Error: ParallelSubChain could not archive the store \"" + name
+        + "\" of event " + std::to_string(num_dispatched_), 0, verbosity_);
+      return false;
+    }
+  }
+
+  // Keys set by pointer are not archived, so they would silently be missing
+  // from the clones. The tools that set them do so on every event, so the
+  // first event is enough to find them.
+  if ( num_dispatched_ == 0u && !check_pointer_keys(archives) ) return false;
+
+  uint64_t& geometry_hash = clone_geometry_hashes_.at( clone->index() );
+  if ( m_data->GetGeometry() && geometry_hash != m_data->GetGeometryHash() ) {
+    clone->data().UpdateGeometry( *m_data->GetGeometry() );
+    geometry_hash = clone->data().GetGeometryHash();
+  }
+
+  Log("Starting event " + std::to_string(num_dispatched_) + " on"
+    " ParallelSubChain clone " + std::to_string( clone->index() ), 2,
+    verbosity_);
+
+  clone->Start(num_dispatched_);
+  in_flight_.push_back(clone);
+  ++num_dispatched_;
+  return true;
+}
+
+
+bool ParallelSubChain::check_pointer_keys(
+  const std::map<std::string, std::string>& archives)
+{
+  bool ok = true;
+  for (const auto& pair : archives) {
+    BoostStore* main_store = find_store(*m_data, pair.first);
+    if ( !main_store ) continue;
+
+    PointerKeyFinder finder{ *main_store, {}, {} };
+    for (const auto& key : archive_keys(pair.second)) {
+      finder.archived_keys.insert(key);
+    }
+    visit_annie_event_keys(finder);
+
+    for (const auto& key : finder.pointer_keys) {
+      Log("Error: The key \"" + key + "\" of the store \"" + pair.first
+        + "\" was set by pointer, so ParallelSubChain cannot copy it to the"
+        " clones. Set it by value instead.", 0, verbosity_);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+
+bool ParallelSubChain::EmitOldest() {
+
+  SubChainClone* clone = in_flight_.front();
+  in_flight_.pop_front();
+
+  if ( !clone->Wait() ) {
+    Log("Error: Event " + std::to_string( clone->sequence_number() )
+      + " failed in ParallelSubChain clone "
+      + std::to_string( clone->index() ) + ": " + clone->error(), 0,
+      verbosity_);
+    return false;
+  }
+
+  for (const auto& name : store_names_) {
+    BoostStore* main_store = find_store(*m_data, name);
+    if ( main_store && !restore_store(clone->archives().at(name),
+      *main_store) )
+    {
+      Log("Error: ParallelSubChain could not read the store \"" + name
+        + "\" of event " + std::to_string( clone->sequence_number() ), 0,
+        verbosity_);
+      return false;
+    }
+  }
+
+  bool ok = true;
+  for (size_t t = 0; t < serial_tools_.size(); ++t) {
+    if ( !serial_tools_.at(t)->Execute() ) {
+      Log("Error: The serial tool \"" + serial_tool_names_.at(t) + "\" failed"
+        " on event " + std::to_string( clone->sequence_number() ), 0,
+        verbosity_);
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+
+bool ParallelSubChain::Finalise() {
+
+  bool ok = true;
+
+  // Events may still be in flight if the ToolChain was stopped by an event
+  // count rather than StopLoop
+  while ( !in_flight_.empty() ) ok = EmitOldest() && ok;
+
+  for (auto& clone : clones_) {
+    if ( !clone->Finalise() ) {
+      Log("Error: ParallelSubChain clone " + std::to_string( clone->index() )
+        + ": " + clone->error(), 0, verbosity_);
+      ok = false;
+    }
+  }
+  clones_.clear();
+
+  for (size_t t = 0; t < serial_tools_.size(); ++t) {
+    if ( !serial_tools_.at(t)->Finalise() ) {
+      Log("Error: The serial tool \"" + serial_tool_names_.at(t) + "\" failed"
+        " to finalise", 0, verbosity_);
+      ok = false;
+    }
+  }
+  serial_tools_.clear();
+
+  return ok;
+}
@@ -0,0 +1,150 @@
+// Runs a list of tools on several events at once
+//
+// ParallelSubChain owns NumClones copies of the tools listed in its
+// ParallelToolsConfig file. Each copy (a SubChainClone) has its own DataModel
+// and its own thread. Every event that reaches ParallelSubChain is archived
+// (see DataModel/StoreCopy.h) and handed to an idle clone, which reads it
+// into its own stores and processes it in the background while the
+// ToolChain loads the next one. The clone archives the results on its own
+// thread, and they are read back into the main DataModel strictly in the
+// order in which the events arrived. The tools listed in SerialToolsConfig
+// are then run on them one at a time.
+#pragma once
+
+// standard library includes
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ToolAnalysis includes
+#include "Factory.h"
+#include "SubChainTools.h"
+#include "Tool.h"
+
+/// @brief One copy of the parallel tools, with its own DataModel and worker
+/// thread
+class SubChainClone {
+
+  public:
+
+    /// @param main_data DataModel of the ToolChain, whose logger and ZMQ
+    /// context are shared with the clone
+    /// @param store_names Names of the event stores to create in the clone
+    SubChainClone(size_t index, DataModel& main_data,
+      const std::vector<std::string>& store_names);
+
+    /// @brief Stops the worker thread and deletes the tools and stores
+    ~SubChainClone();
+
+    SubChainClone(const SubChainClone&) = delete;
+    SubChainClone& operator=(const SubChainClone&) = delete;
+
+    /// @brief Create and initialise the tools
+    bool Initialise(const std::vector<SubChainToolEntry>& entries,
+      bool allow_unsafe_tools, std::string& error);
+
+    /// @brief Start executing the tools on the event held in archives()
+    void Start(uint64_t sequence_number);
+
+    /// @brief Wait until the current event has been processed
+    /// @return true if every tool executed successfully
+    bool Wait();
+
+    /// @brief Stop the worker thread and finalise the tools
+    bool Finalise();
+
+    /// @brief Archive of each event store, by store name. Holds the event
+    /// given to Start() and, once Wait() has returned true, the stores after
+    /// the tools have run. Stores without an archive are emptied. Only to be
+    /// used while the clone is not busy.
+    inline std::map<std::string, std::string>& archives() { return archives_; }
+
+    inline DataModel& data() { return data_; }
+    inline size_t index() const { return index_; }
+    inline bool busy() const { return busy_; }
+    inline uint64_t sequence_number() const { return sequence_number_; }
+    inline const std::string& error() const { return error_; }
+
+  protected:
+
+    /// @brief Function run by the worker thread
+    void Run();
+
+    size_t index_;
+    DataModel data_;
+    std::vector<std::string> store_names_;
+    std::map<std::string, std::string> archives_;
+
+    std::vector< std::unique_ptr<Tool> > tools_;
+    std::vector<std::string> tool_names_;
+
+    /// @brief True from Start() until the event has been collected by Wait()
+    bool busy_;
+    uint64_t sequence_number_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool has_work_;
+    bool done_;
+    bool stop_;
+    bool succeeded_;
+    std::string error_;
+
+    std::thread thread_;
+};
+
+class ParallelSubChain: public Tool {
+
+  public:
+
+    ParallelSubChain();
+    bool Initialise(std::string configfile, DataModel& data);
+    bool Execute();
+    bool Finalise();
+
+  protected:
+
+    /// @brief Archive the current event into an idle clone and start it
+    /// @return false if a store could not be archived
+    bool Dispatch();
+
+    /// @brief Check that no catalogued key of the event stores was set by
+    /// pointer, since such keys are not archived
+    /// @param archives Archive of each store of the event, by store name
+    /// @return false (with an error logged for each key) if any was
+    bool check_pointer_keys(
+      const std::map<std::string, std::string>& archives);
+
+    /// @brief Wait for the oldest event in flight, read it back into the main
+    /// DataModel, and run the serial tools on it
+    bool EmitOldest();
+
+    /// @brief Integer code that determines the level of logging to show in
+    /// the output
+    int verbosity_;
+
+    /// @brief Names of the stores copied to and from the clones
+    std::vector<std::string> store_names_;
+
+    std::vector< std::unique_ptr<SubChainClone> > clones_;
+
+    /// @brief Clones holding events that have not been emitted yet, oldest
+    /// first
+    std::deque<SubChainClone*> in_flight_;
+
+    /// @brief Tools run in order on each event after it leaves the clones
+    std::vector< std::unique_ptr<Tool> > serial_tools_;
+    std::vector<std::string> serial_tool_names_;
+
+    /// @brief Geometry hash last given to each clone
+    std::vector<uint64_t> clone_geometry_hashes_;
+
+    /// @brief Number of events given to the clones so far
+    uint64_t num_dispatched_;
+};
@@ -9,7 +9,9 @@
 #include "ChannelKey.h"
 #include "HeftyInfo.h"
 #include "MinibufferLabel.h"
+#include "PackedADCPulse.h"
 #include "PhaseITreeMaker.h"
+#include "Sharding.h"
 #include "TimeClass.h"
 
 constexpr int UNKNOWN_NCV_POSITION = 0;
@@ -73,6 +75,12 @@ bool PhaseITreeMaker::Initialise(std::string config_filename, DataModel& data)
   std::string output_filename;
   get_object_from_store("OutputFile", output_filename, m_variables);
 
+  // The ncv_pos_info tree written in Finalise holds totals for each NCV
+  // position, which must be added up when the shard outputs are merged
+  Sharding::AddSummaryTree(output_filename, "ncv_pos_info", "ncv_position");
+  output_filename = Sharding::OutputPath(output_filename,
+    Sharding::OutputType::ROOTFile);
+
   output_tfile_ = std::unique_ptr<TFile>(
     new TFile(output_filename.c_str(), "recreate"));
 
@@ -99,6 +107,17 @@ bool PhaseITreeMaker::Initialise(std::string config_filename, DataModel& data)
   output_tree_->Branch("raw_amplitude_ncv2", &raw_amplitude_ncv2_,
     "raw_amplitude_ncv2/s");
 
+  // Write baskets incrementally and autosave the tree so that the output
+  // file stays readable if the job is interrupted
+  tree_output_settings_.Load(m_variables);
+  configure_output_tree(output_tree_, tree_output_settings_);
+
+  if ( tree_output_settings_.async_fill ) {
+    async_filler_ = std::unique_ptr<AsyncTreeFiller>(
+      new AsyncTreeFiller(output_tree_,
+      tree_output_settings_.max_queued_entries) );
+  }
+
   return true;
 }
 
@@ -193,7 +212,13 @@ bool PhaseITreeMaker::Execute() {
   // Load the reconstructed ADC hits
   std::map<ChannelKey, std::vector< std::vector<ADCPulse> > > adc_hits;
 
-  get_object_from_store("RecoADCHits", adc_hits, *annie_event);
+  // The ADCHitFinder tool may have saved these in either the packed or the
+  // original format. Both are converted to the original map here.
+  Log("Retrieving \"RecoADCHits\" from a Store", 4, verbosity_);
+  if ( !get_reco_adc_hits(*annie_event, adc_hits) ) {
+    Log("Error: The PhaseITreeMaker tool could not find the RecoADCHits"
+      " entry", 0, verbosity_);
+  }
   check_that_not_empty("RecoADCHits", adc_hits);
 
   // This variable stores the absolute time (non-Hefty mode: time within the
@@ -287,7 +312,8 @@ bool PhaseITreeMaker::Execute() {
           // simultaneously.
           event_time_ns_ += hefty_info.t_since_beam(mb);
         }
-        output_tree_->Fill();
+        if (async_filler_) async_filler_->Fill();
+        else output_tree_->Fill();
         Log("Found NCV event in run " + std::to_string(run_number_)
           + " subrun " + std::to_string(subrun_number_) + " event "
           + std::to_string(event_number_) + " in minibuffer "
@@ -307,6 +333,10 @@ bool PhaseITreeMaker::Execute() {
 
 
 bool PhaseITreeMaker::Finalise() {
+  // Finish filling the output tree before touching the output file
+  if (async_filler_) async_filler_->Stop();
+
+  output_tfile_->cd();
   output_tree_->Write();
 
   TTree* beam_tree = new TTree("ncv_pos_info",
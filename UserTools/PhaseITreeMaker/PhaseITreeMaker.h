@@ -15,6 +15,7 @@
 #include "TTree.h"
 
 // ToolAnalysis includes
+#include "ROOTTreeOutput.h"
 #include "Tool.h"
 
 struct NCVPositionInfo {
@@ -108,6 +109,14 @@ class PhaseITreeMaker : public Tool {
     /// @brief TTree that will be used to store output
     TTree* output_tree_ = nullptr;
 
+    /// @brief Basket flushing, autosave, and background filling settings
+    /// for output_tree_
+    TreeOutputSettings tree_output_settings_;
+
+    /// @brief Fills output_tree_ on a background thread if AsyncFill is
+    /// enabled
+    std::unique_ptr<AsyncTreeFiller> async_filler_ = nullptr;
+
     // Branch variables
     uint32_t run_number_ = 0u;
     uint32_t subrun_number_ = 0u;
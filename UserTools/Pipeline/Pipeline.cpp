@@ -0,0 +1,388 @@
+// standard library includes
+#include <algorithm>
+#include <exception>
+#include <sstream>
+
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "Factory.h"
+#include "Pipeline.h"
+#include "ROOTTreeOutput.h"
+#include "Tracer.h"
+
+namespace {
+
+  // Split a comma-separated list
+  std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while ( std::getline(in, item, ',') ) {
+      if ( !item.empty() ) items.push_back(item);
+    }
+    return items;
+  }
+}
+
+EventQueue::EventQueue(size_t max_size)
+  : max_size_(max_size > 0u ? max_size : 1u), closed_(false), aborted_(false)
+{}
+
+bool EventQueue::Push(std::unique_ptr<EventPayload> event) {
+  TraceSpan span("wait", "EventQueue::Push");
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]{ return events_.size() < max_size_ || aborted_; });
+  if (aborted_) return false;
+  events_.push_back( std::move(event) );
+  lock.unlock();
+  cond_.notify_all();
+  return true;
+}
+
+std::unique_ptr<EventPayload> EventQueue::Pop() {
+  TraceSpan span("wait", "EventQueue::Pop");
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]{ return !events_.empty() || closed_ || aborted_; });
+  if ( aborted_ || events_.empty() ) return nullptr;
+  std::unique_ptr<EventPayload> event = std::move( events_.front() );
+  events_.pop_front();
+  lock.unlock();
+  cond_.notify_all();
+  return event;
+}
+
+bool EventQueue::WaitForNext() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]{ return !events_.empty() || closed_ || aborted_; });
+  return !aborted_ && !events_.empty();
+}
+
+void EventQueue::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  cond_.notify_all();
+}
+
+void EventQueue::Abort() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    aborted_ = true;
+    events_.clear();
+  }
+  cond_.notify_all();
+}
+
+
+PipelineStage::PipelineStage(size_t index, DataModel& data,
+  const std::vector<std::string>& store_names) : index_(index), data_(data),
+  store_names_(store_names)
+{}
+
+bool PipelineStage::Initialise(const std::vector<SubChainToolEntry>& entries,
+  std::string& error)
+{
+  for (const auto& entry : entries) {
+    Tool* tool = Factory(entry.tool_class);
+    if ( !tool ) {
+      error = "unknown tool class \"" + entry.tool_class + '\"';
+      return false;
+    }
+    tools_.emplace_back(tool);
+    tool_names_.push_back(entry.name);
+
+    if ( !tool->Initialise(entry.config_file, data_) ) {
+      error = "the tool \"" + entry.name + "\" failed to initialise";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PipelineStage::Execute() {
+  bool ok = true;
+  for (size_t t = 0; t < tools_.size(); ++t) {
+    try {
+      if ( !tools_.at(t)->Execute() ) {
+        data_.Log->Log("Error: The tool \"" + tool_names_.at(t) + "\" failed"
+          " to execute in pipeline stage " + std::to_string(index_), 0, 0);
+        ok = false;
+      }
+    }
+    catch (const std::exception& e) {
+      data_.Log->Log("Error: The tool \"" + tool_names_.at(t) + "\" threw an"
+        " exception in pipeline stage " + std::to_string(index_) + ": "
+        + e.what(), 0, 0);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool PipelineStage::Finalise() {
+  bool ok = true;
+  for (size_t t = 0; t < tools_.size(); ++t) {
+    if ( !tools_.at(t)->Finalise() ) {
+      data_.Log->Log("Error: The tool \"" + tool_names_.at(t) + "\" failed"
+        " to finalise in pipeline stage " + std::to_string(index_), 0, 0);
+      ok = false;
+    }
+  }
+  tools_.clear();
+  return ok;
+}
+
+std::unique_ptr<EventPayload> PipelineStage::Capture(
+  uint64_t sequence_number)
+{
+  std::unique_ptr<EventPayload> event(new EventPayload);
+  event->sequence_number = sequence_number;
+  event->geometry = data_.GetSharedGeometry();
+  event->geometry_hash = data_.GetGeometryHash();
+
+  for (const auto& name : store_names_) {
+    auto iter = data_.Stores.find(name);
+    if ( iter == data_.Stores.end() || !iter->second ) continue;
+    if ( !event->capture_store(name, *iter->second,
+      captured_headers_[name]) )
+    {
+      data_.Log->Log("Error: Could not archive the store \"" + name + "\" in"
+        " pipeline stage " + std::to_string(index_), 0, 0);
+      return nullptr;
+    }
+  }
+  return event;
+}
+
+bool PipelineStage::Apply(const EventPayload& event) {
+
+  for (const auto& name : store_names_) {
+    BoostStore*& store = data_.Stores[name];
+    if ( !store ) store = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+    if ( !event.apply_store(name, *store) ) {
+      data_.Log->Log("Error: Could not read the store \"" + name + "\" in"
+        " pipeline stage " + std::to_string(index_), 0, 0);
+      return false;
+    }
+  }
+
+  if ( event.geometry && event.geometry_hash != data_.GetGeometryHash() ) {
+    data_.UpdateGeometry(*event.geometry);
+  }
+  return true;
+}
+
+
+Pipeline::Pipeline():Tool(), stage_failed_(false) {}
+
+bool Pipeline::Initialise(std::string config_filename, DataModel &data) {
+
+  // Load settings from the configuration file
+  if ( !config_filename.empty() ) m_variables.Initialise(config_filename);
+
+  // Assign transient data pointer
+  m_data= &data;
+
+  verbosity_ = 0;
+  m_variables.Get("verbose", verbosity_);
+
+  std::string tools_file;
+  if ( !m_variables.Get("ToolsConfig", tools_file) ) {
+    Log("Error: Missing ToolsConfig in the configuration for the Pipeline"
+      " tool", 0, verbosity_);
+    return false;
+  }
+
+  std::string error;
+  std::vector<SubChainToolEntry> tools;
+  if ( !load_sub_chain_tools(tools_file, tools, error) ) {
+    Log("Error: Pipeline " + error, 0, verbosity_);
+    return false;
+  }
+
+  std::string split_before;
+  m_variables.Get("SplitBefore", split_before);
+  std::vector<std::string> split_names = split_list(split_before);
+
+  int queue_size = 16;
+  m_variables.Get("QueueSize", queue_size);
+  if ( queue_size < 1 ) queue_size = 1;
+
+  std::string stores = "ANNIEEvent";
+  m_variables.Get("Stores", stores);
+  store_names_ = split_list(stores);
+
+  // Divide the tools into stages
+  std::vector< std::vector<SubChainToolEntry> > stage_tools(1);
+  for (const auto& entry : tools) {
+    bool split = std::find(split_names.begin(), split_names.end(),
+      entry.name) != split_names.end();
+    if ( split && !stage_tools.back().empty() ) stage_tools.emplace_back();
+    stage_tools.back().push_back(entry);
+  }
+
+  // Stages may create ROOT objects at the same time
+  if ( stage_tools.size() > 1 ) enable_root_thread_safety();
+
+  for (size_t s = 0; s < stage_tools.size(); ++s) {
+
+    // The last stage uses the ToolChain's DataModel so that tools after the
+    // Pipeline see the same event
+    DataModel* stage_data = m_data;
+    if ( s + 1 < stage_tools.size() ) {
+      stage_data_.emplace_back( new DataModel );
+      stage_data = stage_data_.back().get();
+      stage_data->Log = m_data->Log;
+      stage_data->context = m_data->context;
+    }
+
+    // Later stages receive their events from the previous stage, so their
+    // stores are created here. The first stage's tools create their own.
+    if ( s > 0 ) {
+      for (const auto& name : store_names_) {
+        if ( !stage_data->Stores.count(name) || !stage_data->Stores[name] ) {
+          stage_data->Stores[name] = new BoostStore(false,
+            BOOST_STORE_MULTIEVENT_FORMAT);
+        }
+      }
+    }
+
+    stages_.emplace_back( new PipelineStage(s, *stage_data, store_names_) );
+    if ( !stages_.back()->Initialise(stage_tools.at(s), error) ) {
+      Log("Error: Could not set up pipeline stage " + std::to_string(s)
+        + ": " + error, 0, verbosity_);
+      return false;
+    }
+
+    Log("Pipeline stage " + std::to_string(s) + " runs "
+      + std::to_string( stage_tools.at(s).size() ) + " tools starting with \""
+      + stage_tools.at(s).front().name + '\"', 1, verbosity_);
+  }
+
+  for (size_t s = 0; s + 1 < stages_.size(); ++s) {
+    queues_.emplace_back( new EventQueue(queue_size) );
+  }
+  for (size_t s = 0; s + 1 < stages_.size(); ++s) {
+    threads_.emplace_back(&Pipeline::RunStage, this, s);
+  }
+
+  return true;
+}
+
+
+bool Pipeline::Execute() {
+
+  PipelineStage& last_stage = *stages_.back();
+  if ( queues_.empty() ) return last_stage.Execute();
+
+  std::unique_ptr<EventPayload> event = queues_.back()->Pop();
+  if ( !event ) {
+    // The input ended without producing an event, or an earlier stage failed
+    m_data->vars.Set("StopLoop", 1);
+    return !stage_failed_;
+  }
+
+  if ( !last_stage.Apply(*event) ) {
+    stage_failed_ = true;
+    for (auto& queue : queues_) queue->Abort();
+    m_data->vars.Set("StopLoop", 1);
+    return false;
+  }
+  bool ok = last_stage.Execute();
+
+  // Stop the ToolChain after this event if it was the last one, or if an
+  // earlier stage has failed since
+  if ( !queues_.back()->WaitForNext() ) {
+    m_data->vars.Set("StopLoop", 1);
+    if (stage_failed_) ok = false;
+  }
+
+  return ok;
+}
+
+
+void Pipeline::RunStage(size_t s) {
+
+  PipelineStage& stage = *stages_.at(s);
+  uint64_t sequence_number = 0u;
+  Tracer::SetThreadName("Pipeline stage " + std::to_string(s));
+
+  while (true) {
+
+    if ( s > 0 ) {
+      std::unique_ptr<EventPayload> event = queues_.at(s - 1)->Pop();
+      if ( !event ) break;
+      sequence_number = event->sequence_number;
+      if ( !stage.Apply(*event) ) {
+        Log("Error: Pipeline stage " + std::to_string(s) + " could not read"
+          " event " + std::to_string(sequence_number) + ". Stopping the"
+          " pipeline.", 0, verbosity_);
+        stage_failed_ = true;
+        for (auto& queue : queues_) queue->Abort();
+        break;
+      }
+    }
+
+    // An event that failed is not passed on. The whole pipeline stops, as
+    // the later stages could not tell which events are missing.
+    if ( !stage.Execute() ) {
+      Log("Error: Pipeline stage " + std::to_string(s) + " failed on event "
+        + std::to_string(sequence_number) + ". Stopping the pipeline.", 0,
+        verbosity_);
+      stage_failed_ = true;
+      for (auto& queue : queues_) queue->Abort();
+      break;
+    }
+
+    // The first stage contains the loader, which sets StopLoop in its own
+    // DataModel when it has provided the last event
+    bool last_event = false;
+    if ( s == 0 ) {
+      int stop_the_loop = 0;
+      stage.data().vars.Get("StopLoop", stop_the_loop);
+      last_event = ( stop_the_loop == 1 );
+    }
+
+    std::unique_ptr<EventPayload> event = stage.Capture(sequence_number);
+    if ( !event ) {
+      Log("Error: Pipeline stage " + std::to_string(s) + " could not pass on"
+        " event " + std::to_string(sequence_number) + ". Stopping the"
+        " pipeline.", 0, verbosity_);
+      stage_failed_ = true;
+      for (auto& queue : queues_) queue->Abort();
+      break;
+    }
+    if ( !queues_.at(s)->Push( std::move(event) ) ) break;
+    if ( s == 0 ) ++sequence_number;
+    if (last_event) break;
+  }
+
+  queues_.at(s)->Close();
+}
+
+
+bool Pipeline::Finalise() {
+
+  // If the ToolChain stopped early, tell the other stages to give up
+  for (auto& queue : queues_) queue->Abort();
+  for (auto& thread : threads_) thread.join();
+  threads_.clear();
+
+  bool ok = true;
+  for (auto& stage : stages_) ok = stage->Finalise() && ok;
+  stages_.clear();
+  queues_.clear();
+
+  // The stages (and any StoreHandles held by their tools) are gone, so the
+  // stores can be deleted along with their DataModels
+  for (auto& stage_data : stage_data_) {
+    for (auto& store : stage_data->Stores) {
+      delete store.second;
+      store.second = nullptr;
+    }
+  }
+  stage_data_.clear();
+
+  return ok;
+}
@@ -0,0 +1,152 @@
+// Runs a list of tools as a pipeline of stages on separate threads
+//
+// The tools listed in the Pipeline's ToolsConfig file are split into stages
+// before each of the tools named in SplitBefore. Every stage runs on its own
+// thread with its own DataModel, except the last one, which runs inside
+// Pipeline::Execute() using the ToolChain's DataModel. Stages are connected
+// by bounded queues of EventPayloads (see DataModel/EventPayload.h): after
+// a stage has processed an event, its event stores are archived into a
+// payload, which is moved to the next stage and restored into that stage's
+// stores. While the last stage processes one event, the
+// earlier stages are already working on the following ones.
+#pragma once
+
+// standard library includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ToolAnalysis includes
+#include "EventPayload.h"
+#include "SubChainTools.h"
+#include "Tool.h"
+
+/// @brief Bounded queue of events passed from one pipeline stage to the
+/// next
+class EventQueue {
+
+  public:
+
+    EventQueue(size_t max_size);
+
+    /// @brief Wait for space and add an event to the queue
+    /// @return false if the queue has been aborted
+    bool Push(std::unique_ptr<EventPayload> event);
+
+    /// @brief Wait for an event and remove it from the queue
+    /// @return nullptr once the queue has been closed (and emptied) or
+    /// aborted
+    std::unique_ptr<EventPayload> Pop();
+
+    /// @brief Wait until the queue has an event or has been closed
+    /// @return false if no more events will arrive
+    bool WaitForNext();
+
+    /// @brief Mark the end of the events. Events already in the queue can
+    /// still be removed.
+    void Close();
+
+    /// @brief Discard all events and wake up any waiting threads
+    void Abort();
+
+  protected:
+
+    size_t max_size_;
+    std::deque< std::unique_ptr<EventPayload> > events_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool closed_;
+    bool aborted_;
+};
+
+/// @brief The tools and DataModel used by one pipeline stage
+class PipelineStage {
+
+  public:
+
+    /// @param data DataModel used by the stage's tools
+    /// @param store_names Names of the event stores passed between stages
+    PipelineStage(size_t index, DataModel& data,
+      const std::vector<std::string>& store_names);
+
+    PipelineStage(const PipelineStage&) = delete;
+    PipelineStage& operator=(const PipelineStage&) = delete;
+
+    /// @brief Create and initialise the tools
+    bool Initialise(const std::vector<SubChainToolEntry>& entries,
+      std::string& error);
+
+    /// @brief Run every tool on the current event
+    /// @return false if any tool failed
+    bool Execute();
+
+    /// @brief Finalise the tools and delete them
+    bool Finalise();
+
+    /// @brief Archive the contents of the event stores
+    /// @return nullptr if a store could not be archived
+    std::unique_ptr<EventPayload> Capture(uint64_t sequence_number);
+
+    /// @brief Replace the contents of the event stores with an event from
+    /// the previous stage
+    /// @return false if a store could not be read
+    bool Apply(const EventPayload& event);
+
+    inline DataModel& data() { return data_; }
+    inline size_t index() const { return index_; }
+
+  protected:
+
+    size_t index_;
+    DataModel& data_;
+    std::vector<std::string> store_names_;
+
+    std::vector< std::unique_ptr<Tool> > tools_;
+    std::vector<std::string> tool_names_;
+
+    /// @brief Header archive of each store in the last captured event
+    std::map<std::string, std::string> captured_headers_;
+};
+
+class Pipeline: public Tool {
+
+  public:
+
+    Pipeline();
+    bool Initialise(std::string configfile, DataModel& data);
+    bool Execute();
+    bool Finalise();
+
+  protected:
+
+    /// @brief Function run by the thread of each stage except the last one
+    void RunStage(size_t s);
+
+    /// @brief Integer code that determines the level of logging to show in
+    /// the output
+    int verbosity_;
+
+    /// @brief Names of the stores passed between stages
+    std::vector<std::string> store_names_;
+
+    /// @brief DataModels owned by the stages that run on their own threads
+    std::vector< std::unique_ptr<DataModel> > stage_data_;
+
+    std::vector< std::unique_ptr<PipelineStage> > stages_;
+
+    /// @brief queues_[s] connects stage s to stage s + 1
+    std::vector< std::unique_ptr<EventQueue> > queues_;
+
+    std::vector<std::thread> threads_;
+
+    /// @brief Set when a stage that runs on its own thread has failed. The
+    /// queues are then aborted, so no further events reach the last stage.
+    std::atomic<bool> stage_failed_;
+};
@@ -1,6 +1,9 @@
 // standard library includes
 #include <stdexcept>
 
+// ToolAnalysis includes
+#include "Tracer.h"
+
 annie::HeftyTreeReader::HeftyTreeReader(const std::string& file_name)
   : HeftyTreeReader(std::vector<std::string>( { file_name } ))
 {
@@ -60,7 +63,10 @@ std::unique_ptr<HeftyInfo> annie::HeftyTreeReader::load_next_entry(
     // TODO: consider throwing an exception here instead
   }
 
-  hefty_db_chain_.GetEntry(current_hefty_db_entry_);
+  {
+    TraceSpan span("io", "TChain::GetEntry (Hefty DB)");
+    hefty_db_chain_.GetEntry(current_hefty_db_entry_);
+  }
 
   // TODO: Switch to using std::make_unique<HeftyInfo>();
   // when our Docker image has C++14 support
@@ -31,6 +31,16 @@ namespace annie {
       std::unique_ptr<HeftyInfo> next();
       std::unique_ptr<HeftyInfo> previous();
 
+      // Get and restore the position of the reader in the input file(s).
+      // These are used to resume from a checkpoint.
+      inline long long get_entry() const { return current_hefty_db_entry_; }
+      inline long long get_last_sequence_id() const
+        { return last_sequence_id_; }
+      inline void set_position(long long entry, long long last_sequence_id) {
+        current_hefty_db_entry_ = entry;
+        last_sequence_id_ = last_sequence_id;
+      }
+
     protected:
 
       void set_branch_addresses();
@@ -3,6 +3,7 @@
 #include "ChannelKey.h"
 #include "MinibufferLabel.h"
 #include "RawLoader.h"
+#include "Sharding.h"
 #include "Waveform.h"
 
 // recoANNIE includes
@@ -140,6 +141,9 @@ bool RawLoader::Initialise(const std::string config_file, DataModel& data)
   // Assign transient data pointer
   m_data = &data;
 
+  // Every shard would read the whole input
+  if ( Sharding::Unsupported("RawLoader") ) return false;
+
   // TODO: allow for multiple input files in the same run
   std::string input_file_name;
   m_variables.Get("InputFile", input_file_name);
@@ -183,6 +187,13 @@ bool RawLoader::Initialise(const std::string config_file, DataModel& data)
   m_data->Stores["ANNIEEvent"] = new BoostStore(false,
     BOOST_STORE_MULTIEVENT_FORMAT);
 
+  // Pick up where a previous job left off if there is a checkpoint
+  if ( !m_data->Checkpoints.Register("RawLoader", this) ) {
+    Log("ERROR: Failed to restore the RawLoader state from the checkpoint", 0,
+      verbosity);
+    return false;
+  }
+
   return true;
 }
 
@@ -417,5 +428,39 @@ bool RawLoader::Execute() {
 
 
 bool RawLoader::Finalise() {
+  m_data->Checkpoints.Unregister("RawLoader");
+  return true;
+}
+
+bool RawLoader::SaveCheckpoint(CheckpointState& state) {
+  state.Set("PMTDataEntry", m_reader->get_pmt_data_entry());
+  state.Set("TrigDataEntry", m_reader->get_trig_data_entry());
+  state.Set("LastSequenceID", m_reader->get_last_sequence_id());
+  if (m_using_hefty_mode) {
+    state.Set("HeftyEntry", m_hefty_tree_reader->get_entry());
+    state.Set("HeftyLastSequenceID",
+      m_hefty_tree_reader->get_last_sequence_id());
+  }
+  return true;
+}
+
+bool RawLoader::RestoreCheckpoint(const CheckpointState& state) {
+
+  long long pmt_data_entry, trig_data_entry, last_sequence_id;
+  if ( !state.Get("PMTDataEntry", pmt_data_entry)
+    || !state.Get("TrigDataEntry", trig_data_entry)
+    || !state.Get("LastSequenceID", last_sequence_id) ) return false;
+  m_reader->set_position(pmt_data_entry, trig_data_entry, last_sequence_id);
+
+  if (m_using_hefty_mode) {
+    long long hefty_entry, hefty_last_sequence_id;
+    if ( !state.Get("HeftyEntry", hefty_entry)
+      || !state.Get("HeftyLastSequenceID", hefty_last_sequence_id) )
+    {
+      return false;
+    }
+    m_hefty_tree_reader->set_position(hefty_entry, hefty_last_sequence_id);
+  }
+
   return true;
 }
@@ -13,6 +13,7 @@
 #include <string>
 
 // ToolAnalysis includes
+#include "CheckpointManager.h"
 #include "Tool.h"
 #include "HeftyInfo.h"
 #include "HeftyTreeReader.h"
@@ -20,7 +21,7 @@
 // recoANNIE includes
 #include "RawReader.h"
 
-class RawLoader : public Tool {
+class RawLoader : public Tool, public Checkpointable {
 
  public:
 
@@ -29,6 +30,9 @@ class RawLoader : public Tool {
   bool Execute() override;
   bool Finalise() override;
 
+  bool SaveCheckpoint(CheckpointState& state) override;
+  bool RestoreCheckpoint(const CheckpointState& state) override;
+
  protected:
 
   // Helper object used to load the raw data from the ROOT file
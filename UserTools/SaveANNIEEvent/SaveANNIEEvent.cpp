@@ -1,5 +1,14 @@
 #include "SaveANNIEEvent.h"
 
+#include <cstdio>
+#include <fstream>
+
+#include "ANNIEconstants.h"
+#include "ANNIEEventMerger.h"
+#include "Sharding.h"
+#include "StoreCopy.h"
+#include "Tracer.h"
+
 SaveANNIEEvent::SaveANNIEEvent():Tool(){}
 
 
@@ -13,13 +22,49 @@ bool SaveANNIEEvent::Initialise(std::string configfile, DataModel &data){
   /////////////////////////////////////////////////////////////////
 
   m_variables.Get("path", path);
+  // in --shards mode each process writes its own file, merged at the end
+  path=Sharding::OutputPath(path,Sharding::OutputType::BoostStore);
+  m_variables.Get("StoreStats", store_stats_enabled);
+
+  // Write resumable segments if a Checkpoint tool is in the ToolChain
+  use_segments=m_data->Checkpoints.enabled();
+  if(use_segments && !m_data->Checkpoints.Register("SaveANNIEEvent",this)){
+    std::cerr<<"SaveANNIEEvent: failed to restore state from the checkpoint"<<std::endl;
+    return false;
+  }
+
   return true;
 }
 
 
 bool SaveANNIEEvent::Execute(){
 
-  m_data->Stores["ANNIEEvent"]->Save(path);
+  if(store_stats_enabled){
+    BoostStore* annie_event=m_data->Stores["ANNIEEvent"];
+    if(!header_measured && annie_event->Header){
+      measure_annie_event_header(*(annie_event->Header), header_stats);
+      header_measured=true;
+    }
+    measure_annie_event(*annie_event, store_stats);
+  }
+
+  TraceSpan span("io","BoostStore::Save");
+  if(use_segments){
+    // start each segment from scratch, replacing any partial segment left
+    // behind by an interrupted job
+    if(entries_in_segment==0){
+      std::remove(SegmentPath(segment).c_str());
+      segment_store.reset(new BoostStore(false,BOOST_STORE_MULTIEVENT_FORMAT));
+    }
+    // the ANNIEEvent store may be the one LoadANNIEEvent reads from, so the
+    // segments are written through a store that can be closed at each
+    // checkpoint (every key is copied byte for byte)
+    copy_store(*(m_data->Stores["ANNIEEvent"]),*segment_store);
+    segment_store->Save(SegmentPath(segment));
+    segment_store->Delete();
+    entries_in_segment++;
+  }
+  else m_data->Stores["ANNIEEvent"]->Save(path);
   m_data->Stores["ANNIEEvent"]->Delete();
 
   return true;
@@ -28,8 +73,77 @@ bool SaveANNIEEvent::Execute(){
 
 bool SaveANNIEEvent::Finalise(){
 
+  bool merged=true;
+  if(!use_segments) m_data->Stores["ANNIEEvent"]->Close();
+  else{
+    m_data->Checkpoints.Unregister("SaveANNIEEvent");
+    if(entries_in_segment>0) CloseSegment();
+
+    // join the segments into the requested output file
+    ANNIEEventMerger merger(path,false);
+    for(unsigned int seg=0; seg<=segment; seg++){
+      if(!std::ifstream(SegmentPath(seg)).good()) continue;
+      std::string error;
+      if(!merger.AddFile(SegmentPath(seg),error)){
+        std::cerr<<"SaveANNIEEvent: failed to merge output segment: "<<error<<std::endl;
+        merged=false;
+        break;
+      }
+    }
+    merger.Close();
+    if(merged){
+      for(unsigned int seg=0; seg<=segment; seg++) std::remove(SegmentPath(seg).c_str());
+    }
+  }
 
-  m_data->Stores["ANNIEEvent"]->Close();
+  if(store_stats_enabled){
+    std::cout<<"ANNIEEvent header sizes (bytes)"<<std::endl;
+    header_stats.Print(std::cout);
+    std::cout<<"ANNIEEvent entry sizes (bytes)"<<std::endl;
+    store_stats.Print(std::cout);
+  }
+
+  return merged;
+}
+
+
+bool SaveANNIEEvent::SaveCheckpoint(CheckpointState& state){
+
+  // close the current segment so that everything saved so far is complete
+  // on disk, and continue in a new one
+  if(entries_in_segment>0){
+    CloseSegment();
+    segment++;
+    entries_in_segment=0;
+  }
+  state.Set("Segment",segment);
 
   return true;
 }
+
+
+bool SaveANNIEEvent::RestoreCheckpoint(const CheckpointState& state){
+
+  entries_in_segment=0;
+  return state.Get("Segment",segment);
+}
+
+
+void SaveANNIEEvent::CloseSegment(){
+
+  // the segment gets the header of the ANNIEEvent store, as the output file
+  // does without checkpointing
+  BoostStore* annie_event=m_data->Stores["ANNIEEvent"];
+  if(annie_event->Header && segment_store->Header){
+    copy_store(*(annie_event->Header),*(segment_store->Header));
+    segment_store->Header->Remove("TotalEntries");
+  }
+  segment_store->Close();
+  segment_store.reset();
+}
+
+
+std::string SaveANNIEEvent::SegmentPath(unsigned int seg) const{
+
+  return path+".part"+std::to_string(seg);
+}
@@ -3,10 +3,13 @@
 
 #include <string>
 #include <iostream>
+#include <memory>
 
+#include "CheckpointManager.h"
 #include "Tool.h"
+#include "StoreStats.h"
 
-class SaveANNIEEvent: public Tool {
+class SaveANNIEEvent: public Tool, public Checkpointable {
 
 
  public:
@@ -16,10 +19,31 @@ class SaveANNIEEvent: public Tool {
   bool Execute();
   bool Finalise();
 
+  const StoreStats& Stats() const {return store_stats;}
+
+  bool SaveCheckpoint(CheckpointState& state);
+  bool RestoreCheckpoint(const CheckpointState& state);
+
 
  private:
   std::string path;
 
+  // per-key size accounting, enabled with "StoreStats 1"
+  int store_stats_enabled=0;
+  bool header_measured=false;
+  StoreStats header_stats;
+  StoreStats store_stats;
+
+  // When checkpointing is enabled, the output is written as a series of
+  // segment files that are closed at each checkpoint and merged into path
+  // at Finalise
+  std::string SegmentPath(unsigned int seg) const;
+  void CloseSegment();
+  bool use_segments=false;
+  std::unique_ptr<BoostStore> segment_store;
+  unsigned int segment=0;
+  unsigned long entries_in_segment=0;
+
 
 
 
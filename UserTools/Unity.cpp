@@ -42,5 +42,12 @@
 #include "BeamFetcher/IFBeamDBInterface.cpp"
 #include "BeamFetcher/BeamFetcher.cpp"
 #include "FindTrackLengthInWater/FindTrackLengthInWater.cpp"
+#include "LoadANNIEEvent/ANNIEEventFileReader.cpp"
 #include "LoadANNIEEvent/LoadANNIEEvent.cpp"
 #include "PhaseITreeMaker/PhaseITreeMaker.cpp"
+#include "ANNIEEventMerge/ANNIEEventMerge.cpp"
+#include "Checkpoint/Checkpoint.cpp"
+#include "ParallelSubChain/ParallelSubChain.cpp"
+#include "Pipeline/Pipeline.cpp"
+#include "EventDistributor/EventDistributor.cpp"
+#include "EventCollector/EventCollector.cpp"
@@ -43,6 +43,22 @@ namespace annie {
       // or simply a warning message printed to std::cerr.
       void set_throw_on_trig_pmt_sequenceID_mismatch(bool should_I_throw);
 
+      // Get and restore the position of the reader in the input file(s).
+      // These are used to resume from a checkpoint.
+      inline long long get_pmt_data_entry() const
+        { return current_pmt_data_entry_; }
+      inline long long get_trig_data_entry() const
+        { return current_trig_data_entry_; }
+      inline long long get_last_sequence_id() const
+        { return last_sequence_id_; }
+      inline void set_position(long long pmt_data_entry,
+        long long trig_data_entry, long long last_sequence_id)
+      {
+        current_pmt_data_entry_ = pmt_data_entry;
+        current_trig_data_entry_ = trig_data_entry;
+        last_sequence_id_ = last_sequence_id;
+      }
+
       // Attempt to retrieve the readout with the given SequenceID from the
       // input file(s)
       //std::unique_ptr<RawReadout> get_sequence_id(int SequenceID);
@@ -0,0 +1,464 @@
+// bench-compare: compares benchmark results with the checked-in baseline
+// and fails if any of them has regressed (see bench/README.md)
+//
+// Usage: bench-compare <baseline file> <results file> [<results file> ...]
+//        bench-compare --update <baseline file> <results file> [...]
+//
+// The results files are the JSON arrays written by bench-run (through
+// run_bench.sh), bench-kernels, bench-lappd and bench-store. Each of their
+// metrics is looked up in the baseline, a JSON array of entries such as
+//
+//   {"benchmark": "chain/PhaseI", "metric": "events_per_s",
+//    "value": 12.5, "tolerance": 0.25}
+//
+// and counts as a regression if it is worse than the baseline value by more
+// than the tolerance (a fraction of the value). Informational metrics, such
+// as allocation counts that depend on the library versions, are compared
+// but never fail. Metrics without a baseline entry, and baseline entries
+// without a result, are listed but do not fail either. The exit status is 1
+// if there is a regression, a chain failed or no result had a baseline
+// entry to be compared with, and 0 otherwise.
+//
+// Timings depend on the speed of the machine, so bench-compare times a
+// fixed calibration workload (see calibrate()) and keeps its time in the
+// baseline. Before they are compared, the timings are scaled by the ratio of
+// the current calibration time to the baseline's, so that a baseline
+// recorded on one machine can be used on another.
+//
+// With --update, the baseline file is rewritten with the current values and
+// calibration time, keeping the tolerances of the entries that already
+// exist.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // A flat JSON object. Strings are kept in strings, numbers and booleans
+  // in numbers.
+  struct Object {
+    std::map<std::string, std::string> strings;
+    std::map<std::string, double> numbers;
+  };
+
+  // Rates and durations depend on the speed of the machine and are scaled
+  // by the calibration, while amounts (sizes and counts) are not
+  enum Kind { RATE, DURATION, AMOUNT };
+
+  struct Metric {
+    const char* name;
+    Kind kind;
+    bool higher_is_better;
+    double default_tolerance;
+    /// @brief Reported, but never counted as a regression
+    bool informational;
+  };
+
+  // The results of each benchmark program, recognized by the field that
+  // names the benchmark
+  struct Schema {
+    const char* name_field;
+    const char* prefix;
+    std::vector<const char*> parameters;
+    std::vector<Metric> metrics;
+  };
+
+  // Timings vary by a few percent from run to run even on an idle machine,
+  // and by more between machines even after the calibration, while the
+  // sizes are deterministic. The allocation counts are deterministic too,
+  // but follow the Boost and standard library versions.
+  const std::vector<Schema> SCHEMAS = {
+    { "chain", "chain", {},
+      { { "events_per_s", RATE, true, 0.25, false },
+        { "peak_rss_kb", AMOUNT, false, 0.10, false } } },
+    { "kernel", "kernel", { "samples", "minibuffers", "occupancy" },
+      { { "ns_per_sample", DURATION, false, 0.25, false } } },
+    { "stage", "lappd", {},
+      { { "waveforms_per_s", RATE, true, 0.25, false } } },
+    { "key", "store", {},
+      { { "write_mb_per_s", RATE, true, 0.25, false },
+        { "read_mb_per_s", RATE, true, 0.25, false },
+        { "bytes_per_event", AMOUNT, false, 0.01, false },
+        { "allocations_per_event", AMOUNT, false, 0.01, true } } },
+  };
+
+  // Name of the baseline entry that holds the calibration time
+  const std::string CALIBRATION_BENCHMARK = "calibration";
+  const std::string CALIBRATION_METRIC = "seconds";
+
+  struct Entry {
+    std::string benchmark;
+    std::string metric;
+    double value;
+    double tolerance;
+  };
+
+  class Parser {
+    public:
+      Parser(const std::string& text) : text_(text), pos_(0u) {}
+
+      // Reads an array of flat objects
+      bool parse(std::vector<Object>& objects) {
+        if ( !expect('[') ) return false;
+        skip_space();
+        if ( peek() == ']' ) return expect(']');
+        while (true) {
+          Object object;
+          if ( !parse_object(object) ) return false;
+          objects.push_back(object);
+          skip_space();
+          if ( peek() == ',' ) { ++pos_; continue; }
+          return expect(']');
+        }
+      }
+
+    protected:
+
+      bool parse_object(Object& object) {
+        if ( !expect('{') ) return false;
+        skip_space();
+        if ( peek() == '}' ) return expect('}');
+        while (true) {
+          std::string key;
+          if ( !parse_string(key) || !expect(':') ) return false;
+          skip_space();
+          if ( peek() == '"' ) {
+            if ( !parse_string(object.strings[key]) ) return false;
+          }
+          else if ( text_.compare(pos_, 4, "true") == 0 ) {
+            object.numbers[key] = 1.;
+            pos_ += 4;
+          }
+          else if ( text_.compare(pos_, 5, "false") == 0 ) {
+            object.numbers[key] = 0.;
+            pos_ += 5;
+          }
+          else {
+            const char* start = text_.c_str() + pos_;
+            char* end = nullptr;
+            object.numbers[key] = std::strtod(start, &end);
+            if ( end == start ) return false;
+            pos_ += end - start;
+          }
+          skip_space();
+          if ( peek() == ',' ) { ++pos_; skip_space(); continue; }
+          return expect('}');
+        }
+      }
+
+      bool parse_string(std::string& out) {
+        if ( !expect('"') ) return false;
+        out.clear();
+        while ( pos_ < text_.size() && text_[pos_] != '"' ) {
+          if ( text_[pos_] == '\\' ) ++pos_;
+          if ( pos_ < text_.size() ) out += text_[pos_++];
+        }
+        return expect('"');
+      }
+
+      void skip_space() {
+        while ( pos_ < text_.size() && std::isspace(
+          static_cast<unsigned char>(text_[pos_]) ) ) ++pos_;
+      }
+
+      char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+      bool expect(char c) {
+        skip_space();
+        if ( peek() != c ) return false;
+        ++pos_;
+        return true;
+      }
+
+      const std::string& text_;
+      size_t pos_;
+  };
+
+  bool read_objects(const std::string& filename, std::vector<Object>& objects)
+  {
+    std::ifstream in(filename);
+    if ( !in.good() ) {
+      std::cerr << "Error: Could not open " << filename << std::endl;
+      return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+    if ( !Parser(text).parse(objects) ) {
+      std::cerr << "Error: " << filename << " is not an array of flat JSON"
+        " objects" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // Time of a fixed workload that exercises the integer units, branches and
+  // memory: filling, sorting and hashing an array of 2^20 pseudo-random
+  // numbers. The fastest of several repetitions is kept, as the others were
+  // slowed down by something else.
+  double calibrate() {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<uint64_t> values(1u << 20);
+    uint64_t checksum = 0u;
+    double best = 0.;
+    for (int repetition = 0; repetition < 7; ++repetition) {
+      auto start = Clock::now();
+      uint64_t state = 20170402u;
+      for (auto& value : values) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        value = state >> 11;
+      }
+      std::sort(values.begin(), values.end());
+      for (uint64_t value : values) {
+        checksum = (checksum ^ value) * 1099511628211ull;
+      }
+      double seconds = std::chrono::duration<double>(Clock::now()
+        - start).count();
+      if ( repetition == 0 || seconds < best ) best = seconds;
+    }
+    // Keeps the hashing from being optimized away
+    if ( checksum == 0u ) std::cerr << '\n';
+    return best;
+  }
+
+  std::string format_number(double value) {
+    std::ostringstream stream;
+    stream << value;
+    return stream.str();
+  }
+
+  // Name of the benchmark that a result belongs to, e.g.
+  // "kernel/ADCHitFinder::find_pulses/samples=40000/minibuffers=1/..."
+  std::string benchmark_name(const Schema& schema, const Object& object) {
+    std::string name = std::string(schema.prefix) + '/'
+      + object.strings.at(schema.name_field);
+    if ( object.strings.count("mode") ) {
+      name += '/' + object.strings.at("mode");
+    }
+    for (const char* parameter : schema.parameters) {
+      auto found = object.numbers.find(parameter);
+      if ( found == object.numbers.end() ) continue;
+      name += std::string("/") + parameter + '='
+        + format_number(found->second);
+    }
+    return name;
+  }
+
+  void write_baseline(const std::string& filename,
+    const std::map<std::string, Entry>& entries)
+  {
+    std::ofstream out(filename);
+    out << "[\n";
+    size_t count = 0u;
+    for (const auto& pair : entries) {
+      const Entry& entry = pair.second;
+      out << "  {\"benchmark\": \"" << entry.benchmark << "\", \"metric\": \""
+        << entry.metric << "\", \"value\": " << format_number(entry.value)
+        << ", \"tolerance\": " << format_number(entry.tolerance) << '}'
+        << ( ++count < entries.size() ? ",\n" : "\n" );
+    }
+    out << "]\n";
+  }
+}
+
+int main(int argc, char* argv[]){
+
+  bool update = false;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--update") update = true;
+    else args.push_back(arg);
+  }
+  if (args.size() < 2u) {
+    std::cerr << "Usage: " << argv[0] << " [--update] <baseline file>"
+      << " <results file> [<results file> ...]" << std::endl;
+    return 1;
+  }
+
+  const std::string& baseline_file = args.front();
+
+  // Baseline entries, indexed by benchmark and metric
+  std::map<std::string, Entry> baseline;
+  std::vector<Object> baseline_objects;
+  if ( !read_objects(baseline_file, baseline_objects) ) return 1;
+  for (const auto& object : baseline_objects) {
+    if ( !object.strings.count("benchmark") || !object.strings.count("metric")
+      || !object.numbers.count("value") )
+    {
+      std::cerr << "Error: baseline entries need a benchmark, a metric and a"
+        " value" << std::endl;
+      return 1;
+    }
+    Entry entry = { object.strings.at("benchmark"),
+      object.strings.at("metric"), object.numbers.at("value"), 0.1 };
+    if ( object.numbers.count("tolerance") ) {
+      entry.tolerance = object.numbers.at("tolerance");
+    }
+    baseline[entry.benchmark + ' ' + entry.metric] = entry;
+  }
+
+  std::map<std::string, Entry> current;
+  bool failed = false;
+
+  for (size_t f = 1; f < args.size(); ++f) {
+    std::vector<Object> results;
+    if ( !read_objects(args.at(f), results) ) return 1;
+
+    for (const auto& object : results) {
+      const Schema* schema = nullptr;
+      for (const auto& s : SCHEMAS) {
+        if ( object.strings.count(s.name_field) ) { schema = &s; break; }
+      }
+      if ( !schema ) {
+        std::cerr << "Warning: skipping an unknown result in " << args.at(f)
+          << '\n';
+        continue;
+      }
+
+      std::string name = benchmark_name(*schema, object);
+      auto ok = object.numbers.find("ok");
+      if ( ok != object.numbers.end() && ok->second == 0. ) {
+        std::cout << name << " FAILED\n";
+        failed = true;
+        continue;
+      }
+
+      for (const auto& metric : schema->metrics) {
+        auto found = object.numbers.find(metric.name);
+        if ( found == object.numbers.end() ) continue;
+        std::string id = name + ' ' + metric.name;
+        current[id] = { name, metric.name, found->second,
+          metric.default_tolerance };
+      }
+    }
+  }
+
+  double calibration = calibrate();
+  std::string calibration_id = CALIBRATION_BENCHMARK + ' '
+    + CALIBRATION_METRIC;
+  std::printf("Calibration workload: %.1f ms\n", 1e3 * calibration);
+
+  if (update) {
+    for (auto& pair : current) {
+      auto found = baseline.find(pair.first);
+      if ( found != baseline.end() ) {
+        pair.second.tolerance = found->second.tolerance;
+      }
+    }
+    current[calibration_id] = { CALIBRATION_BENCHMARK, CALIBRATION_METRIC,
+      calibration, 0. };
+    write_baseline(baseline_file, current);
+    std::cout << "Wrote " << current.size() << " baseline values to "
+      << baseline_file << '\n';
+    return failed ? 1 : 0;
+  }
+
+  // Timings are scaled to the speed of the machine that recorded the
+  // baseline, e.g. halved for a rate on a machine that is twice as fast
+  double speed_ratio = 1.;
+  auto baseline_calibration = baseline.find(calibration_id);
+  if ( baseline_calibration != baseline.end() ) {
+    speed_ratio = calibration / baseline_calibration->second.value;
+    baseline.erase(baseline_calibration);
+    std::printf("Timings are scaled by %.3f to the speed of the baseline"
+      " machine\n\n", speed_ratio);
+  }
+
+  std::map<std::string, const Metric*> metrics;
+  for (const auto& schema : SCHEMAS) {
+    for (const auto& metric : schema.metrics) metrics[metric.name] = &metric;
+  }
+
+  int regressions = 0;
+  int improvements = 0;
+  int missing = 0;
+  int missing_timings = 0;
+  int compared = 0;
+  std::printf("%-80s %-22s %12s %12s %8s  %s\n", "Benchmark", "Metric",
+    "Baseline", "Current", "Change", "Status");
+  for (const auto& pair : current) {
+    const Entry& entry = pair.second;
+    const Metric& metric = *metrics.at(entry.metric);
+    double value = entry.value;
+    if ( metric.kind == RATE ) value *= speed_ratio;
+    else if ( metric.kind == DURATION ) value /= speed_ratio;
+
+    auto found = baseline.find(pair.first);
+    if ( found == baseline.end() ) {
+      ++missing;
+      if ( metric.kind != AMOUNT ) ++missing_timings;
+      std::printf("%-80s %-22s %12s %12.4g %8s  %s\n",
+        entry.benchmark.c_str(), entry.metric.c_str(), "-", value, "",
+        "no baseline");
+      continue;
+    }
+
+    const Entry& base = found->second;
+    double change = (base.value != 0.) ? (value - base.value)
+      / std::abs(base.value) : 0.;
+    // Positive when the metric got worse
+    double worse = metric.higher_is_better ? -change : change;
+    const char* status = "ok";
+    if ( metric.informational ) {
+      status = ( std::abs(change) > base.tolerance ) ? "changed (info)"
+        : "ok (info)";
+    }
+    else {
+      ++compared;
+      if ( worse > base.tolerance ) {
+        status = "REGRESSION";
+        ++regressions;
+      }
+      else if ( -worse > base.tolerance ) {
+        status = "improved";
+        ++improvements;
+      }
+    }
+    std::printf("%-80s %-22s %12.4g %12.4g %+7.1f%%  %s\n",
+      entry.benchmark.c_str(), entry.metric.c_str(), base.value, value,
+      100. * change, status);
+  }
+
+  // Baseline entries that none of the results files measured, e.g. because
+  // a benchmark was renamed or left out
+  int unmeasured = 0;
+  for (const auto& pair : baseline) {
+    if ( current.count(pair.first) ) continue;
+    ++unmeasured;
+    std::printf("%-80s %-22s %12.4g %12s %8s  %s\n",
+      pair.second.benchmark.c_str(), pair.second.metric.c_str(),
+      pair.second.value, "-", "", "not measured");
+  }
+
+  std::cout << '\n' << current.size() << " metrics: " << regressions
+    << " regressed, " << improvements << " improved beyond the tolerance, "
+    << missing << " without a baseline; " << unmeasured << " baseline"
+    " entries not measured\n";
+  if (missing_timings > 0) {
+    std::cout << "Warning: " << missing_timings << " timings have no"
+      " baseline, so their slowdowns are not checked\n";
+  }
+  if (missing > 0 || improvements > 0) {
+    std::cout << "Run \"make bench-baseline\" on the reference machine to"
+      " record the current values\n";
+  }
+  if (failed) std::cout << "At least one chain failed\n";
+  if (compared == 0) {
+    std::cerr << "Error: None of the results has an entry in "
+      << baseline_file << ", so nothing was checked" << std::endl;
+  }
+
+  return (regressions > 0 || failed || compared == 0) ? 1 : 0;
+}
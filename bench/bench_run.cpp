@@ -0,0 +1,69 @@
+// bench-run: runs one benchmark chain and prints its throughput and peak
+// memory use as a JSON object (see bench/README.md)
+//
+// Usage: bench-run <chain name> <number of events> <command> [<args> ...]
+//
+// The wall-clock time covers the whole process, including the Initialise and
+// Finalise steps of the tools. The peak resident set size is that of the
+// command's process, as reported by wait4().
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char* argv[]){
+
+  if (argc<4){
+    std::cerr<<"Usage: "<<argv[0]<<" <chain name> <number of events>"
+             <<" <command> [<args> ...]"<<std::endl;
+    return 1;
+  }
+
+  std::string name=argv[1];
+  long events=std::stol(argv[2]);
+
+  auto start=std::chrono::steady_clock::now();
+
+  pid_t pid=fork();
+  if (pid<0){
+    std::perror("fork");
+    return 1;
+  }
+  if (pid==0){
+    // Keep the chain's own output away from the JSON on stdout
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    execvp(argv[3], argv+3);
+    std::perror(argv[3]);
+    _exit(127);
+  }
+
+  int status=0;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage)<0){
+    std::perror("wait4");
+    return 1;
+  }
+
+  double seconds=std::chrono::duration<double>(
+    std::chrono::steady_clock::now()-start).count();
+
+  bool ok=WIFEXITED(status) && WEXITSTATUS(status)==0;
+  if (!ok){
+    std::cerr<<"Error: chain "<<name<<" failed (status "<<status<<")"
+             <<std::endl;
+  }
+
+  // ru_maxrss is in kB on Linux
+  std::printf("{\"chain\": \"%s\", \"events\": %ld, \"seconds\": %.3f,"
+    " \"events_per_s\": %.2f, \"peak_rss_kb\": %ld, \"ok\": %s}\n",
+    name.c_str(), events, seconds, seconds>0. ? events/seconds : 0.,
+    static_cast<long>(usage.ru_maxrss), ok ? "true" : "false");
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// standard library includes
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "BeamDataPoint.h"
+#include "BoostStore.h"
+#include "Generators.h"
+#include "RandomStreams.h"
+
+namespace {
+
+  // Each BeamDB entry covers one chunk, like a BeamFetcher query
+  constexpr unsigned long long CHUNK_STEP_MS = 60000ull;
+  constexpr unsigned long long MARGIN_MS = 10000ull;
+
+  // Booster spills reach the target at up to 15 Hz
+  constexpr unsigned long long SPILL_INTERVAL_MS = 67ull;
+
+  // A synthetic CSV response of the Intensity Frontier beam database for the
+  // interval [t0, t1]
+  std::string make_response(unsigned long long t0, unsigned long long t1) {
+    std::ostringstream response;
+    response << "time_stamp,name,units,value\n";
+
+    for (unsigned long long t = t0 - t0 % SPILL_INTERVAL_MS; t <= t1;
+      t += SPILL_INTERVAL_MS)
+    {
+      if (t < t0) continue;
+      // Each spill gets the same values in every chunk that contains it
+      CounterRNG rng = RandomStreams::Stream(0u, t, "GenerateBeamDB",
+        "spill");
+      double pot = rng.Gaus(4.3, 0.2);
+      // Occasional spills with little or no beam
+      if (rng.Rndm() < 0.02) pot = rng.Uniform(0., 0.05);
+      double pot_upstream = pot * rng.Gaus(1.02, 0.005);
+
+      response << t << ",E:TOR860,E12," << pot_upstream << '\n';
+      response << t << ",E:TOR875,E12," << pot << '\n';
+      response << t << ",E:THCURR,kA," << rng.Gaus(174., 0.5) << '\n';
+    }
+
+    return response.str();
+  }
+
+  // Parses a response the way IFBeamDBInterface::ParseDBResponse() does,
+  // including the conversion of the toroid values to POT
+  std::map<std::string, std::map<unsigned long long, BeamDataPoint> >
+    parse_response(const std::string& response)
+  {
+    std::map<std::string, std::map<unsigned long long,
+      BeamDataPoint> > beam_data;
+
+    std::istringstream response_stream(response);
+    unsigned long long time_stamp;
+    std::string data_type;
+    std::string unit;
+    double value;
+
+    std::getline(response_stream, unit, '\n');
+    while (response_stream >> time_stamp) {
+      response_stream.ignore(1);
+      std::getline(response_stream, data_type, ',');
+      std::getline(response_stream, unit, ',');
+      response_stream >> value;
+      if (!response_stream) break;
+
+      if (unit == "E12") {
+        std::stringstream ss;
+        ss << value << unit;
+        ss >> value;
+        unit = "POT";
+      }
+      beam_data[data_type][time_stamp] = BeamDataPoint(value, unit);
+    }
+
+    return beam_data;
+  }
+}
+
+bool GenerateBeamDB(const std::string& filename, int duration_sec,
+  uint64_t seed)
+{
+  std::ofstream response_file(filename + ".csv");
+  if ( !response_file.good() ) {
+    std::cerr << "Error: Could not create " << filename << ".csv\n";
+    return false;
+  }
+
+  RandomStreams::SetSeed(seed);
+
+  BoostStore beam_db_store(false, BOOST_STORE_MULTIEVENT_FORMAT);
+
+  std::map<int, std::pair<unsigned long long, unsigned long long> >
+    beam_db_index;
+
+  unsigned long long start_ms = BENCH_START_TIME_SEC * THOUSAND - MARGIN_MS;
+  unsigned long long end_ms = (BENCH_START_TIME_SEC + duration_sec)
+    * THOUSAND + MARGIN_MS;
+
+  // Work backwards through the period in chunks, as the BeamFetcher does,
+  // with a small overlap between chunks
+  unsigned long long current_time = end_ms;
+  int current_entry = 0;
+  while (current_time >= start_ms) {
+
+    if (current_entry > 0) current_time -= CHUNK_STEP_MS;
+
+    std::string response = make_response(current_time - CHUNK_STEP_MS,
+      current_time + MARGIN_MS);
+    response_file << response;
+
+    auto beam_data = parse_response(response);
+    const auto& pot_map = beam_data.at("E:TOR875");
+
+    beam_db_index[current_entry] = std::make_pair(pot_map.cbegin()->first,
+      pot_map.crbegin()->first);
+
+    beam_db_store.Set("BeamDB", beam_data);
+    beam_db_store.Save(filename);
+    beam_db_store.Delete();
+
+    ++current_entry;
+  }
+
+  beam_db_store.Header->Set("BeamDBIndex", beam_db_index);
+
+  unsigned long long overall_start_ms
+    = std::numeric_limits<unsigned long long>::max();
+  unsigned long long overall_end_ms = 0ull;
+  for (const auto& pair : beam_db_index) {
+    if (pair.second.first < overall_start_ms)
+      overall_start_ms = pair.second.first;
+    if (pair.second.second > overall_end_ms)
+      overall_end_ms = pair.second.second;
+  }
+
+  beam_db_store.Header->Set("StartMillisecondsSinceEpoch", overall_start_ms);
+  beam_db_store.Header->Set("EndMillisecondsSinceEpoch", overall_end_ms);
+  beam_db_store.Close();
+
+  std::cout << "Wrote " << current_entry << " beam database entries to "
+    << filename << '\n';
+  return true;
+}
@@ -0,0 +1,52 @@
+// Synthetic input files for the benchmark chains (see bench/README.md)
+//
+// Each generator writes the same file for the same seed and size, so that
+// the throughput of a chain can be compared across commits. The random
+// numbers come from the counter-based streams in DataModel/RandomStreams.h,
+// keyed by the seed, the event number and the generator name.
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <string>
+
+/// @brief Time of the first synthetic readout (2 April 2017, during the
+/// Phase I beam run) in seconds since the Unix epoch. The raw data and beam
+/// database generators share it so that every beam minibuffer has a POT
+/// value.
+constexpr int BENCH_START_TIME_SEC = 1491132660;
+
+/// @brief Raw PMTData, TrigData and RunInformation trees in the format read
+/// by the RawLoader tool. Each readout has one beam minibuffer for each of
+/// the 64 Phase I ADC channels.
+/// @param minibuffer_size Samples per channel in each readout
+bool GenerateRawData(const std::string& filename, int num_readouts,
+  int minibuffer_size, uint64_t seed);
+
+/// @brief Beam database BoostStore in the format written by the BeamFetcher
+/// tool, built by parsing synthetic CSV responses of the Intensity Frontier
+/// beam database. The responses are also written to <filename>.csv.
+/// @param duration_sec Length of the period covered, starting
+/// BENCH_START_TIME_SEC (minus a margin)
+bool GenerateBeamDB(const std::string& filename, int duration_sec,
+  uint64_t seed);
+
+/// @brief ANNIEEvent BoostStore like the one written by the LoadWCSim tool,
+/// with the AnnieGeometry in the header and MC particles, tank PMT hits and
+/// MRD/veto TDC hits in each event
+bool GenerateWCSimEvents(const std::string& filename, int num_events,
+  uint64_t seed);
+
+/// @brief Number of strip channels read out by each ACDC board (NUM_CHS in
+/// UserTools/LAPPDParseACC)
+constexpr int ACDC_NUM_CHANNELS = 30;
+
+/// @brief ACDC text files (<filebase>.ped, .acdc and .meta) in the format
+/// read by the LAPPDParseACC tool
+bool GenerateLAPPDACDC(const std::string& filebase, int num_events,
+  uint64_t seed);
+
+/// @brief ANNIEToyEventTree in the format read by the
+/// NeutronStudyReadSandbox tool
+bool GenerateNeutronSandbox(const std::string& filename, int num_events,
+  uint64_t seed);
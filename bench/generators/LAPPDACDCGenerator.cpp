@@ -0,0 +1,91 @@
+// standard library includes
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// ToolAnalysis includes
+#include "Generators.h"
+#include "RandomStreams.h"
+
+namespace {
+
+  // Must match NUM_CELLS and NUM_CHS in UserTools/LAPPDParseACC
+  const int NUM_CELLS = 256;
+  const int NUM_CHS = ACDC_NUM_CHANNELS;
+  const int BOARD = 0;
+
+  const char* const META_HEADER = "Event Board count trig_time_hi"
+    " trig_time_lo vbias ro_target_count ro_dac_value";
+
+  // Pedestal of each cell, the same in every event
+  double pedestal(int channel, int cell) {
+    CounterRNG rng = RandomStreams::Stream(0u, channel * NUM_CELLS + cell,
+      "GenerateLAPPDACDC", "pedestal");
+    return rng.Gaus(1000., 20.);
+  }
+}
+
+bool GenerateLAPPDACDC(const std::string& filebase, int num_events,
+  uint64_t seed)
+{
+  std::ofstream ped_file(filebase + ".ped");
+  std::ofstream acdc_file(filebase + ".acdc");
+  std::ofstream meta_file(filebase + ".meta");
+  if ( !ped_file.good() || !acdc_file.good() || !meta_file.good() ) {
+    std::cerr << "Error: Could not create the ACDC files " << filebase
+      << ".{ped,acdc,meta}\n";
+    return false;
+  }
+
+  RandomStreams::SetSeed(seed);
+
+  // LAPPDParseACC reads until the end of each file, so the last line must
+  // not end with a newline
+  ped_file << "Board Channel Pedestals";
+  for (int ch = 0; ch < NUM_CHS; ++ch) {
+    ped_file << '\n' << BOARD << ' ' << ch;
+    for (int cell = 0; cell < NUM_CELLS; ++cell) {
+      ped_file << ' ' << std::lround( pedestal(ch, cell) );
+    }
+  }
+
+  acdc_file << "Event Board Channel Samples";
+  meta_file << META_HEADER;
+
+  for (int event = 0; event < num_events; ++event) {
+
+    CounterRNG rng = RandomStreams::Stream(0u, event, "GenerateLAPPDACDC",
+      "event");
+
+    // A pulse shared by a few neighbouring strips, with an amplitude that
+    // falls off away from the central strip, on top of a slow sine-like
+    // baseline pick-up
+    int center_strip = rng.Integer(NUM_CHS);
+    double pulse_time = rng.Uniform(60., 200.); // cells
+    double pulse_amplitude = rng.Uniform(30., 300.);
+    double pickup_amplitude = rng.Uniform(2., 6.);
+    double pickup_phase = rng.Uniform(0., 2. * M_PI);
+
+    for (int ch = 0; ch < NUM_CHS; ++ch) {
+      acdc_file << '\n' << event << ' ' << BOARD << ' ' << ch;
+      double amplitude = pulse_amplitude * std::exp( -std::abs(ch
+        - center_strip) );
+      for (int cell = 0; cell < NUM_CELLS; ++cell) {
+        double x = (cell - pulse_time) / 2.5;
+        double value = pedestal(ch, cell) + rng.Gaus(0., 3.)
+          + pickup_amplitude * std::sin(0.055 * cell + pickup_phase)
+          - amplitude * std::exp(-0.5 * x * x);
+        acdc_file << ' ' << std::lround(value);
+      }
+    }
+
+    meta_file << '\n' << event << ' ' << BOARD << ' ' << event << ' '
+      << (event >> 16) << ' ' << (event & 0xFFFF) << ' ' << 2400 << ' '
+      << rng.Integer(256u) << ' ' << 1200;
+  }
+
+  std::cout << "Wrote " << num_events << " ACDC events to " << filebase
+    << ".{ped,acdc,meta}\n";
+  return true;
+}
@@ -0,0 +1,89 @@
+// standard library includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+// ROOT includes
+#include "TFile.h"
+#include "TTree.h"
+
+// ToolAnalysis includes
+#include "Generators.h"
+#include "RandomStreams.h"
+
+bool GenerateNeutronSandbox(const std::string& filename, int num_events,
+  uint64_t seed)
+{
+  TFile file(filename.c_str(), "RECREATE");
+  if ( file.IsZombie() ) {
+    std::cerr << "Error: Could not create " << filename << '\n';
+    return false;
+  }
+
+  RandomStreams::SetSeed(seed);
+
+  int primneut = 0;
+  int totneut = 0;
+  int ispi = 0;
+  double nuE = 0.;
+  double muE = 0.;
+  double muAngle = 0.;
+  double mupx = 0.;
+  double mupy = 0.;
+  double mupz = 0.;
+  double piE = 0.;
+  double piAngle = 0.;
+  double q2 = 0.;
+  double recoE = 0.;
+
+  // The tree belongs to the file, which deletes it when it is closed
+  TTree* tree = new TTree("ANNIEToyEventTree", "Synthetic neutrino events");
+  tree->Branch("nu_E", &nuE, "nu_E/D");
+  tree->Branch("mu_E", &muE, "mu_E/D");
+  tree->Branch("mu_angle", &muAngle, "mu_angle/D");
+  tree->Branch("isPi", &ispi, "isPi/I");
+  tree->Branch("pi_E", &piE, "pi_E/D");
+  tree->Branch("pi_angle", &piAngle, "pi_angle/D");
+  tree->Branch("q2", &q2, "q2/D");
+  tree->Branch("Nprimaryneutrons", &primneut, "Nprimaryneutrons/I");
+  tree->Branch("Ntotneutrons", &totneut, "Ntotneutrons/I");
+  tree->Branch("recoE", &recoE, "recoE/D");
+  tree->Branch("mu_px", &mupx, "mu_px/D");
+  tree->Branch("mu_py", &mupy, "mu_py/D");
+  tree->Branch("mu_pz", &mupz, "mu_pz/D");
+
+  const double MUON_MASS = 0.105658; // GeV
+
+  for (int event = 0; event < num_events; ++event) {
+
+    CounterRNG rng = RandomStreams::Stream(0u, event,
+      "GenerateNeutronSandbox", "event");
+
+    // Roughly the Booster neutrino spectrum (GeV)
+    nuE = std::max(0.2, rng.Gaus(0.8, 0.4));
+    ispi = ( rng.Rndm() < 0.25 ) ? 1 : 0;
+    piE = ispi ? rng.Uniform(0.14, 0.3 * nuE + 0.14) : 0.;
+    piAngle = ispi ? std::acos( rng.Uniform(-1., 1.) ) : 0.;
+    muE = std::max(MUON_MASS + 0.01, nuE - piE - rng.Uniform(0., 0.2));
+    muAngle = std::acos( rng.Uniform(0.2, 1.) );
+    double phi = rng.Uniform(0., 2. * M_PI);
+    double mu_momentum = std::sqrt(muE * muE - MUON_MASS * MUON_MASS);
+    mupx = mu_momentum * std::sin(muAngle) * std::cos(phi);
+    mupy = mu_momentum * std::sin(muAngle) * std::sin(phi);
+    mupz = mu_momentum * std::cos(muAngle);
+    q2 = 2. * nuE * (muE - mupz) - MUON_MASS * MUON_MASS;
+    recoE = nuE * rng.Gaus(1., 0.1);
+
+    primneut = rng.Integer(3u);
+    totneut = primneut + rng.Integer(4u);
+
+    tree->Fill();
+  }
+
+  file.Write();
+  file.Close();
+
+  std::cout << "Wrote " << num_events << " events to " << filename << '\n';
+  return true;
+}
@@ -0,0 +1,212 @@
+// standard library includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// ROOT includes
+#include "TFile.h"
+#include "TTree.h"
+
+// ToolAnalysis includes
+#include "Generators.h"
+#include "RandomStreams.h"
+
+namespace {
+
+  // VME cards holding the Phase I ADC channels (see the PMT ID map in
+  // UserTools/RawLoader/RawLoader.cpp)
+  const int CARD_IDS[] = { 3, 4, 5, 6, 8, 9, 10, 11, 13, 14, 15, 16, 18, 19,
+    20, 21 };
+  const int NUM_CARDS = sizeof(CARD_IDS) / sizeof(CARD_IDS[0]);
+  const int CHANNELS_PER_CARD = 4;
+
+  // The RawReader multiplies the Eventsize branch by this to get the
+  // minibuffer size in samples
+  const int EVENT_SIZE_TO_MINIBUFFER_SIZE = 4;
+
+  const double BASELINE = 350.; // ADC counts
+  const double BASELINE_NOISE = 1.5;
+  const double MEAN_PULSES = 4.; // per channel and minibuffer
+
+  // Fills one minibuffer of a channel with a noisy baseline and a few
+  // Gaussian pulses
+  void make_waveform(CounterRNG& rng, std::vector<unsigned short>& samples) {
+    double baseline = rng.Gaus(BASELINE, 5.);
+    for (auto& sample : samples) {
+      sample = static_cast<unsigned short>( std::lround(
+        rng.Gaus(baseline, BASELINE_NOISE) ) );
+    }
+
+    int num_pulses = static_cast<int>( rng.Uniform(0., 2. * MEAN_PULSES) );
+    for (int p = 0; p < num_pulses; ++p) {
+      double peak = rng.Uniform(0., samples.size());
+      double amplitude = 10. + 200. * rng.Rndm() * rng.Rndm();
+      double width = rng.Uniform(1., 3.);
+      int first = std::max(0, static_cast<int>(peak - 5. * width));
+      int last = std::min(static_cast<int>(samples.size()) - 1,
+        static_cast<int>(peak + 5. * width));
+      for (int s = first; s <= last; ++s) {
+        double x = (s - peak) / width;
+        double value = samples[s] + amplitude * std::exp(-0.5 * x * x);
+        samples[s] = static_cast<unsigned short>( std::min(4095.,
+          std::round(value)) );
+      }
+    }
+  }
+
+  // The cards store each channel's minibuffers split into two halves, with
+  // pairs of consecutive samples alternating between them. This is the
+  // inverse of the unpacking done by annie::RawChannel.
+  void pack_channel(
+    const std::vector<std::vector<unsigned short> >& minibuffers,
+    unsigned short* channel_buffer, int buffer_size)
+  {
+    int num_minibuffers = minibuffers.size();
+    int half_minibuffer_length = (buffer_size / 2) / num_minibuffers;
+    unsigned short* first_half = channel_buffer;
+    unsigned short* second_half = channel_buffer + buffer_size / 2;
+
+    for (int mb = 0; mb < num_minibuffers; ++mb) {
+      int start_sample = mb * half_minibuffer_length;
+      for (int s = 0; s < half_minibuffer_length; s += 2) {
+        const unsigned short* unpacked = &minibuffers[mb][2 * s];
+        first_half[start_sample + s] = unpacked[0];
+        first_half[start_sample + s + 1] = unpacked[1];
+        second_half[start_sample + s] = unpacked[2];
+        second_half[start_sample + s + 1] = unpacked[3];
+      }
+    }
+  }
+}
+
+bool GenerateRawData(const std::string& filename, int num_readouts,
+  int minibuffer_size, uint64_t seed)
+{
+  if ( minibuffer_size <= 0 || minibuffer_size % 4 != 0 ) {
+    std::cerr << "Error: The minibuffer size must be a positive multiple"
+      " of 4\n";
+    return false;
+  }
+
+  TFile file(filename.c_str(), "RECREATE");
+  if ( file.IsZombie() ) {
+    std::cerr << "Error: Could not create " << filename << '\n';
+    return false;
+  }
+
+  RandomStreams::SetSeed(seed);
+
+  // The single minibuffer of each readout is a beam trigger
+  const int num_minibuffers = 1;
+  const int num_channels = CHANNELS_PER_CARD;
+
+  unsigned long long last_sync = 0ull;
+  int sequence_id = 0;
+  int start_time_sec = 0;
+  int start_time_nsec = 0;
+  unsigned long long start_count = 0ull;
+  int trigger_number = num_minibuffers;
+  int card_id = 0;
+  int channels = num_channels;
+  int buffer_size = num_minibuffers * minibuffer_size;
+  int full_buffer_size = num_channels * buffer_size;
+  int event_size = minibuffer_size / EVENT_SIZE_TO_MINIBUFFER_SIZE;
+  std::vector<unsigned short> data(full_buffer_size);
+  std::vector<unsigned long long> trigger_counts(trigger_number);
+  std::vector<unsigned int> rates(num_channels);
+
+  // The trees belong to the file, which deletes them when it is closed
+  TTree* pmt_data = new TTree("PMTData", "Synthetic PMT data");
+  pmt_data->Branch("LastSync", &last_sync, "LastSync/l");
+  pmt_data->Branch("SequenceID", &sequence_id, "SequenceID/I");
+  pmt_data->Branch("StartTimeSec", &start_time_sec, "StartTimeSec/I");
+  pmt_data->Branch("StartTimeNSec", &start_time_nsec, "StartTimeNSec/I");
+  pmt_data->Branch("StartCount", &start_count, "StartCount/l");
+  pmt_data->Branch("TriggerNumber", &trigger_number, "TriggerNumber/I");
+  pmt_data->Branch("CardID", &card_id, "CardID/I");
+  pmt_data->Branch("Channels", &channels, "Channels/I");
+  pmt_data->Branch("BufferSize", &buffer_size, "BufferSize/I");
+  pmt_data->Branch("FullBufferSize", &full_buffer_size, "FullBufferSize/I");
+  pmt_data->Branch("Eventsize", &event_size, "Eventsize/I");
+  pmt_data->Branch("Data", data.data(), "Data[FullBufferSize]/s");
+  pmt_data->Branch("TriggerCounts", trigger_counts.data(),
+    "TriggerCounts[TriggerNumber]/l");
+  pmt_data->Branch("Rates", rates.data(), "Rates[Channels]/i");
+
+  int firmware_version = 1;
+  int trig_sequence_id = 0;
+  int trig_event_size = num_minibuffers;
+  int trigger_size = 0;
+  int fifo_overflow = 0;
+  int driver_overflow = 0;
+
+  TTree* trig_data = new TTree("TrigData", "Synthetic trigger data");
+  trig_data->Branch("FirmwareVersion", &firmware_version, "FirmwareVersion/I");
+  trig_data->Branch("SequenceID", &trig_sequence_id, "SequenceID/I");
+  trig_data->Branch("EventSize", &trig_event_size, "EventSize/I");
+  trig_data->Branch("TriggerSize", &trigger_size, "TriggerSize/I");
+  trig_data->Branch("FIFOOverflow", &fifo_overflow, "FIFOOverflow/I");
+  // Typo exists in the branch name definition in the DAQ software
+  trig_data->Branch("DriverOverfow", &driver_overflow, "DriverOverfow/I");
+
+  std::vector<std::vector<unsigned short> > minibuffers(num_minibuffers,
+    std::vector<unsigned short>(minibuffer_size));
+
+  for (int readout = 0; readout < num_readouts; ++readout) {
+
+    sequence_id = readout;
+    trig_sequence_id = readout;
+    // One readout per second. The trigger time within the second is given by
+    // the trigger count in 8 ns clock ticks since the last sync.
+    start_time_sec = BENCH_START_TIME_SEC + readout;
+    CounterRNG trigger_rng = RandomStreams::Stream(0u, readout,
+      "GenerateRawData", "trigger");
+    for (auto& count : trigger_counts) count = trigger_rng.Integer(100000000u);
+
+    for (int c = 0; c < NUM_CARDS; ++c) {
+      card_id = CARD_IDS[c];
+      CounterRNG rng = RandomStreams::Stream(0u, readout, "GenerateRawData",
+        "card" + std::to_string(card_id));
+
+      start_time_nsec = rng.Integer(1000u);
+
+      for (int ch = 0; ch < num_channels; ++ch) {
+        rates[ch] = 1000u + rng.Integer(500u);
+        for (auto& minibuffer : minibuffers) make_waveform(rng, minibuffer);
+        pack_channel(minibuffers, &data[ch * buffer_size], buffer_size);
+      }
+
+      pmt_data->Fill();
+    }
+
+    trig_data->Fill();
+  }
+
+  // Run information as JSON strings. RunType 3 labels the minibuffers as
+  // beam triggers.
+  std::string info_title;
+  std::string info_message;
+  std::string* info_title_ptr = &info_title;
+  std::string* info_message_ptr = &info_message;
+  TTree* run_information = new TTree("RunInformation",
+    "Synthetic run information");
+  run_information->Branch("InfoTitle", &info_title_ptr);
+  run_information->Branch("InfoMessage", &info_message_ptr);
+
+  info_title = "PostgresVariables";
+  info_message = "{\"RunNumber\":9000,\"SubRunNumber\":0}";
+  run_information->Fill();
+
+  info_title = "InputVariables";
+  info_message = "{\"RunType\":3}";
+  run_information->Fill();
+
+  file.Write();
+  file.Close();
+
+  std::cout << "Wrote " << num_readouts << " readouts to " << filename
+    << '\n';
+  return true;
+}
@@ -0,0 +1,195 @@
+// standard library includes
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "BeamStatusClass.h"
+#include "BoostStore.h"
+#include "ChannelKey.h"
+#include "Detector.h"
+#include "Generators.h"
+#include "Geometry.h"
+#include "Hit.h"
+#include "Particle.h"
+#include "RandomStreams.h"
+#include "TimeClass.h"
+#include "TriggerClass.h"
+
+namespace {
+
+  // Detector counts and dimensions (cm) similar to the WCSim ANNIE geometry
+  const int NUM_TANK_PMTS = 128;
+  const int NUM_MRD_PMTS = 306;
+  const int NUM_VETO_PMTS = 26;
+  const int NUM_LAPPDS = 5;
+  const double TANK_RADIUS = 152.4;
+  const double TANK_HALFHEIGHT = 198.;
+  const double MRD_WIDTH = 305.;
+  const double MRD_HEIGHT = 274.;
+  const double MRD_DEPTH = 139.5;
+  const double MRD_START = 325.5;
+
+  // Tubes per MRD layer used to place synthetic tracks
+  const int MRD_TUBES_PER_LAYER = 26;
+
+  // Direction(x, y, z) does not store its arguments, so build unit vectors
+  // from their angles
+  Direction unit_direction(double dx, double dy, double dz) {
+    return Direction(std::atan2(dy, dx), std::asin(dz));
+  }
+
+  Geometry make_geometry() {
+    std::map<ChannelKey, Detector> detectors;
+
+    for (int i = 0; i < NUM_TANK_PMTS; ++i) {
+      double phi = 2. * M_PI * (i % 16) / 16.;
+      double y = -TANK_HALFHEIGHT + 2. * TANK_HALFHEIGHT * (i / 16 + 0.5) / 8.;
+      detectors.emplace(ChannelKey(subdetector::ADC, i), Detector("Tank",
+        Position(TANK_RADIUS * std::cos(phi), y, TANK_RADIUS * std::sin(phi)),
+        unit_direction(-std::cos(phi), 0., -std::sin(phi)), i, "R7081",
+        detectorstatus::ON, 0.));
+    }
+
+    for (int i = 0; i < NUM_MRD_PMTS; ++i) {
+      int layer = i / MRD_TUBES_PER_LAYER;
+      double offset = -0.5 * MRD_WIDTH + MRD_WIDTH
+        * (i % MRD_TUBES_PER_LAYER + 0.5) / MRD_TUBES_PER_LAYER;
+      bool horizontal = ( layer % 2 == 0 );
+      detectors.emplace(ChannelKey(subdetector::TDC, i), Detector("MRD",
+        Position(horizontal ? 0. : offset, horizontal ? offset : 0.,
+        MRD_START + MRD_DEPTH * (layer + 0.5) / 12.),
+        unit_direction(0., 0., 1.), i, "MRDPMT", detectorstatus::ON, 0.));
+    }
+
+    // Veto and MRD tubes share the TDC subdetector and are numbered from 0,
+    // as in LoadWCSim, so the veto tubes do not get entries of their own
+    for (int i = 0; i < NUM_VETO_PMTS; ++i) {
+      detectors.emplace(ChannelKey(subdetector::TDC, i), Detector("Veto",
+        Position(-0.5 * MRD_WIDTH + MRD_WIDTH * (i + 0.5) / NUM_VETO_PMTS,
+        0., -TANK_RADIUS - 200.), unit_direction(0., 0., 1.), i, "VetoPMT",
+        detectorstatus::ON, 0.));
+    }
+
+    for (int i = 0; i < NUM_LAPPDS; ++i) {
+      detectors.emplace(ChannelKey(subdetector::LAPPD, i), Detector("Tank",
+        Position(0., -50. + 25. * i, TANK_RADIUS),
+        unit_direction(0., 0., -1.), i, "LAPPD", detectorstatus::ON, 0.));
+    }
+
+    return Geometry(detectors, 1., TANK_RADIUS, TANK_HALFHEIGHT, MRD_WIDTH,
+      MRD_HEIGHT, MRD_DEPTH, MRD_START, NUM_TANK_PMTS, NUM_MRD_PMTS,
+      NUM_VETO_PMTS, NUM_LAPPDS, detectorstatus::ON);
+  }
+
+  void add_hit(std::map<ChannelKey, std::vector<Hit> >& hits, subdetector type,
+    int tube, uint64_t time_ns, double charge)
+  {
+    hits[ChannelKey(type, tube)].emplace_back(tube, TimeClass(time_ns),
+      charge);
+  }
+}
+
+bool GenerateWCSimEvents(const std::string& filename, int num_events,
+  uint64_t seed)
+{
+  RandomStreams::SetSeed(seed);
+
+  const uint32_t run_number = 9000u;
+  const uint32_t subrun_number = 0u;
+  const std::string mc_file = "bench_wcsim_" + std::to_string(seed) + ".root";
+
+  BoostStore annie_event(false, BOOST_STORE_MULTIEVENT_FORMAT);
+
+  for (int event = 0; event < num_events; ++event) {
+
+    CounterRNG rng = RandomStreams::Stream(run_number, event,
+      "GenerateWCSimEvents", "event");
+
+    uint64_t event_time_ns = (BENCH_START_TIME_SEC + event) * BILLION;
+
+    // A muon from a neutrino interaction in the tank
+    double cos_theta = rng.Uniform(0.6, 1.);
+    double sin_theta = std::sqrt(1. - cos_theta * cos_theta);
+    double phi = rng.Uniform(0., 2. * M_PI);
+    double dx = sin_theta * std::cos(phi);
+    double dy = sin_theta * std::sin(phi);
+    double dz = cos_theta;
+    Position vertex(rng.Uniform(-100., 100.), rng.Uniform(-100., 100.),
+      rng.Uniform(-100., 100.));
+    double muon_energy = rng.Uniform(200., 2000.); // MeV
+    double track_length = muon_energy / 2.;
+    Position stop(vertex.X() + track_length * dx,
+      vertex.Y() + track_length * dy, vertex.Z() + track_length * dz);
+
+    std::vector<Particle> mc_particles;
+    mc_particles.emplace_back(13, muon_energy, 0., vertex, stop,
+      TimeClass(event_time_ns), TimeClass(event_time_ns + 20u),
+      unit_direction(dx, dy, dz), track_length, tracktype::UNCONTAINED);
+    int num_neutrons = rng.Integer(4u);
+    for (int n = 0; n < num_neutrons; ++n) {
+      mc_particles.emplace_back(2112, rng.Uniform(1., 50.), 0., vertex,
+        vertex, TimeClass(event_time_ns), TimeClass(event_time_ns + 20000u),
+        unit_direction(0., 0., 1.), 0., tracktype::CONTAINED);
+    }
+
+    // Cherenkov light seen by the tank PMTs
+    std::map<ChannelKey, std::vector<Hit> > mc_hits;
+    int num_tank_hits = 40 + rng.Integer(80u);
+    for (int h = 0; h < num_tank_hits; ++h) {
+      add_hit(mc_hits, subdetector::ADC, rng.Integer(NUM_TANK_PMTS),
+        event_time_ns + static_cast<uint64_t>(rng.Uniform(0., 30.)),
+        rng.Gaus(1., 0.3));
+    }
+
+    // Muons that leave through the downstream wall cross the MRD, with one
+    // hit tube in each layer they reach. The ids are above the veto range,
+    // as FindMrdTracks expects.
+    std::map<ChannelKey, std::vector<Hit> > tdc_data;
+    if ( rng.Rndm() < 0.6 ) {
+      int num_layers = 3 + rng.Integer(9u);
+      int column = rng.Integer(MRD_TUBES_PER_LAYER - 6);
+      for (int layer = 0; layer < num_layers; ++layer) {
+        int tube = NUM_VETO_PMTS + layer * MRD_TUBES_PER_LAYER / 2
+          + column + rng.Integer(3u);
+        if ( tube >= NUM_MRD_PMTS ) break;
+        add_hit(tdc_data, subdetector::TDC, tube, event_time_ns + 40u
+          + static_cast<uint64_t>(1.5 * layer + rng.Uniform(0., 2.)), 1.);
+      }
+    }
+    if ( rng.Rndm() < 0.1 ) {
+      add_hit(tdc_data, subdetector::TDC, rng.Integer(NUM_VETO_PMTS),
+        event_time_ns, 1.);
+    }
+
+    std::vector<TriggerClass> trigger_data{ TriggerClass("beam", true,
+      TimeClass(event_time_ns)) };
+    BeamStatusClass beam_status(TimeClass(event_time_ns), 4.3e12, 0.,
+      "stable");
+
+    annie_event.Set("RunNumber", run_number);
+    annie_event.Set("SubrunNumber", subrun_number);
+    annie_event.Set("EventNumber", static_cast<uint64_t>(event));
+    annie_event.Set("MCParticles", mc_particles);
+    annie_event.Set("MCHits", mc_hits);
+    annie_event.Set("TDCData", tdc_data);
+    annie_event.Set("TriggerData", trigger_data);
+    annie_event.Set("EventTime", TimeClass(event_time_ns));
+    annie_event.Set("MCEventNum", static_cast<uint64_t>(event));
+    annie_event.Set("MCTriggernum", static_cast<uint16_t>(0u));
+    annie_event.Set("MCFile", mc_file);
+    annie_event.Set("MCFlag", true);
+    annie_event.Set("BeamStatus", beam_status);
+    annie_event.Save(filename);
+    annie_event.Delete();
+  }
+
+  annie_event.Header->Set("AnnieGeometry", make_geometry());
+  annie_event.Close();
+
+  std::cout << "Wrote " << num_events << " events to " << filename << '\n';
+  return true;
+}
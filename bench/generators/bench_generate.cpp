@@ -0,0 +1,53 @@
+// bench-generate: writes the synthetic input files used by the benchmark
+// chains (see bench/README.md)
+//
+// Usage: bench-generate [--seed N] [--minibuffer-size N] <kind> <output>
+//          <size>
+//
+//   raw <file> <readouts>      raw PMTData (RawLoader)
+//   beamdb <file> <seconds>    beam database (BeamChecker)
+//   wcsim <file> <events>      WCSim-like ANNIEEvent (LoadANNIEEvent)
+//   lappd <filebase> <events>  ACDC text files (LAPPDParseACC)
+//   neutron <file> <events>    toy neutrino events (NeutronStudyReadSandbox)
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Generators.h"
+
+int main(int argc, char* argv[]){
+
+  uint64_t seed=0;
+  int minibuffer_size=40000;
+  std::vector<std::string> args;
+
+  for (int i=1; i<argc; i++){
+    std::string arg=argv[i];
+    if (arg=="--seed" && i+1<argc) seed=std::stoull(argv[++i]);
+    else if (arg=="--minibuffer-size" && i+1<argc)
+      minibuffer_size=std::stoi(argv[++i]);
+    else args.push_back(arg);
+  }
+
+  if (args.size()!=3){
+    std::cerr<<"Usage: "<<argv[0]<<" [--seed N] [--minibuffer-size N]"
+             <<" raw|beamdb|wcsim|lappd|neutron <output> <size>"<<std::endl;
+    return 1;
+  }
+
+  const std::string& kind=args.at(0);
+  const std::string& output=args.at(1);
+  int size=std::stoi(args.at(2));
+
+  bool ok=false;
+  if (kind=="raw") ok=GenerateRawData(output, size, minibuffer_size, seed);
+  else if (kind=="beamdb") ok=GenerateBeamDB(output, size, seed);
+  else if (kind=="wcsim") ok=GenerateWCSimEvents(output, size, seed);
+  else if (kind=="lappd") ok=GenerateLAPPDACDC(output, size, seed);
+  else if (kind=="neutron") ok=GenerateNeutronSandbox(output, size, seed);
+  else std::cerr<<"Error: unknown input kind "<<kind<<std::endl;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,327 @@
+// bench-kernels: times the ADC reconstruction kernels on synthetic
+// waveforms and reports the cost of each in ns per sample (see
+// bench/README.md)
+//
+// Usage: bench-kernels [--samples N,N,...] [--minibuffers N,N,...]
+//          [--occupancy X,X,...] [--min-time SECONDS] [--repetitions N]
+//          [--seed N] [--json FILE]
+//
+// Every combination of the samples per minibuffer, the number of
+// minibuffers per channel and the pulse occupancy (pulses per 1000 samples)
+// is run through each kernel. A kernel is called repeatedly until one
+// repetition takes at least the minimum time, and the median of the
+// repetitions is reported.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ToolAnalysis includes
+#include "ADCCalibrator.h"
+#include "ADCHitFinder.h"
+#include "ANNIEconstants.h"
+#include "RandomStreams.h"
+#include "RawAnalyzer.h"
+#include "RawChannel.h"
+
+namespace {
+
+  // Settings from configfiles/PhaseI
+  const double Q_CRITICAL = 1e-4;
+  const size_t NUM_SUB_MINIBUFFERS = 40u;
+  const size_t NUM_BASELINE_SAMPLES = 25u;
+  const unsigned short RELATIVE_ADC_THRESHOLD = 7u;
+
+  const double BASELINE = 350.; // ADC counts
+  const double BASELINE_NOISE = 1.5;
+
+  // The kernels are protected members of their classes, so expose them
+  // through subclasses
+  class KernelADCCalibrator : public ADCCalibrator {
+    public:
+      KernelADCCalibrator() {
+        q_critical_ = Q_CRITICAL;
+        num_sub_minibuffers_ = NUM_SUB_MINIBUFFERS;
+        num_baseline_samples_ = NUM_BASELINE_SAMPLES;
+      }
+      using ADCCalibrator::ze3ra_baseline;
+      using ADCCalibrator::make_calibrated_waveforms;
+  };
+
+  class KernelADCHitFinder : public ADCHitFinder {
+    public:
+      using ADCHitFinder::find_pulses;
+  };
+
+  class KernelRawAnalyzer : public annie::RawAnalyzer {
+    public:
+      KernelRawAnalyzer() {}
+      using annie::RawAnalyzer::ze3ra_baseline;
+  };
+
+  class KernelRawChannel : public annie::RawChannel {
+    public:
+      KernelRawChannel(
+        const std::vector< std::vector<unsigned short> >& minibuffers)
+      {
+        channel_id_ = 0u;
+        rate_ = 0u;
+        data_ = minibuffers;
+      }
+  };
+
+  struct Case {
+    size_t samples;
+    size_t minibuffers;
+    double occupancy;
+  };
+
+  struct Result {
+    std::string kernel;
+    Case input;
+    double ns_per_sample;
+  };
+
+  // Keeps the compiler from discarding the kernels' results
+  volatile double sink = 0.;
+
+  // Fills one minibuffer with a noisy baseline and Gaussian pulses at the
+  // given mean number of pulses per 1000 samples
+  void make_waveform(CounterRNG& rng, double occupancy,
+    std::vector<unsigned short>& samples)
+  {
+    for (auto& sample : samples) {
+      sample = static_cast<unsigned short>( std::lround(
+        rng.Gaus(BASELINE, BASELINE_NOISE) ) );
+    }
+
+    int num_pulses = static_cast<int>( std::lround(
+      occupancy * samples.size() / 1000.) );
+    for (int p = 0; p < num_pulses; ++p) {
+      double peak = rng.Uniform(0., samples.size());
+      double amplitude = 10. + 200. * rng.Rndm() * rng.Rndm();
+      double width = rng.Uniform(1., 3.);
+      int first = std::max(0, static_cast<int>(peak - 5. * width));
+      int last = std::min(static_cast<int>(samples.size()) - 1,
+        static_cast<int>(peak + 5. * width));
+      for (int s = first; s <= last; ++s) {
+        double x = (s - peak) / width;
+        double value = samples[s] + amplitude * std::exp(-0.5 * x * x);
+        samples[s] = static_cast<unsigned short>( std::min(4095.,
+          std::round(value)) );
+      }
+    }
+  }
+
+  // Returns the median time per sample (ns) of a kernel that processes
+  // num_samples samples per call
+  template<typename Kernel> double measure(Kernel kernel, size_t num_samples,
+    double min_time, int repetitions)
+  {
+    using clock = std::chrono::steady_clock;
+
+    // Find the number of calls that takes at least the minimum time
+    kernel();
+    size_t calls = 1u;
+    while (true) {
+      auto start = clock::now();
+      for (size_t c = 0; c < calls; ++c) kernel();
+      double seconds = std::chrono::duration<double>(
+        clock::now() - start).count();
+      if (seconds >= min_time) break;
+      if (seconds <= 0.) calls *= 10u;
+      else calls = std::max(calls + 1u, static_cast<size_t>(
+        1.2 * calls * min_time / seconds));
+    }
+
+    std::vector<double> times;
+    for (int r = 0; r < repetitions; ++r) {
+      auto start = clock::now();
+      for (size_t c = 0; c < calls; ++c) kernel();
+      double seconds = std::chrono::duration<double>(
+        clock::now() - start).count();
+      times.push_back(1e9 * seconds / (calls * num_samples));
+    }
+
+    std::sort(times.begin(), times.end());
+    return times.at(times.size() / 2);
+  }
+
+  template<typename T> std::vector<T> parse_list(const std::string& list) {
+    std::vector<T> values;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+      std::istringstream item_stream(item);
+      T value;
+      item_stream >> value;
+      values.push_back(value);
+    }
+    return values;
+  }
+
+  void write_json(const std::string& filename,
+    const std::vector<Result>& results)
+  {
+    std::ofstream out(filename);
+    out << "[\n";
+    for (size_t r = 0; r < results.size(); ++r) {
+      const Result& result = results.at(r);
+      out << "  {\"kernel\": \"" << result.kernel << "\", \"samples\": "
+        << result.input.samples << ", \"minibuffers\": "
+        << result.input.minibuffers << ", \"occupancy\": "
+        << result.input.occupancy << ", \"ns_per_sample\": "
+        << result.ns_per_sample << '}'
+        << ( r + 1 < results.size() ? ",\n" : "\n" );
+    }
+    out << "]\n";
+  }
+}
+
+int main(int argc, char* argv[]){
+
+  std::vector<size_t> sample_counts = { 2000u, 10000u, 40000u };
+  std::vector<size_t> minibuffer_counts = { 1u, 8u };
+  std::vector<double> occupancies = { 0., 2., 20. };
+  double min_time = 0.1;
+  int repetitions = 5;
+  uint64_t seed = 0u;
+  std::string json_file;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Error: missing value for " << arg << std::endl;
+      return 1;
+    }
+    if (arg == "--samples") sample_counts = parse_list<size_t>(argv[++i]);
+    else if (arg == "--minibuffers") {
+      minibuffer_counts = parse_list<size_t>(argv[++i]);
+    }
+    else if (arg == "--occupancy") occupancies = parse_list<double>(argv[++i]);
+    else if (arg == "--min-time") min_time = std::stod(argv[++i]);
+    else if (arg == "--repetitions") repetitions = std::stoi(argv[++i]);
+    else if (arg == "--seed") seed = std::stoull(argv[++i]);
+    else if (arg == "--json") json_file = argv[++i];
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--samples N,N,...]"
+        << " [--minibuffers N,N,...] [--occupancy X,X,...]"
+        << " [--min-time SECONDS] [--repetitions N] [--seed N]"
+        << " [--json FILE]" << std::endl;
+      return 1;
+    }
+  }
+
+  RandomStreams::SetSeed(seed);
+
+  KernelADCCalibrator calibrator;
+  KernelADCHitFinder hit_finder;
+  KernelRawAnalyzer raw_analyzer;
+  const ChannelKey channel_key(subdetector::ADC, 0u);
+
+  std::vector<Result> results;
+
+  std::printf("%-40s %8s %4s %9s %12s\n", "kernel", "samples", "mbs",
+    "occupancy", "ns/sample");
+
+  for (size_t samples : sample_counts) {
+    // Without Hefty mode, ze3ra_baseline() splits the start of the
+    // minibuffer into NUM_SUB_MINIBUFFERS pieces
+    if (samples < NUM_SUB_MINIBUFFERS * NUM_BASELINE_SAMPLES) {
+      std::cerr << "Error: minibuffers need at least "
+        << NUM_SUB_MINIBUFFERS * NUM_BASELINE_SAMPLES << " samples"
+        << std::endl;
+      return 1;
+    }
+
+    for (size_t minibuffers : minibuffer_counts) {
+      for (double occupancy : occupancies) {
+
+        Case input = { samples, minibuffers, occupancy };
+        size_t total_samples = samples * minibuffers;
+
+        CounterRNG rng = RandomStreams::Stream(samples, minibuffers,
+          "bench-kernels", std::to_string(occupancy));
+
+        std::vector< std::vector<unsigned short> > minibuffer_data;
+        std::vector< Waveform<unsigned short> > raw_waveforms;
+        for (size_t mb = 0; mb < minibuffers; ++mb) {
+          std::vector<unsigned short> samples_vec(samples);
+          make_waveform(rng, occupancy, samples_vec);
+          minibuffer_data.push_back(samples_vec);
+          raw_waveforms.emplace_back(TimeClass(), samples_vec);
+        }
+        KernelRawChannel raw_channel(minibuffer_data);
+
+        std::vector< CalibratedADCWaveform<double> > calibrated_waveforms
+          = calibrator.make_calibrated_waveforms(raw_waveforms);
+        double baseline = calibrated_waveforms.front().GetBaseline();
+        double sigma_baseline
+          = calibrated_waveforms.front().GetSigmaBaseline();
+        unsigned short adc_threshold = RELATIVE_ADC_THRESHOLD
+          + std::round(baseline);
+
+        // The ze3ra_baseline() kernels only read the start of each
+        // (sub-)minibuffer, but are reported per sample of the channel like
+        // the others so that the costs can be added up
+        auto run = [&](const std::string& kernel, auto function) {
+          double ns_per_sample = measure(function, total_samples, min_time,
+            repetitions);
+          results.push_back( { kernel, input, ns_per_sample } );
+          std::printf("%-40s %8zu %4zu %9g %12.3f\n", kernel.c_str(),
+            samples, minibuffers, occupancy, ns_per_sample);
+        };
+
+        run("ADCCalibrator::ze3ra_baseline", [&]() {
+          double b, s;
+          calibrator.ze3ra_baseline(raw_waveforms, b, s,
+            NUM_BASELINE_SAMPLES);
+          sink = b + s;
+        });
+
+        run("ADCCalibrator::make_calibrated_waveforms", [&]() {
+          sink = calibrator.make_calibrated_waveforms(raw_waveforms)
+            .back().GetBaseline();
+        });
+
+        run("ADCHitFinder::find_pulses", [&]() {
+          size_t num_pulses = 0u;
+          for (size_t mb = 0; mb < minibuffers; ++mb) {
+            num_pulses += hit_finder.find_pulses(raw_waveforms[mb],
+              calibrated_waveforms[mb], adc_threshold, channel_key).size();
+          }
+          sink = num_pulses;
+        });
+
+        run("RawAnalyzer::ze3ra_baseline", [&]() {
+          double b, s;
+          raw_analyzer.ze3ra_baseline(raw_channel, b, s);
+          sink = b + s;
+        });
+
+        run("RawAnalyzer::find_pulses", [&]() {
+          size_t num_pulses = 0u;
+          for (size_t mb = 0; mb < minibuffers; ++mb) {
+            num_pulses += raw_analyzer.find_pulses(minibuffer_data[mb],
+              baseline, sigma_baseline, adc_threshold).size();
+          }
+          sink = num_pulses;
+        });
+      }
+    }
+  }
+
+  if ( !json_file.empty() ) {
+    write_json(json_file, results);
+    std::cout << "Results written to " << json_file << '\n';
+  }
+
+  return 0;
+}
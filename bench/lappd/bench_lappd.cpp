@@ -0,0 +1,205 @@
+// bench-lappd: runs the LAPPD chain on synthetic ACDC data and reports the
+// throughput of each tool and of the whole chain in waveforms per second
+// (see bench/README.md)
+//
+// Usage: bench-lappd [--events N] [--seed N] [--json FILE]
+//
+// The ACDC files are generated with a fixed seed in bench/data/lappd_bench,
+// together with copies of the configuration files in bench/configs/LAPPD
+// that point to them. The chain is run in this process with the tool
+// profiler enabled, and the Execute times of the tools are taken from it.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// ToolAnalysis includes
+#include "Generators.h"
+#include "ThreadPool.h"
+#include "ToolChain.h"
+#include "ToolProfiler.h"
+
+namespace {
+
+  const std::string CONFIG_DIR = "bench/configs/LAPPD";
+  const std::string WORK_DIR = "bench/data/lappd_bench";
+  const std::string FILE_NAME = "lappd_acdc";
+
+  struct Stage {
+    std::string name;
+    uint64_t calls;
+    double seconds;
+  };
+
+  // Copies a configuration file, replacing the values of the given keys
+  bool copy_config(const std::string& input, const std::string& output,
+    const std::map<std::string, std::string>& values)
+  {
+    std::ifstream in(input);
+    std::ofstream out(output);
+    if ( !in.good() || !out.good() ) {
+      std::cerr << "Error: Could not copy " << input << " to " << output
+        << std::endl;
+      return false;
+    }
+
+    std::string line;
+    while ( std::getline(in, line) ) {
+      std::istringstream stream(line);
+      std::string key;
+      stream >> key;
+      auto found = values.find(key);
+      if ( found != values.end() ) out << key << ' ' << found->second << '\n';
+      else out << line << '\n';
+    }
+    return true;
+  }
+
+  // Copies the ToolsConfig file, pointing every tool to the given
+  // configuration file
+  bool copy_tools_config(const std::string& input, const std::string& output,
+    const std::string& tool_config)
+  {
+    std::ifstream in(input);
+    std::ofstream out(output);
+    if ( !in.good() || !out.good() ) {
+      std::cerr << "Error: Could not copy " << input << " to " << output
+        << std::endl;
+      return false;
+    }
+
+    std::string line;
+    while ( std::getline(in, line) ) {
+      std::istringstream stream(line);
+      std::string name, tool_class;
+      if ( !(stream >> name >> tool_class) || name.at(0) == '#' ) {
+        out << line << '\n';
+        continue;
+      }
+      out << name << ' ' << tool_class << ' ' << tool_config << '\n';
+    }
+    return true;
+  }
+
+  void print_stage(const Stage& stage, int events, int waveforms) {
+    std::printf("%-24s %8llu %10.1f %12.1f %14.0f\n", stage.name.c_str(),
+      static_cast<unsigned long long>(stage.calls), 1e3 * stage.seconds,
+      1e6 * stage.seconds / events, waveforms / stage.seconds);
+  }
+
+  void write_json(const std::string& filename,
+    const std::vector<Stage>& stages, int events, int waveforms)
+  {
+    std::ofstream out(filename);
+    out << "[\n";
+    for (size_t s = 0; s < stages.size(); ++s) {
+      const Stage& stage = stages.at(s);
+      out << "  {\"stage\": \"" << stage.name << "\", \"events\": " << events
+        << ", \"waveforms\": " << waveforms << ", \"seconds\": "
+        << stage.seconds << ", \"waveforms_per_s\": "
+        << waveforms / stage.seconds << '}'
+        << ( s + 1 < stages.size() ? ",\n" : "\n" );
+    }
+    out << "]\n";
+  }
+}
+
+int main(int argc, char* argv[]){
+
+  int events = 500;
+  uint64_t seed = 20170402u;
+  std::string json_file;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--events" && i + 1 < argc) events = std::stoi(argv[++i]);
+    else if (arg == "--seed" && i + 1 < argc) seed = std::stoull(argv[++i]);
+    else if (arg == "--json" && i + 1 < argc) json_file = argv[++i];
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--events N] [--seed N]"
+        << " [--json FILE]" << std::endl;
+      return 1;
+    }
+  }
+  if (events < 1) {
+    std::cerr << "Error: at least one event is needed" << std::endl;
+    return 1;
+  }
+
+  mkdir("bench/data", 0755);
+  mkdir(WORK_DIR.c_str(), 0755);
+
+  if ( !GenerateLAPPDACDC(WORK_DIR + '/' + FILE_NAME, events, seed) ) {
+    return 1;
+  }
+
+  std::string tool_config = WORK_DIR + "/ConfigVarsACDC";
+  std::string tools_file = WORK_DIR + "/ToolsConfig";
+  std::string chain_config = WORK_DIR + "/ToolChainConfig";
+
+  bool copied = copy_config(CONFIG_DIR + "/ConfigVarsACDC", tool_config,
+      { { "filepath", WORK_DIR }, { "filename", FILE_NAME } })
+    && copy_tools_config(CONFIG_DIR + "/ToolsConfig", tools_file,
+      tool_config)
+    && copy_config(CONFIG_DIR + "/ToolChainConfig", chain_config,
+      { { "Tools_File", tools_file }, { "Inline", std::to_string(events) },
+        { "ToolProfile", "1" }, { "ToolPerfCounters", "0" },
+        { "TraceBufferSize", "0" } });
+  if ( !copied ) return 1;
+
+  // Set up the process as main() does for this configuration
+  ThreadPool::SetDefaultSize(1u);
+  ToolProfiler::Shared().Configure(true, "");
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    ToolChain tools(chain_config);
+  }
+  double run_seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  int waveforms = events * ACDC_NUM_CHANNELS;
+
+  // The tools are listed in the order in which they were finalised, which
+  // is the order of the chain
+  std::vector<Stage> stages;
+  Stage chain = { "Chain (Execute)", static_cast<uint64_t>(events), 0. };
+  bool complete = true;
+  for (const auto& tool : ToolProfiler::Shared().Tools()) {
+    const LatencyHistogram& execute = tool.phases[ToolProfiler::EXECUTE];
+    stages.push_back( { tool.tool_class, execute.count(),
+      1e-9 * execute.total_ns() } );
+    chain.seconds += stages.back().seconds;
+    if ( execute.count() != static_cast<uint64_t>(events) ) complete = false;
+  }
+  stages.push_back(chain);
+  stages.push_back( { "Whole run", static_cast<uint64_t>(events),
+    run_seconds } );
+
+  std::printf("\n%d events, %d waveforms\n", events, waveforms);
+  std::printf("%-24s %8s %10s %12s %14s\n", "Stage", "Calls", "Total (ms)",
+    "us/event", "waveforms/s");
+  for (const auto& stage : stages) print_stage(stage, events, waveforms);
+
+  if ( !complete ) {
+    std::cerr << "Error: not every tool processed " << events << " events"
+      << std::endl;
+    return 1;
+  }
+
+  if ( !json_file.empty() ) {
+    write_json(json_file, stages, events, waveforms);
+    std::cout << "Results written to " << json_file << '\n';
+  }
+
+  return 0;
+}
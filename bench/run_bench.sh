@@ -0,0 +1,91 @@
+#!/bin/bash
+#
+# Runs the benchmark chains on synthetic data and reports the throughput
+# and peak memory use of each (see bench/README.md). Run through
+# "make bench" or "make bench-chains", or directly from the top of the
+# repository after building Analyse, bench/bench-generate and
+# bench/bench-run.
+#
+# Usage: bench/run_bench.sh [chain ...]   (default: all chains)
+
+cd "$(dirname "$0")/.." || exit 1
+
+# The event counts and seeds are fixed so that results can be compared
+# across commits. The Inline values in the LAPPD and Neutron
+# ToolChainConfig files must match.
+PHASEI_READOUTS=40
+MRD_EVENTS=5000
+LAPPD_EVENTS=500
+NEUTRON_EVENTS=200000
+SEED=20170402
+
+RESULTS=${BENCH_RESULTS:-bench/results.json}
+DATA=bench/data
+
+for program in ./Analyse bench/bench-generate bench/bench-run; do
+  if [ ! -x $program ]; then
+    echo "Error: $program has not been built (run \"make bench\")" >&2
+    exit 1
+  fi
+done
+
+mkdir -p $DATA/output
+
+# Regenerates an input file when it is missing or older than the generator
+generate() {
+  local file=$1
+  shift
+  if [ ! -e $file ] || [ bench/bench-generate -nt $file ]; then
+    rm -f $file
+    bench/bench-generate --seed $SEED "$@" || exit 1
+  fi
+}
+
+generate $DATA/phaseI_raw.root raw $DATA/phaseI_raw.root $PHASEI_READOUTS
+generate $DATA/beam_db.data beamdb $DATA/beam_db.data $PHASEI_READOUTS
+generate $DATA/wcsim_events.data wcsim $DATA/wcsim_events.data $MRD_EVENTS
+generate $DATA/lappd_acdc.acdc lappd $DATA/lappd_acdc $LAPPD_EVENTS
+generate $DATA/neutron_sandbox.root neutron $DATA/neutron_sandbox.root \
+  $NEUTRON_EVENTS
+
+declare -A EVENTS=( [PhaseI]=$PHASEI_READOUTS [MRD]=$MRD_EVENTS
+  [LAPPD]=$LAPPD_EVENTS [Neutron]=$NEUTRON_EVENTS )
+
+CHAINS="$@"
+if [ -z "$CHAINS" ]; then CHAINS="PhaseI MRD LAPPD Neutron"; fi
+
+status=0
+results=()
+for chain in $CHAINS; do
+  if [ -z "${EVENTS[$chain]}" ]; then
+    echo "Error: unknown chain $chain" >&2
+    exit 1
+  fi
+  echo "Running the $chain chain" >&2
+  # Tracks found by FindMrdTracks go into a new file for each run
+  rm -f $DATA/output/*
+  result=$(bench/bench-run $chain ${EVENTS[$chain]} ./Analyse \
+    bench/configs/$chain/ToolChainConfig) || status=1
+  results+=("$result")
+done
+
+# Collect the results into a JSON array
+{
+  echo "["
+  for ((i = 0; i < ${#results[@]}; i++)); do
+    separator=","
+    if [ $i -eq $((${#results[@]} - 1)) ]; then separator=""; fi
+    echo "  ${results[$i]}$separator"
+  done
+  echo "]"
+} > $RESULTS
+
+echo
+printf "%-10s %10s %12s %14s %8s\n" chain events events/s "peak RSS (MB)" ok
+for result in "${results[@]}"; do
+  echo "$result" | sed -E 's/.*"chain": "([^"]*)", "events": ([0-9]+),.*"events_per_s": ([0-9.]+), "peak_rss_kb": ([0-9]+), "ok": ([a-z]+).*/\1 \2 \3 \4 \5/' \
+    | awk '{ printf "%-10s %10d %12.1f %14.1f %8s\n", $1, $2, $3, $4 / 1024., $5 }'
+done
+echo "Results written to $RESULTS"
+
+exit $status
@@ -0,0 +1,452 @@
+// bench-store: measures how fast typical ANNIEEvent keys are serialized and
+// deserialized, how many bytes they take and how many heap allocations
+// the round trips make (see bench/README.md)
+//
+// Usage: bench-store [--events N] [--samples N] [--seed N] [--json FILE]
+//
+// Each key is filled with a synthetic payload of a realistic size for every
+// event and taken through each mode:
+//
+//   memory   Set() into and Get() from a BoostStore, which holds the binary
+//            archive of the object
+//   file     Set(), Save() and Delete() into a multi-event BoostStore file,
+//            then GetEntry() and Get() from it, as done by the tools that
+//            write and read ANNIEEvent files
+//   gzip-N   the binary archive alone, compressed and decompressed with gzip
+//            at level N (1 = fastest, 6 = the zlib default), to compare
+//            the compression settings
+//
+// The payloads are built outside of the timed calls. The throughput is in
+// MB (10^6 bytes) of binary archive per second, so that the modes can be
+// compared for the same data.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+// Boost includes
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+// ToolAnalysis includes
+#include "ANNIEconstants.h"
+#include "ANNIEEventKeys.h"
+#include "AllocationTracker.h"
+#include "BoostStore.h"
+#include "RandomStreams.h"
+
+namespace {
+
+  const std::string WORK_DIR = "bench/data/store_bench";
+
+  // Sizes of the Phase I and LAPPD data (see bench/generators)
+  const int NUM_ADC_CHANNELS = 64;
+  const int NUM_TANK_PMTS = 128;
+  const int NUM_LAPPD_CHANNELS = 30;
+  const int NUM_LAPPD_CELLS = 256;
+
+  typedef std::map<ChannelKey, std::vector< Waveform<unsigned short> > >
+    RawADCMap;
+  typedef std::map<ChannelKey, std::vector< CalibratedADCWaveform<double> > >
+    CalibratedADCMap;
+  typedef std::map<ChannelKey, std::vector<Hit> > HitMap;
+  typedef std::map<int, std::vector< Waveform<double> > > LAPPDWaveformMap;
+
+  struct Result {
+    std::string key;
+    std::string mode;
+    int events;
+    double archive_bytes; // per event
+    double stored_bytes; // per event
+    double write_seconds;
+    double read_seconds;
+    double allocations; // per event, write and read
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+  inline double seconds_since(const Clock::time_point& start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  // Payload builders. Each event gets its own random stream, so the
+  // payloads do not repeat from one event to the next.
+
+  RawADCMap make_raw_adc(CounterRNG& rng, int samples) {
+    RawADCMap raw;
+    for (int ch = 0; ch < NUM_ADC_CHANNELS; ++ch) {
+      double baseline = rng.Gaus(350., 5.);
+      std::vector<unsigned short> data(samples);
+      for (auto& sample : data) {
+        sample = static_cast<unsigned short>( std::lround(
+          rng.Gaus(baseline, 1.5) ) );
+      }
+      for (int p = 0; p < 4; ++p) {
+        int peak = rng.Integer(samples - 10);
+        for (int s = 0; s < 10; ++s) data[peak + s] += 100 / (1 + s);
+      }
+      raw[ChannelKey(subdetector::ADC, ch)].emplace_back(TimeClass(), data);
+    }
+    return raw;
+  }
+
+  CalibratedADCMap make_calibrated_adc(CounterRNG& rng, int samples) {
+    CalibratedADCMap calibrated;
+    for (const auto& pair : make_raw_adc(rng, samples)) {
+      const auto& raw = pair.second.front().Samples();
+      double baseline = raw.front();
+      std::vector<double> data;
+      data.reserve( raw.size() );
+      for (unsigned short sample : raw) {
+        data.push_back( (sample - baseline) * ADC_TO_VOLT );
+      }
+      calibrated[pair.first].emplace_back(TimeClass(), data, baseline, 1.5);
+    }
+    return calibrated;
+  }
+
+  PackedADCHits::PulseMap make_adc_hits(CounterRNG& rng) {
+    PackedADCHits::PulseMap hits;
+    for (int ch = 0; ch < NUM_ADC_CHANNELS; ++ch) {
+      std::vector<ADCPulse> pulses;
+      int num_pulses = rng.Integer(8u);
+      for (int p = 0; p < num_pulses; ++p) {
+        unsigned long long start = rng.Integer(40000u) * NS_PER_ADC_SAMPLE;
+        pulses.emplace_back(ch, TimeClass(start), TimeClass(start + 4),
+          350., 1.5, 3000u + rng.Integer(5000u), 350u + rng.Integer(400u),
+          rng.Uniform(0., 0.2), rng.Uniform(0., 0.05));
+      }
+      hits[ChannelKey(subdetector::ADC, ch)].push_back(pulses);
+    }
+    return hits;
+  }
+
+  std::vector<Particle> make_mc_particles(CounterRNG& rng) {
+    std::vector<Particle> particles;
+    Position vertex(rng.Uniform(-100., 100.), rng.Uniform(-100., 100.),
+      rng.Uniform(-100., 100.));
+    particles.emplace_back(13, rng.Uniform(200., 2000.), 0., vertex,
+      Position(0., 0., 300.), TimeClass(0u), TimeClass(10u),
+      Direction(0., 0.5), 300., tracktype::UNCONTAINED);
+    int num_neutrons = rng.Integer(4u);
+    for (int n = 0; n < num_neutrons; ++n) {
+      particles.emplace_back(2112, rng.Uniform(1., 50.), 0., vertex, vertex,
+        TimeClass(0u), TimeClass(20000u), Direction(0., 1.), 0.,
+        tracktype::CONTAINED);
+    }
+    return particles;
+  }
+
+  HitMap make_mc_hits(CounterRNG& rng) {
+    HitMap hits;
+    int num_hits = 40 + rng.Integer(80u);
+    for (int h = 0; h < num_hits; ++h) {
+      int tube = rng.Integer(NUM_TANK_PMTS);
+      hits[ChannelKey(subdetector::ADC, tube)].emplace_back(tube,
+        TimeClass( static_cast<unsigned long long>(rng.Uniform(0., 50.)) ),
+        rng.Uniform(0.5, 5.));
+    }
+    return hits;
+  }
+
+  LAPPDWaveformMap make_lappd_waveforms(CounterRNG& rng) {
+    LAPPDWaveformMap waveforms;
+    double pulse_time = rng.Uniform(60., 200.);
+    for (int ch = 0; ch < NUM_LAPPD_CHANNELS; ++ch) {
+      std::vector<double> data(NUM_LAPPD_CELLS);
+      for (int cell = 0; cell < NUM_LAPPD_CELLS; ++cell) {
+        double x = (cell - pulse_time) / 2.5;
+        data[cell] = rng.Gaus(0., 3.) + 4. * std::sin(0.055 * cell)
+          - 100. * std::exp(-0.5 * x * x);
+      }
+      Waveform<double> waveform;
+      waveform.SetSamples(data);
+      waveforms[ch].push_back(waveform);
+    }
+    return waveforms;
+  }
+
+  template<typename T> std::string to_archive(const T& object) {
+    std::ostringstream stream;
+    boost::archive::binary_oarchive oa(stream);
+    oa & object;
+    return stream.str();
+  }
+
+  template<typename T> void from_archive(const std::string& archive,
+    T& object)
+  {
+    std::istringstream stream(archive);
+    boost::archive::binary_iarchive ia(stream);
+    ia & object;
+  }
+
+  std::string gzip(const std::string& data, int level) {
+    std::ostringstream compressed;
+    {
+      boost::iostreams::filtering_ostream out;
+      out.push( boost::iostreams::gzip_compressor(
+        boost::iostreams::gzip_params(level) ) );
+      out.push(compressed);
+      out.write(data.data(), data.size());
+    }
+    return compressed.str();
+  }
+
+  std::string gunzip(const std::string& data) {
+    std::istringstream compressed(data);
+    std::ostringstream decompressed;
+    boost::iostreams::filtering_istream in;
+    in.push( boost::iostreams::gzip_decompressor() );
+    in.push(compressed);
+    boost::iostreams::copy(in, decompressed);
+    return decompressed.str();
+  }
+
+  // Counts the heap allocations made by this thread for one mode of one
+  // key until the end of the scope
+  class CountAllocations {
+    public:
+      CountAllocations(const std::string& key)
+        : key_(key), slot_( AllocationTracker::RegisterTool(key) ),
+        scope_(slot_, AllocationTracker::EXECUTE_PHASE) {}
+
+      static double per_event(const std::string& key, int events) {
+        AllocationStats stats;
+        if ( !AllocationTracker::Get(key, stats) ) return 0.;
+        return static_cast<double>(stats.execute_allocations) / events;
+      }
+
+    protected:
+      std::string key_;
+      int slot_;
+      AllocationScope scope_;
+  };
+
+  template<typename T> void measure_key(const std::string& key,
+    std::function<T(CounterRNG&)> build, int events,
+    std::vector<Result>& results)
+  {
+    auto payload = [&](int event) {
+      CounterRNG rng = RandomStreams::Stream(0u, event, "bench-store", key);
+      return build(rng);
+    };
+
+    double archive_bytes = 0.;
+    for (int event = 0; event < events; ++event) {
+      archive_bytes += to_archive( payload(event) ).size();
+    }
+    archive_bytes /= events;
+
+    // In-memory BoostStore
+    {
+      Result result = { key, "memory", events, archive_bytes, archive_bytes,
+        0., 0., 0. };
+      std::string allocation_key = "bench-store|" + key + "|memory";
+      for (int event = 0; event < events; ++event) {
+        T object = payload(event);
+        T copy;
+        BoostStore store(false, 0);
+        CountAllocations count(allocation_key);
+        auto start = Clock::now();
+        store.Set(key, object);
+        result.write_seconds += seconds_since(start);
+        start = Clock::now();
+        store.Get(key, copy);
+        result.read_seconds += seconds_since(start);
+      }
+      result.allocations = CountAllocations::per_event(allocation_key,
+        events);
+      results.push_back(result);
+    }
+
+    // Multi-event BoostStore file
+    {
+      Result result = { key, "file", events, archive_bytes, 0., 0., 0., 0. };
+      std::string allocation_key = "bench-store|" + key + "|file";
+      std::string filename = WORK_DIR + '/' + key + ".data";
+      std::remove( filename.c_str() );
+
+      {
+        BoostStore store(false, BOOST_STORE_MULTIEVENT_FORMAT);
+        for (int event = 0; event < events; ++event) {
+          T object = payload(event);
+          CountAllocations count(allocation_key);
+          auto start = Clock::now();
+          store.Set(key, object);
+          store.Save(filename);
+          store.Delete();
+          result.write_seconds += seconds_since(start);
+        }
+        CountAllocations count(allocation_key);
+        auto start = Clock::now();
+        store.Close();
+        result.write_seconds += seconds_since(start);
+      }
+
+      struct stat file_stat;
+      if ( stat(filename.c_str(), &file_stat) == 0 ) {
+        result.stored_bytes = static_cast<double>(file_stat.st_size)
+          / events;
+      }
+
+      {
+        BoostStore store(false, BOOST_STORE_MULTIEVENT_FORMAT);
+        {
+          CountAllocations count(allocation_key);
+          auto start = Clock::now();
+          store.Initialise(filename);
+          result.read_seconds += seconds_since(start);
+        }
+        size_t total_entries = 0u;
+        store.Header->Get("TotalEntries", total_entries);
+        if ( total_entries != static_cast<size_t>(events) ) {
+          std::cerr << "Warning: " << filename << " has " << total_entries
+            << " entries instead of " << events << '\n';
+        }
+        for (size_t entry = 0; entry < total_entries; ++entry) {
+          T copy;
+          CountAllocations count(allocation_key);
+          auto start = Clock::now();
+          store.GetEntry(entry);
+          store.Get(key, copy);
+          result.read_seconds += seconds_since(start);
+        }
+      }
+      result.allocations = CountAllocations::per_event(allocation_key,
+        events);
+      results.push_back(result);
+    }
+
+    // The binary archive alone, at the fastest and the default gzip
+    // compression levels (level 9 is too slow for the large keys)
+    for (int level : { 1, 6 }) {
+      std::string mode = "gzip-" + std::to_string(level);
+      Result result = { key, mode, events, archive_bytes, 0., 0., 0., 0. };
+      std::string allocation_key = "bench-store|" + key + '|' + mode;
+      for (int event = 0; event < events; ++event) {
+        T object = payload(event);
+        T copy;
+        CountAllocations count(allocation_key);
+        auto start = Clock::now();
+        std::string compressed = gzip(to_archive(object), level);
+        result.write_seconds += seconds_since(start);
+        result.stored_bytes += compressed.size();
+        start = Clock::now();
+        from_archive(gunzip(compressed), copy);
+        result.read_seconds += seconds_since(start);
+      }
+      result.stored_bytes /= events;
+      result.allocations = CountAllocations::per_event(allocation_key,
+        events);
+      results.push_back(result);
+    }
+  }
+
+  inline double mb_per_s(const Result& result, double seconds) {
+    return (seconds > 0.) ? 1e-6 * result.archive_bytes * result.events
+      / seconds : 0.;
+  }
+
+  void write_json(const std::string& filename,
+    const std::vector<Result>& results)
+  {
+    std::ofstream out(filename);
+    out << "[\n";
+    for (size_t r = 0; r < results.size(); ++r) {
+      const Result& result = results.at(r);
+      out << "  {\"key\": \"" << result.key << "\", \"mode\": \""
+        << result.mode << "\", \"events\": " << result.events
+        << ", \"archive_bytes_per_event\": " << result.archive_bytes
+        << ", \"bytes_per_event\": " << result.stored_bytes
+        << ", \"write_mb_per_s\": "
+        << mb_per_s(result, result.write_seconds)
+        << ", \"read_mb_per_s\": " << mb_per_s(result, result.read_seconds)
+        << ", \"allocations_per_event\": " << result.allocations << '}'
+        << ( r + 1 < results.size() ? ",\n" : "\n" );
+    }
+    out << "]\n";
+  }
+}
+
+int main(int argc, char* argv[]){
+
+  int events = 10;
+  int samples = 40000;
+  uint64_t seed = 20170402u;
+  std::string json_file;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--events" && i + 1 < argc) events = std::stoi(argv[++i]);
+    else if (arg == "--samples" && i + 1 < argc) {
+      samples = std::stoi(argv[++i]);
+    }
+    else if (arg == "--seed" && i + 1 < argc) seed = std::stoull(argv[++i]);
+    else if (arg == "--json" && i + 1 < argc) json_file = argv[++i];
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--events N] [--samples N]"
+        << " [--seed N] [--json FILE]" << std::endl;
+      return 1;
+    }
+  }
+  if (events < 1 || samples < 10) {
+    std::cerr << "Error: at least 1 event and 10 samples are needed"
+      << std::endl;
+    return 1;
+  }
+
+  mkdir("bench/data", 0755);
+  mkdir(WORK_DIR.c_str(), 0755);
+
+  RandomStreams::SetSeed(seed);
+
+  std::vector<Result> results;
+
+  measure_key<RawADCMap>("RawADCData",
+    [samples](CounterRNG& rng) { return make_raw_adc(rng, samples); },
+    events, results);
+  measure_key<CalibratedADCMap>("CalibratedADCData",
+    [samples](CounterRNG& rng) { return make_calibrated_adc(rng, samples); },
+    events, results);
+  measure_key<PackedADCHits::PulseMap>("RecoADCHits", make_adc_hits, events,
+    results);
+  measure_key< std::vector<Particle> >("MCParticles", make_mc_particles,
+    events, results);
+  measure_key<HitMap>("MCHits", make_mc_hits, events, results);
+  measure_key<LAPPDWaveformMap>("RawLAPPDData", make_lappd_waveforms, events,
+    results);
+
+  std::printf("%-18s %-7s %13s %13s %10s %10s %12s\n", "Key", "Mode",
+    "Archive B/ev", "Stored B/ev", "Write MB/s", "Read MB/s", "Allocs/ev");
+  for (const auto& result : results) {
+    std::printf("%-18s %-7s %13.0f %13.0f %10.1f %10.1f %12.1f\n",
+      result.key.c_str(), result.mode.c_str(), result.archive_bytes,
+      result.stored_bytes, mb_per_s(result, result.write_seconds),
+      mb_per_s(result, result.read_seconds), result.allocations);
+  }
+  if ( !AllocationTracker::enabled() ) {
+    std::cout << "(allocations are not counted: the allocation hooks are"
+      " not linked in)\n";
+  }
+
+  if ( !json_file.empty() ) {
+    write_json(json_file, results);
+    std::cout << "Results written to " << json_file << '\n';
+  }
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+// Replacement global operator new and operator delete that count each
+// allocation for the tool running on the calling thread (see
+// DataModel/AllocationTracker.h). Linked into Analyse by
+// "make ALLOCATION_TRACKING=1".
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "AllocationTracker.h"
+
+namespace {
+
+  // Each block starts with a header holding its size and the tool slot it
+  // was counted for. The header is 16 bytes so that the memory returned to
+  // the caller keeps malloc's alignment.
+  struct alignas(16) BlockHeader {
+    uint64_t size;
+    uint32_t slot;
+    uint32_t magic;
+  };
+
+  const uint32_t BLOCK_MAGIC = 0xA110CA7Eu;
+
+  void* allocate(std::size_t size, bool nothrow) {
+    // Adding the header must not wrap the size around to a small block
+    if ( size > SIZE_MAX - sizeof(BlockHeader) ) {
+      if (nothrow) return nullptr;
+      throw std::bad_alloc();
+    }
+    while (true) {
+      void* block = std::malloc(sizeof(BlockHeader) + size);
+      if (block) {
+        BlockHeader* header = static_cast<BlockHeader*>(block);
+        header->size = size;
+        header->slot = AllocationTracker::Allocated(size);
+        header->magic = BLOCK_MAGIC;
+        return header + 1;
+      }
+      std::new_handler handler = std::get_new_handler();
+      if (!handler) {
+        if (nothrow) return nullptr;
+        throw std::bad_alloc();
+      }
+      handler();
+    }
+  }
+
+  void deallocate(void* pointer) {
+    if (!pointer) return;
+    BlockHeader* header = static_cast<BlockHeader*>(pointer) - 1;
+    // Every block given to these operators was made by allocate(), so a
+    // wrong magic number means that the block was already deleted or that
+    // the heap is corrupt. Freeing it would only corrupt the heap further.
+    if ( header->magic != BLOCK_MAGIC ) {
+      std::fputs("Error: operator delete was given a block that is not"
+        " allocated (deleted twice, or a corrupt heap)\n", stderr);
+      std::abort();
+    }
+    header->magic = 0u;
+    AllocationTracker::Freed(header->slot, header->size);
+    std::free(header);
+  }
+
+  struct InstallHooks {
+    InstallHooks() { AllocationTracker::InstallHooks(); }
+  } install_hooks;
+}
+
+void* operator new(std::size_t size) { return allocate(size, false); }
+void* operator new[](std::size_t size) { return allocate(size, false); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try { return allocate(size, true); }
+  catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  try { return allocate(size, true); }
+  catch (...) { return nullptr; }
+}
+
+void operator delete(void* pointer) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { deallocate(pointer); }
+
+void operator delete(void* pointer, std::size_t) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+  deallocate(pointer);
+}
@@ -0,0 +1,281 @@
+// Sharding mode for the Analyse executable ("Analyse --shards N config")
+//
+// The parent process forks N workers. Worker k calls Sharding::Configure()
+// and then runs the whole ToolChain, so that loader tools read only the k-th
+// slice of their input and output tools write ".shardK" files listed in the
+// worker's manifest (see DataModel/Sharding.h). A worker exits with an error
+// if any of its tools failed. Once every worker has exited successfully, the
+// parent merges the shard outputs in shard order: ANNIEEvent BoostStore
+// files with ANNIEEventMerger, which copies every entry as it is, and ROOT
+// files (trees and histograms) with TFileMerger. The rows of summary trees
+// are then combined by key (see Sharding::AddSummaryTree()). If any worker
+// fails, nothing is merged and the shard outputs are left in place.
+//
+// This file is only included by main.cpp.
+#pragma once
+
+// standard library includes
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// POSIX includes
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ROOT includes
+#include "TFile.h"
+#include "TFileMerger.h"
+#include "TLeaf.h"
+#include "TObjArray.h"
+#include "TTree.h"
+
+// ToolAnalysis includes
+#include "ANNIEEventMerger.h"
+#include "Sharding.h"
+
+inline bool shard_file_exists(const std::string& filename){
+  std::ifstream file(filename);
+  return file.good();
+}
+
+// Replace the rows of a summary tree in a merged ROOT file by one row for
+// each value of its key branch, adding up the other branches of the rows
+// with that key. Every branch must hold a single number.
+inline bool combine_summary_tree(const std::string& filename,
+  const std::string& tree_name, const std::string& key_branch){
+
+  std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "UPDATE"));
+  if (!file || file->IsZombie()) return false;
+  TTree* tree=nullptr;
+  file->GetObject(tree_name.c_str(), tree);
+  if (!tree) return true; // no shard wrote it
+
+  // Each value is kept in the member of the union that matches its type,
+  // so that the union can be given to the new tree as the branch address
+  union Value { Int_t I; UInt_t i; Long64_t L; ULong64_t l; Float_t F; Double_t D; };
+  struct Column { std::string name; char type; TLeaf* leaf; };
+  const std::map<std::string, char> type_codes={ {"Int_t",'I'},
+    {"UInt_t",'i'}, {"Long64_t",'L'}, {"ULong64_t",'l'}, {"Float_t",'F'},
+    {"Double_t",'D'} };
+
+  std::vector<Column> columns;
+  int key_column=-1;
+  TObjArray* leaves=tree->GetListOfLeaves();
+  for (int c=0; c<leaves->GetEntriesFast(); c++){
+    TLeaf* leaf=static_cast<TLeaf*>(leaves->At(c));
+    auto code=type_codes.find(leaf->GetTypeName());
+    if (code==type_codes.end() || leaf->GetLenStatic()!=1 || leaf->GetLeafCount()){
+      std::cerr<<"Error: the branch "<<leaf->GetName()<<" of the summary tree "
+        <<tree_name<<" does not hold a single number"<<std::endl;
+      return false;
+    }
+    if (leaf->GetName()==key_branch) key_column=columns.size();
+    columns.push_back({leaf->GetName(), code->second, leaf});
+  }
+  if (key_column<0 || columns.at(key_column).type=='F' || columns.at(key_column).type=='D'){
+    std::cerr<<"Error: the summary tree "<<tree_name<<" has no integer branch "
+      <<key_branch<<std::endl;
+    return false;
+  }
+
+  // Totals for each key, in the order in which the keys first appear
+  std::vector< std::vector<Value> > rows;
+  std::map<Long64_t, size_t> row_indices;
+  for (Long64_t e=0; e<tree->GetEntries(); e++){
+    tree->GetEntry(e);
+    Long64_t key=columns.at(key_column).leaf->GetValueLong64();
+    auto found=row_indices.find(key);
+    bool new_row=(found==row_indices.end());
+    if (new_row){
+      row_indices[key]=rows.size();
+      rows.emplace_back(columns.size(), Value());
+    }
+    std::vector<Value>& row=rows.at(new_row ? rows.size()-1 : found->second);
+    for (size_t c=0; c<columns.size(); c++){
+      const Column& column=columns.at(c);
+      bool add=(static_cast<int>(c)!=key_column || new_row);
+      if (!add) continue;
+      Value& value=row.at(c);
+      switch (column.type){
+        case 'I': value.I+=column.leaf->GetValueLong64(); break;
+        case 'i': value.i+=column.leaf->GetValueLong64(); break;
+        case 'L': value.L+=column.leaf->GetValueLong64(); break;
+        case 'l': value.l+=column.leaf->GetValueLong64(); break;
+        case 'F': value.F+=column.leaf->GetValue(); break;
+        default: value.D+=column.leaf->GetValue(); break;
+      }
+    }
+  }
+
+  std::string title=tree->GetTitle();
+  file->cd();
+  file->Delete((tree_name+";*").c_str());
+
+  TTree* combined=new TTree(tree_name.c_str(), title.c_str());
+  std::vector<Value> buffer(columns.size());
+  for (size_t c=0; c<columns.size(); c++){
+    const Column& column=columns.at(c);
+    combined->Branch(column.name.c_str(), &buffer.at(c),
+      (column.name+'/'+column.type).c_str());
+  }
+  for (const auto& row : rows){
+    buffer=row;
+    combined->Fill();
+  }
+  bool ok=(combined->Write()>0 || rows.empty());
+  file->Close();
+  return ok;
+}
+
+// Merge the files listed in the shard manifests, removing the shard files
+// once they have been merged
+inline bool merge_shard_outputs(const std::string& manifest_dir,
+  size_t num_shards){
+
+  // Shard files for each merged output, in shard order
+  std::vector<std::string> final_paths;
+  std::map<std::string, std::vector<Sharding::ManifestEntry> > shard_files;
+  // Summary trees in each merged output, each listed once
+  std::map<std::string, std::set< std::pair<std::string, std::string> > > summary_trees;
+
+  for (size_t k=0; k<num_shards; k++){
+    std::vector<Sharding::ManifestEntry> entries;
+    std::vector<Sharding::SummaryTree> trees;
+    if (!Sharding::ReadManifest(Sharding::ManifestPath(manifest_dir,k),
+      entries, trees)){
+      std::cerr<<"Error: could not read the manifest for shard "<<k<<std::endl;
+      return false;
+    }
+    for (const auto& entry : entries){
+      if (!shard_files.count(entry.final_path)) final_paths.push_back(entry.final_path);
+      shard_files[entry.final_path].push_back(entry);
+    }
+    for (const auto& tree : trees){
+      summary_trees[tree.final_path].insert(std::make_pair(tree.tree_name, tree.key_branch));
+    }
+  }
+
+  bool ok=true;
+  for (const auto& final_path : final_paths){
+
+    std::vector<std::string> inputs;
+    for (const auto& entry : shard_files.at(final_path)){
+      // A shard with no events may not have written anything
+      if (shard_file_exists(entry.shard_path)) inputs.push_back(entry.shard_path);
+    }
+    if (inputs.empty()) continue;
+
+    std::cout<<"Merging "<<inputs.size()<<" shard outputs into "<<final_path<<std::endl;
+
+    bool merged=true;
+    if (shard_files.at(final_path).front().type==Sharding::OutputType::BoostStore){
+      std::remove(final_path.c_str());
+      ANNIEEventMerger merger(final_path, false);
+      for (const auto& input : inputs){
+        std::string error;
+        if (!merger.AddFile(input, error)){
+          std::cerr<<"Error: could not merge "<<input<<": "<<error<<std::endl;
+          merged=false;
+          break;
+        }
+      }
+      merger.Close();
+    }
+    else {
+      TFileMerger merger(false);
+      merged=merger.OutputFile(final_path.c_str(), "RECREATE");
+      for (const auto& input : inputs){
+        if (merged) merged=merger.AddFile(input.c_str());
+      }
+      if (merged) merged=merger.Merge();
+      if (!merged) std::cerr<<"Error: could not merge the ROOT files for "<<final_path<<std::endl;
+    }
+
+    // TFileMerger concatenates the trees (and has closed the merged file by
+    // now), so add up the rows of the summary trees that have the same key
+    if (merged && summary_trees.count(final_path)){
+      for (const auto& tree : summary_trees.at(final_path)){
+        if (!combine_summary_tree(final_path, tree.first, tree.second)){
+          std::cerr<<"Error: could not combine the summary tree "<<tree.first<<" in "<<final_path<<std::endl;
+          merged=false;
+        }
+      }
+    }
+
+    if (merged){
+      for (const auto& input : inputs) std::remove(input.c_str());
+    }
+    ok = ok && merged;
+  }
+
+  return ok;
+}
+
+// Fork num_shards workers that each run the ToolChain described by conffile
+// on their slice of the input, then merge their outputs
+template <typename RunToolChain>
+int run_shards(const std::string& conffile, size_t num_shards,
+  RunToolChain run_tool_chain){
+
+  std::string manifest_dir="./.annie_shards."+std::to_string(getpid());
+  if (mkdir(manifest_dir.c_str(), 0755)!=0 && errno!=EEXIST){
+    std::cerr<<"Error: could not create "<<manifest_dir<<std::endl;
+    return 1;
+  }
+
+  // Make sure buffered output is not written twice by the children
+  std::cout.flush();
+  std::cerr.flush();
+
+  std::vector<pid_t> workers;
+  for (size_t k=0; k<num_shards; k++){
+    pid_t pid=fork();
+    if (pid<0){
+      std::cerr<<"Error: could not start shard "<<k<<std::endl;
+      break;
+    }
+    if (pid==0){
+      Sharding::Configure(k, num_shards, manifest_dir);
+      run_tool_chain(conffile);
+      // The ToolChain does not return the status of its tools, so their
+      // failures are recorded by the Factory (see MonitoredTool.h)
+      std::exit(Sharding::failed() ? 1 : 0);
+    }
+    workers.push_back(pid);
+  }
+
+  bool ok = (workers.size()==num_shards);
+  for (size_t k=0; k<workers.size(); k++){
+    int status=0;
+    waitpid(workers.at(k), &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status)!=0){
+      std::cerr<<"Error: shard "<<k<<" did not finish successfully"<<std::endl;
+      ok=false;
+    }
+  }
+
+  if (!ok){
+    std::cerr<<"Shard outputs have not been merged (see "<<manifest_dir<<')'<<std::endl;
+    return 1;
+  }
+
+  if (!merge_shard_outputs(manifest_dir, num_shards)) return 1;
+
+  for (size_t k=0; k<num_shards; k++){
+    std::remove(Sharding::ManifestPath(manifest_dir,k).c_str());
+  }
+  rmdir(manifest_dir.c_str());
+
+  return 0;
+}
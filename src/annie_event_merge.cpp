@@ -0,0 +1,58 @@
+// annie-event-merge: concatenates multi-event ANNIEEvent BoostStore files
+// (e.g., the subrun outputs of a run) into a single file
+//
+// Usage: annie-event-merge [--allow-run-mismatch] [--skip-bad-files]
+//          <output file> <input file> [<input file> ...]
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ANNIEEventMerger.h"
+
+int main(int argc, char* argv[]){
+
+  bool require_same_run=true;
+  bool skip_bad_files=false;
+  std::vector<std::string> filenames;
+
+  for (int i=1; i<argc; i++){
+    std::string arg=argv[i];
+    if (arg=="--allow-run-mismatch") require_same_run=false;
+    else if (arg=="--skip-bad-files") skip_bad_files=true;
+    else filenames.push_back(arg);
+  }
+
+  if (filenames.size() < 2){
+    std::cerr<<"Usage: "<<argv[0]<<" [--allow-run-mismatch] [--skip-bad-files]"
+             <<" <output file> <input file> [<input file> ...]"<<std::endl;
+    return 1;
+  }
+
+  ANNIEEventMerger merger(filenames.front(), require_same_run);
+
+  int status=0;
+  for (size_t i=1; i<filenames.size(); i++){
+    std::cout<<"Merging "<<filenames.at(i)<<std::endl;
+    std::string error;
+    if (!merger.AddFile(filenames.at(i), error)){
+      // an input that was partly written can't be skipped
+      bool skip=skip_bad_files && !merger.incomplete();
+      std::cerr<<(skip ? "Warning: skipping input: " : "Error: ")
+               <<error<<std::endl;
+      if (!skip){
+        status=1;
+        break;
+      }
+    }
+  }
+
+  merger.Close();
+
+  std::cout<<"Wrote "<<merger.num_entries()<<" entries from "
+           <<merger.num_files()<<" input files to "<<filenames.front();
+  if (merger.has_run_number()) std::cout<<" (run "<<merger.run_number()<<')';
+  std::cout<<std::endl;
+
+  return status;
+}
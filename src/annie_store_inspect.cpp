@@ -0,0 +1,54 @@
+// annie-store-inspect: prints a table of per-key memory and serialized sizes
+// for a multi-event ANNIEEvent BoostStore file
+//
+// Usage: annie-store-inspect <file> [max_entries]
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "ANNIEconstants.h"
+#include "BoostStore.h"
+#include "StoreStats.h"
+
+int main(int argc, char* argv[]){
+
+  if (argc < 2){
+    std::cerr<<"Usage: "<<argv[0]<<" <ANNIEEvent file> [max_entries]"<<std::endl;
+    return 1;
+  }
+
+  std::string filename=argv[1];
+  long max_entries=-1;
+  if (argc > 2) max_entries=std::atol(argv[2]);
+
+  BoostStore annie_event(false, BOOST_STORE_MULTIEVENT_FORMAT);
+  if (!annie_event.Initialise(filename)){
+    std::cerr<<"Error: could not open "<<filename<<std::endl;
+    return 1;
+  }
+
+  long total_entries=0;
+  annie_event.Header->Get("TotalEntries", total_entries);
+  if (max_entries < 0 || max_entries > total_entries) max_entries=total_entries;
+
+  StoreStats header_stats;
+  measure_annie_event_header(*annie_event.Header, header_stats);
+
+  StoreStats entry_stats;
+  for (long entry=0; entry<max_entries; entry++){
+    annie_event.GetEntry(entry);
+    measure_annie_event(annie_event, entry_stats);
+  }
+
+  std::cout<<filename<<": "<<total_entries<<" entries, "<<max_entries
+           <<" inspected (sizes in bytes)"<<std::endl<<std::endl;
+  std::cout<<"Header"<<std::endl;
+  header_stats.Print(std::cout);
+  std::cout<<std::endl<<"Entries"<<std::endl;
+  entry_stats.Print(std::cout);
+
+  annie_event.Close();
+
+  return 0;
+}
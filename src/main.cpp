@@ -1,14 +1,72 @@
+#include <cstdlib>
+#include <iostream>
 #include <string>
 #include "ToolChain.h"
 #include "DummyTool.h"
+#include "AllocationTracker.h"
+#include "MemoryMonitor.h"
+#include "PerfCounters.h"
+#include "ThreadPool.h"
+#include "RandomStreams.h"
+#include "ToolProfiler.h"
+#include "Tracer.h"
+#include "ShardLauncher.h"
+#include "SubChainTools.h"
 
 int main(int argc, char* argv[]){
 
-  std::string conffile;
-  if (argc==1)conffile="configfiles/Dummy/ToolChainConfig";
-  else conffile=argv[1];
+  // Usage: Analyse [--shards N] [ToolChainConfig file]
+  std::string conffile="configfiles/Dummy/ToolChainConfig";
+  int num_shards=1;
+  for (int i=1; i<argc; i++){
+    std::string arg=argv[i];
+    if (arg=="--shards" && i+1<argc) num_shards=std::atoi(argv[++i]);
+    else conffile=arg;
+  }
+  if (num_shards<1){
+    std::cerr<<"Usage: "<<argv[0]<<" [--shards N] [ToolChainConfig file]"<<std::endl;
+    return 1;
+  }
+
+  // The ToolChain does not pass its configuration on to the DataModel, so
+  // size the shared thread pool before the tools are initialised
+  Store chain_config;
+  chain_config.Initialise(conffile);
+  int pool_size=1;
+  if (chain_config.Get("ThreadPoolSize",pool_size) && pool_size>=0) ThreadPool::SetDefaultSize(pool_size);
+  unsigned long long random_seed=0;
+  if (chain_config.Get("RandomSeed",random_seed)) RandomStreams::SetSeed(random_seed);
+  std::string tools_file;
+  if (chain_config.Get("Tools_File",tools_file)) set_main_tools_file(tools_file);
+  int tool_profile=0;
+  int tool_perf_counters=0;
+  std::string tool_profile_file;
+  chain_config.Get("ToolProfile",tool_profile);
+  chain_config.Get("ToolPerfCounters",tool_perf_counters);
+  chain_config.Get("ToolProfileFile",tool_profile_file);
+  // the counters and allocations (when built with ALLOCATION_TRACKING=1)
+  // are reported along with the timings
+  PerfCounters::Configure(tool_perf_counters!=0);
+  ToolProfiler::Shared().Configure(tool_profile!=0 || tool_perf_counters!=0 || AllocationTracker::enabled(), tool_profile_file);
+  int trace_buffer_size=0;
+  std::string trace_file;
+  chain_config.Get("TraceBufferSize",trace_buffer_size);
+  chain_config.Get("TraceFile",trace_file);
+  if (trace_buffer_size>0) Tracer::Configure(trace_buffer_size, trace_file);
+  int memory_monitor=0;
+  int memory_leak_window=100;
+  double memory_leak_threshold_mb=1.;
+  chain_config.Get("MemoryMonitor",memory_monitor);
+  chain_config.Get("MemoryLeakWindow",memory_leak_window);
+  chain_config.Get("MemoryLeakThresholdMB",memory_leak_threshold_mb);
+  MemoryMonitor::Configure(memory_monitor!=0, memory_leak_window, memory_leak_threshold_mb);
+
+  // Run N copies of the ToolChain on slices of the input, then merge
+  if (num_shards>1) return run_shards(conffile, num_shards,
+    [](const std::string& config){ ToolChain tools(config); Tracer::Flush(); });
 
   ToolChain tools(conffile);
+  Tracer::Flush();
 
   //DummyTool dummytool;    
 